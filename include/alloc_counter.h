@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+
+namespace haar {
+
+// 调试用的堆分配计数。以 HAAR_COUNT_ALLOCATIONS 构建时替换全局 operator new，
+// 并给 cv::Mat 装上计数的默认分配器（Mat 数据走 fastMalloc，不经过 operator new），
+// 统计当前线程的分配次数；未开启时恒为 0，没有任何开销
+bool allocationCountingEnabled();
+size_t threadAllocationCount();
+
+// 统计一段代码在当前线程上的分配次数
+class AllocationScope {
+public:
+    AllocationScope() : start_(threadAllocationCount()) {}
+    size_t count() const { return threadAllocationCount() - start_; }
+
+private:
+    size_t start_;
+};
+
+// 逐帧分配次数的汇总：前 warmupFrames 帧用于各缓冲长到稳态大小，不计入稳态
+struct AllocationStats {
+    size_t warmupFrames = 8;
+    size_t frames = 0;
+    size_t steadyFrames = 0;
+    size_t steadyFramesWithAllocations = 0;
+    size_t steadyAllocations = 0;
+    size_t maxPerFrame = 0;
+
+    void add(size_t allocations);
+    void print(const char* what) const;
+};
+
+}  // namespace haar
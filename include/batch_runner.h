@@ -0,0 +1,41 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace haar {
+
+class WorkStealingPool;
+
+// 一条序列的处理结果
+struct SequenceReport {
+    std::string name;      // 序列目录名，如 video_01
+    size_t frames = 0;     // 送入检测的帧数
+    size_t detected = 0;   // 有检测结果的帧数
+    double seconds = 0.0;  // 该序列从开始到结束的墙钟时间
+    size_t droppedBoxes = 0;  // 超出 BoxList 容量、没有输出也没有计入检出的框数
+    std::string error;     // 非空表示处理中抛了异常（读不了的目录、损坏的 .frames 等），计数作废
+};
+
+struct BatchReport {
+    std::vector<SequenceReport> sequences;  // 与输入目录同序
+    double wallSeconds = 0.0;
+    int threads = 0;
+};
+
+// 处理一条序列：在池的工作线程上调用，自行创建检测器、FrameSource / FrameSink 和跟踪状态，
+// 并把 pool 填进 PipelineOptions，让本序列的解码/编码可被其他核窃取
+using SequenceJob = std::function<SequenceReport(const std::string& folder, WorkStealingPool& pool)>;
+
+// 每条序列作为一个顶层任务提交到工作窃取池，全部完成后返回；threads <= 0 时取硬件并发数。
+// 某条序列的 job 抛出异常时只把该序列记为失败（SequenceReport::error），其余序列照常处理
+BatchReport runBatch(const std::vector<std::string>& folders, const SequenceJob& job, int threads = 0);
+
+// 逐序列与汇总的帧数、检测率、吞吐量，失败的序列单独列出并计数
+void printBatchReport(const BatchReport& report);
+
+// 序列名（目录名，或打包文件去掉扩展名），批处理时用作输出子目录
+std::string sequenceName(const std::string& folder);
+
+}  // namespace haar
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+#include "fast_kernels.h"
+
+namespace haar {
+
+struct BlobExtractorOptions {
+    int threshold = 80;    // 灰度 > threshold 为前景，同 threshold(THRESH_BINARY)
+    int closeSize = 5;     // 闭运算矩形结构元素的边长，奇数；1 表示不做闭运算
+    size_t maxBlobs = 1;   // 输出外接框最大的前 N 个连通域
+    bool runLength = FAST_KERNELS;  // false 时走原来的 threshold → morphologyEx → findContours
+};
+
+// 阈值分割 + 闭运算 + 连通域外接框，一趟逐行完成：每行先二值化成游程，闭运算（先膨胀后腐蚀，
+// 可分离成行内/跨行两步）全在游程上做，结果行直接做 8 邻接的游程连通域标记，不生成二值图和轮廓。
+// 输出与 threshold → morphologyEx(MORPH_CLOSE) → findContours(RETR_EXTERNAL) 后取外接框相同，
+// 面积相同时的先后也与 findContours 的输出顺序一致（起点在光栅顺序中靠后的在前），由 verify_blob_extractor 比对；
+// options.runLength 为 false（HAAR_FAST_KERNELS 关闭时的默认）时直接走 OpenCV 的这条流程。
+// 缓冲逐帧复用，同一个对象不能被多个线程同时使用
+class BlobExtractor {
+public:
+    explicit BlobExtractor(BlobExtractorOptions options = {});
+
+    // 按外接框面积从大到小返回前 maxBlobs 个连通域的外接框；gray 为 CV_8UC1。
+    // 返回的引用在下一次 extract 之前有效
+    const std::vector<cv::Rect>& extract(const cv::Mat& gray);
+
+private:
+    struct Run {
+        int begin, end;  // [begin, end)
+    };
+    using RunList = std::vector<Run>;
+
+    struct Component {
+        int x0, y0, x1, y1;  // 闭区间
+    };
+
+    const std::vector<cv::Rect>& extractOpenCV(const cv::Mat& gray);
+    void binarize(const uchar* row, int width, RunList& out) const;
+    void dilateRow(const RunList& runs, int width, RunList& out) const;
+    void erodeRow(const RunList& runs, int width, RunList& out) const;
+    void unionRows(int first, int last, RunList& out);
+    void intersectRows(int first, int last, RunList& out);
+    void labelRow(const RunList& runs, int y, int width, int height);
+    int find(int label);
+    void unite(int a, int b);
+    int findBackground(int label);
+    void uniteBackground(int a, int b);
+
+    BlobExtractorOptions options_;
+    int radius_;
+
+    std::vector<RunList> dilated_;  // 行内膨胀后的行，环形缓冲，2 * radius_ + 1 行
+    std::vector<RunList> eroded_;   // 膨胀完成后再做行内腐蚀的行，同上
+    RunList runs_, merged_, scratch_;
+    RunList prevRuns_;              // 上一行闭运算结果及其标号，用于连通
+    std::vector<int> prevLabels_, curLabels_;
+
+    std::vector<int> parent_;       // 游程的并查集，根总是集合里最小的标号，即光栅顺序最先出现的游程
+    std::vector<Component> components_;
+    std::vector<int> enclosing_;    // 前景游程左边紧挨着的背景游程标号，贴左边界时为 -1
+
+    // 背景按 4 邻接标记，只为判断连通域是否在别的连通域的洞里（RETR_EXTERNAL 不输出这些）
+    RunList bgRuns_, prevBgRuns_;
+    std::vector<int> prevBgLabels_, curBgLabels_;
+    std::vector<int> bgParent_;
+    std::vector<char> bgOuter_;     // 背景连通域是否碰到图像边界
+    std::vector<int> roots_;
+    std::vector<cv::Rect> blobs_;
+
+    // extractOpenCV 的缓冲
+    cv::Mat binary_, closeKernel_;
+    std::vector<std::vector<cv::Point>> contours_;
+};
+
+}  // namespace haar
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace haar {
+
+// 有界阻塞队列：满时 push 阻塞，空时 pop 阻塞；close() 后唤醒所有等待者
+// 元素存放在定长环形槽位里，稳态下入队出队不做堆分配
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : slots_(capacity > 0 ? capacity : 1) {}
+
+    // 队列已关闭时返回 false
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notFull_.wait(lock, [&] { return closed_ || count_ < slots_.size(); });
+        if (closed_) return false;
+        slots_[(head_ + count_) % slots_.size()] = std::move(item);
+        ++count_;
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    // 队列关闭且取空后返回 false
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notEmpty_.wait(lock, [&] { return closed_ || count_ > 0; });
+        if (count_ == 0) return false;
+        std::optional<T>& slot = slots_[head_];
+        item = std::move(*slot);
+        slot.reset();
+        head_ = (head_ + 1) % slots_.size();
+        --count_;
+        notFull_.notify_one();
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        notFull_.notify_all();
+        notEmpty_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable notFull_;
+    std::condition_variable notEmpty_;
+    std::vector<std::optional<T>> slots_;
+    size_t head_ = 0;
+    size_t count_ = 0;
+    bool closed_ = false;
+};
+
+// 按序号重排的有界队列：多个生产者乱序 push(index, item)，单个消费者按 0,1,2... 顺序 pop
+// 生产者只能领先消费者 capacity 个序号，超出则阻塞
+template <typename T>
+class OrderedQueue {
+public:
+    explicit OrderedQueue(size_t capacity) : slots_(capacity > 0 ? capacity : 1) {}
+
+    bool push(size_t index, T item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        changed_.wait(lock, [&] { return closed_ || index < head_ + slots_.size(); });
+        if (closed_) return false;
+        slots_[index % slots_.size()] = std::move(item);
+        changed_.notify_all();
+        return true;
+    }
+
+    // 取出序号 head 的元素；关闭后返回 false
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        std::optional<T>& slot = slots_[head_ % slots_.size()];
+        changed_.wait(lock, [&] { return closed_ || slot.has_value(); });
+        if (!slot.has_value()) return false;
+        item = std::move(*slot);
+        slot.reset();
+        ++head_;
+        changed_.notify_all();
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        changed_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::vector<std::optional<T>> slots_;
+    size_t head_ = 0;
+    bool closed_ = false;
+};
+
+// 只保留最新 capacity 个元素的队列：满时 push 挤掉最旧的一个（计入 dropped()），生产者从不阻塞；
+// 空时 pop 阻塞，close() 后仍可取完剩余元素。用于实时输入，处理跟不上时丢旧帧而不是越积越多
+template <typename T>
+class LatestQueue {
+public:
+    explicit LatestQueue(size_t capacity) : slots_(capacity > 0 ? capacity : 1) {}
+
+    // 队列已关闭时返回 false
+    bool push(T item) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closed_) return false;
+        if (count_ == slots_.size()) {
+            slots_[head_].reset();
+            head_ = (head_ + 1) % slots_.size();
+            --count_;
+            ++dropped_;
+        }
+        slots_[(head_ + count_) % slots_.size()] = std::move(item);
+        ++count_;
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    // 队列关闭且取空后返回 false
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notEmpty_.wait(lock, [&] { return closed_ || count_ > 0; });
+        if (count_ == 0) return false;
+        std::optional<T>& slot = slots_[head_];
+        item = std::move(*slot);
+        slot.reset();
+        head_ = (head_ + 1) % slots_.size();
+        --count_;
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        notEmpty_.notify_all();
+    }
+
+    size_t dropped() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return dropped_;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::condition_variable notEmpty_;
+    std::vector<std::optional<T>> slots_;
+    size_t head_ = 0;
+    size_t count_ = 0;
+    size_t dropped_ = 0;
+    bool closed_ = false;
+};
+
+}  // namespace haar
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace haar {
+
+// 一个缩放层的积分图：sum 为像素和，sqsum 为平方和（与 OpenCV 一样按 32 位回绕存储）
+// 两者行宽相同，size 为 (w+1, h+1)；缓冲区末尾需多留一行，SIMD 成批读取会越过最后一个窗口
+struct IntegralLayer {
+    const int* sum = nullptr;
+    const int* sqsum = nullptr;
+    int step = 0;  // 以 int 计
+    cv::Size size;
+};
+
+// 由 haar_codegen 从级联 XML 生成、特征与阈值均为编译期常量的评估器
+class CompiledCascade {
+public:
+    virtual ~CompiledCascade() = default;
+
+    virtual cv::Size windowSize() const = 0;
+    virtual const char* backend() const = 0;
+
+    // 扫描 y = yBegin, yBegin + yStep, ... < yEnd，x = 0, yStep, ... < size.width - 窗口宽 的窗口，
+    // 第 0 级被拒绝时跳过下一个窗口（与 OpenCV 一致），按 (y, x) 顺序追加通过的窗口左上角。
+    // yBegin 须为 yStep 的倍数；行与行之间互不依赖，一层可以按行切开分几次（或并行）扫描
+    virtual void scanLayer(const IntegralLayer& layer, int yStep, int yBegin, int yEnd,
+                           std::vector<cv::Point>& hits) const = 0;
+};
+
+// 编译进来的全部级联合成的一个评估器：同一层积分图一趟扫完所有级联，每批窗口上级联之间相同的特征只算一次，
+// 各级联的命中与各自单独扫描时相同。级联顺序同生成头文件里的 HAAR_FOR_EACH_COMPILED_CASCADE
+class CompiledEnsemble {
+public:
+    virtual ~CompiledEnsemble() = default;
+
+    virtual int size() const = 0;
+    virtual cv::Size windowSize(int cascade) const = 0;
+    virtual const char* backend() const = 0;
+    virtual int sharedFeatures() const = 0;  // 跨级联去重后共用缓存的特征数
+
+    // yEnds[c] 含义同 CompiledCascade::scanLayer 的 yEnd，<= 0 的级联本层不扫描；
+    // 级联 c 的命中按 (y, x) 顺序追加到 hits[c]。yEnds 与 hits 都有 size() 个元素
+    virtual void scanLayer(const IntegralLayer& layer, int yStep, const int* yEnds,
+                           std::vector<cv::Point>* hits) const = 0;
+};
+
+// 按文件名查找编译进来的模型，并按当前 CPU 选择 AVX2 / NEON / 标量实现；
+// 文件内容与编译时不一致或该级联未被编译时返回空
+std::shared_ptr<const CompiledCascade> loadCompiledCascade(const std::string& path);
+
+// 全部编译进来的级联合成的评估器，后端选择同 loadCompiledCascade；一个级联也没编译时返回空
+std::shared_ptr<const CompiledEnsemble> loadCompiledEnsemble();
+
+// path 对应级联在 CompiledEnsemble 中的下标；未编译或文件内容与编译时不一致时返回 -1
+int compiledEnsembleIndex(const std::string& path);
+
+}  // namespace haar
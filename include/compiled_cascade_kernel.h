@@ -0,0 +1,303 @@
+#pragma once
+
+// 编译期展开的 Haar 级联评估核，只被 compiled_cascade_*.cpp 包含
+//
+// Model 由 haar_codegen 生成（见 compiled_cascade_model.h），V 为向量后端，一次评估 V::kLanes 个
+// 相邻窗口。为了与 OpenCV 的 CascadeClassifier 逐位一致，各步的数值类型严格照搬
+// cascadedetect.cpp：特征值 float，方差归一化与级内累加 double，阈值比较在 double 上进行。
+// 包含本文件的源文件必须以 -ffp-contract=off 编译，避免乘加被融合成 FMA 改变舍入。
+
+#include "compiled_cascade.h"
+#include "compiled_cascade_model.h"
+
+#include <algorithm>
+#include <array>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace haar {
+
+// 单个级联不共享特征，特征总是现算
+struct NoFeatureCache {
+    static constexpr bool kEnabled = false;
+};
+
+// 级联之间共享的特征值：haar_codegen 给在多个级联（或同一级联的多个下标）中出现的特征分配槽位，
+// 同一批窗口上每个槽位只算一次。缓存的是乘方差归一化因子之前的值，各级联的归一化区域不同
+template <class V, int Slots>
+struct SharedFeatureCache {
+    static constexpr bool kEnabled = Slots > 0;
+    static constexpr int kSize = Slots > 0 ? Slots : 1;
+
+    // 换一批窗口：旧值随之失效，计数回绕时清零重来
+    void nextBatch() {
+        if (++batch == 0) {
+            std::fill(stamp, stamp + kSize, 0u);
+            batch = 1;
+        }
+    }
+
+    typename V::F values[kSize];
+    unsigned stamp[kSize] = {};  // 与 batch 相等的槽位是本批已算好的
+    unsigned batch = 0;
+};
+
+// 批量评估不受跳窗影响，这里按 OpenCV 的顺序补上跳窗规则，被跳过的窗口结果直接丢弃
+template <int Stride>
+void collectHaarHits(const signed char* codes, int nx, int y, std::vector<cv::Point>& hits) {
+    for (int i = 0; i < nx; ++i) {
+        if (codes[i] > 0) {
+            hits.emplace_back(i * Stride, y);
+        } else if (codes[i] == 0) {
+            ++i;
+        }
+    }
+}
+
+// 一个模型的逐批评估，CompiledHaarCascade 与 CompiledHaarEnsemble 共用
+template <class Model, class V>
+struct HaarCascadeEval {
+    using I = typename V::I;
+    using F = typename V::F;
+    using M = typename V::M;
+    using Acc = typename V::Acc;
+
+    // 各矩形四个角相对窗口左上角的偏移，随积分图行宽变化
+    struct Offsets {
+        int rect[Model::kNumFeatures][3][4];
+        int norm[4];
+    };
+
+    static void corners(const HaarRectDef& r, int step, int* o) {
+        o[0] = r.y * step + r.x;
+        o[1] = r.y * step + r.x + r.width;
+        o[2] = (r.y + r.height) * step + r.x;
+        o[3] = (r.y + r.height) * step + r.x + r.width;
+    }
+
+    static Offsets makeOffsets(int step) {
+        Offsets ofs{};
+        for (int f = 0; f < Model::kNumFeatures; ++f) {
+            for (int r = 0; r < 3; ++r) {
+                corners(Model::kFeatures[f].rects[r], step, ofs.rect[f][r]);
+            }
+        }
+        // 方差归一化区域与 OpenCV 相同：窗口四周各缩进 1 像素
+        corners(HaarRectDef{1, 1, Model::kWidth - 2, Model::kHeight - 2, 0.f}, step, ofs.norm);
+        return ofs;
+    }
+
+    template <int Stride>
+    static I rectSum(const int* p, const int* o) {
+        const I a = V::template load<Stride>(p + o[0]);
+        const I b = V::template load<Stride>(p + o[1]);
+        const I c = V::template load<Stride>(p + o[2]);
+        const I d = V::template load<Stride>(p + o[3]);
+        return V::add(V::sub(V::sub(a, b), c), d);
+    }
+
+    template <int Stride, int Feature>
+    static F rawFeature(const int* p, const Offsets& ofs) {
+        constexpr HaarFeatureDef f = Model::kFeatures[Feature];
+        F ret = V::add(V::mul(V::set(f.rects[0].weight), V::toFloat(rectSum<Stride>(p, ofs.rect[Feature][0]))),
+                       V::mul(V::set(f.rects[1].weight), V::toFloat(rectSum<Stride>(p, ofs.rect[Feature][1]))));
+        if constexpr (f.rects[2].weight != 0.0f) {
+            ret = V::add(ret, V::mul(V::set(f.rects[2].weight),
+                                     V::toFloat(rectSum<Stride>(p, ofs.rect[Feature][2]))));
+        }
+        return ret;
+    }
+
+    template <int Stride, int Feature, class Cache>
+    static F feature(const int* p, const Offsets& ofs, Cache& cache) {
+        constexpr int slot = Model::kFeatureSlots[Feature];
+        if constexpr (Cache::kEnabled && slot >= 0) {
+            if (cache.stamp[slot] == cache.batch) return cache.values[slot];
+            const F value = rawFeature<Stride, Feature>(p, ofs);
+            cache.values[slot] = value;
+            cache.stamp[slot] = cache.batch;
+            return value;
+        } else {
+            (void)cache;
+            return rawFeature<Stride, Feature>(p, ofs);
+        }
+    }
+
+    template <int Stride, int Stump, class Cache>
+    static void stump(const int* p, const Offsets& ofs, Cache& cache, F factor, Acc& acc) {
+        constexpr HaarStumpDef s = Model::kStumps[Stump];
+        const F value = V::mul(feature<Stride, s.feature>(p, ofs, cache), factor);
+        acc = V::accAdd(acc, V::lt(value, V::set(s.threshold)), s.left, s.right);
+    }
+
+    template <int Stride, int First, class Cache, size_t... J>
+    static Acc stageSum(const int* p, const Offsets& ofs, Cache& cache, F factor, std::index_sequence<J...>) {
+        Acc acc = V::accZero();
+        (stump<Stride, First + static_cast<int>(J)>(p, ofs, cache, factor, acc), ...);
+        return acc;
+    }
+
+    // 返回是否还有窗口存活；第 0 级被拒绝的窗口记入 rejected0
+    template <int Stride, int Stage, class Cache>
+    static bool stage(const int* p, const Offsets& ofs, Cache& cache, F factor, M& alive, M& rejected0) {
+        constexpr HaarStageDef st = Model::kStages[Stage];
+        const Acc acc = stageSum<Stride, st.firstStump>(p, ofs, cache, factor,
+                                                        std::make_index_sequence<st.numStumps>{});
+        const M pass = V::accNotLess(acc, st.threshold);
+        if constexpr (Stage == 0) rejected0 = V::andNot(alive, pass);
+        alive = V::and_(alive, pass);
+        return V::any(alive);
+    }
+
+    template <int Stride, class Cache, size_t... S>
+    static void stages(const int* p, const Offsets& ofs, Cache& cache, F factor, M& alive, M& rejected0,
+                       std::index_sequence<S...>) {
+        (stage<Stride, static_cast<int>(S)>(p, ofs, cache, factor, alive, rejected0) && ...);
+    }
+
+    // 评估一批窗口，结果码与 OpenCV runAt 的符号一致：1 通过，0 第 0 级拒绝，-1 其他
+    template <int Stride, class Cache>
+    static void evalBatch(const int* s, const int* q, const Offsets& ofs, Cache& cache, signed char* out) {
+        constexpr double area = double(Model::kWidth - 2) * double(Model::kHeight - 2);
+        F factor;
+        M alive = V::normalize(rectSum<Stride>(s, ofs.norm), rectSum<Stride>(q, ofs.norm), area, factor);
+        M rejected0 = V::zero();
+        if (V::any(alive)) {
+            stages<Stride>(s, ofs, cache, factor, alive, rejected0,
+                           std::make_index_sequence<Model::kNumStages>{});
+        }
+        const int a = V::bits(alive);
+        const int r = V::bits(rejected0);
+        for (int k = 0; k < V::kLanes; ++k) {
+            out[k] = ((a >> k) & 1) ? 1 : (((r >> k) & 1) ? 0 : -1);
+        }
+    }
+};
+
+template <class Model, class V>
+class CompiledHaarCascade : public CompiledCascade {
+public:
+    cv::Size windowSize() const override { return cv::Size(Model::kWidth, Model::kHeight); }
+    const char* backend() const override { return V::kName; }
+
+    void scanLayer(const IntegralLayer& layer, int yStep, int yBegin, int yEnd,
+                   std::vector<cv::Point>& hits) const override {
+        // OpenCV 的步长只有 1（缩放倍数 >= 2）和 2 两种
+        CV_Assert(yBegin >= 0 && yBegin % yStep == 0);
+        if (yStep == 1) {
+            scan<1>(layer, yBegin, yEnd, hits);
+        } else {
+            CV_Assert(yStep == 2);
+            scan<2>(layer, yBegin, yEnd, hits);
+        }
+    }
+
+private:
+    using Eval = HaarCascadeEval<Model, V>;
+
+    template <int Stride>
+    void scan(const IntegralLayer& layer, int yBegin, int yEnd, std::vector<cv::Point>& hits) const {
+        const int width = layer.size.width - Model::kWidth;
+        yEnd = std::min(yEnd, layer.size.height - Model::kHeight);
+        if (width <= 0 || yEnd <= yBegin) return;
+
+        const typename Eval::Offsets ofs = Eval::makeOffsets(layer.step);
+        const int nx = (width + Stride - 1) / Stride;
+        // 模型对象在线程间共享，结果码缓冲按线程复用
+        thread_local std::vector<signed char> codes;
+        codes.resize(nx + V::kLanes);
+        NoFeatureCache cache;
+
+        for (int y = yBegin; y < yEnd; y += Stride) {
+            const int* srow = layer.sum + static_cast<size_t>(y) * layer.step;
+            const int* qrow = layer.sqsum + static_cast<size_t>(y) * layer.step;
+            for (int i = 0; i < nx; i += V::kLanes) {
+                Eval::template evalBatch<Stride>(srow + i * Stride, qrow + i * Stride, ofs, cache, &codes[i]);
+            }
+            collectHaarHits<Stride>(codes.data(), nx, y, hits);
+        }
+    }
+};
+
+// 多个级联在同一层积分图上一起扫描：每批窗口依次交给各级联评估，共享槽位的特征只算一次；
+// 各级联的窗口范围、结果码和跳窗规则仍各自独立，命中与逐个 CompiledHaarCascade 扫描相同
+template <class V, int Slots, class... Models>
+class CompiledHaarEnsemble : public CompiledEnsemble {
+public:
+    static constexpr int kCount = static_cast<int>(sizeof...(Models));
+
+    int size() const override { return kCount; }
+    cv::Size windowSize(int cascade) const override {
+        const std::array<cv::Size, kCount> sizes{{cv::Size(Models::kWidth, Models::kHeight)...}};
+        return sizes[cascade];
+    }
+    const char* backend() const override { return V::kName; }
+    int sharedFeatures() const override { return Slots; }
+
+    void scanLayer(const IntegralLayer& layer, int yStep, const int* yEnds,
+                   std::vector<cv::Point>* hits) const override {
+        if (yStep == 1) {
+            scan<1>(layer, yEnds, hits, std::index_sequence_for<Models...>{});
+        } else {
+            CV_Assert(yStep == 2);
+            scan<2>(layer, yEnds, hits, std::index_sequence_for<Models...>{});
+        }
+    }
+
+private:
+    using Cache = SharedFeatureCache<V, Slots>;
+
+    template <int Stride, size_t... C>
+    void scan(const IntegralLayer& layer, const int* yEnds, std::vector<cv::Point>* hits,
+              std::index_sequence<C...>) const {
+        const std::array<int, kCount> width{{(layer.size.width - Models::kWidth)...}};
+        const std::array<int, kCount> heightLimit{{(layer.size.height - Models::kHeight)...}};
+        std::array<int, kCount> nx{}, yEnd{};
+        int maxNx = 0, maxY = 0;
+        for (int c = 0; c < kCount; ++c) {
+            yEnd[c] = std::min(yEnds[c], heightLimit[c]);
+            if (width[c] <= 0 || yEnd[c] <= 0) yEnd[c] = 0;
+            nx[c] = yEnd[c] > 0 ? (width[c] + Stride - 1) / Stride : 0;
+            maxNx = std::max(maxNx, nx[c]);
+            maxY = std::max(maxY, yEnd[c]);
+        }
+        if (maxY == 0) return;
+
+        const std::tuple<typename HaarCascadeEval<Models, V>::Offsets...> ofs{
+            HaarCascadeEval<Models, V>::makeOffsets(layer.step)...};
+        // 每个级联一行结果码
+        const size_t row = static_cast<size_t>(maxNx) + V::kLanes;
+        thread_local std::vector<signed char> codes;
+        thread_local Cache cache;
+        codes.resize(row * kCount);
+
+        for (int y = 0; y < maxY; y += Stride) {
+            const int* srow = layer.sum + static_cast<size_t>(y) * layer.step;
+            const int* qrow = layer.sqsum + static_cast<size_t>(y) * layer.step;
+            for (int i = 0; i < maxNx; i += V::kLanes) {
+                cache.nextBatch();
+                const int* s = srow + i * Stride;
+                const int* q = qrow + i * Stride;
+                ((y < yEnd[C] && i < nx[C]
+                      ? HaarCascadeEval<Models, V>::template evalBatch<Stride>(
+                            s, q, std::get<C>(ofs), cache, &codes[C * row + i])
+                      : void()),
+                 ...);
+            }
+            for (int c = 0; c < kCount; ++c) {
+                if (y >= yEnd[c]) continue;
+                collectHaarHits<Stride>(&codes[c * row], nx[c], y, hits[c]);
+            }
+        }
+    }
+};
+
+std::shared_ptr<const CompiledCascade> makeScalarCompiledCascade(const std::string& fileName);
+std::shared_ptr<const CompiledCascade> makeAvx2CompiledCascade(const std::string& fileName);
+std::shared_ptr<const CompiledCascade> makeNeonCompiledCascade(const std::string& fileName);
+std::shared_ptr<const CompiledEnsemble> makeScalarCompiledEnsemble();
+std::shared_ptr<const CompiledEnsemble> makeAvx2CompiledEnsemble();
+std::shared_ptr<const CompiledEnsemble> makeNeonCompiledEnsemble();
+
+}  // namespace haar
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// haar_codegen 生成的级联模型所用的常量结构，只依赖标准库，代码生成工具和运行时共用
+namespace haar {
+
+struct HaarRectDef {
+    int x, y, width, height;
+    float weight;
+};
+
+// BASIC/CORE 特征最多 3 个矩形，未用到的矩形权重为 0
+struct HaarFeatureDef {
+    int numRects;
+    HaarRectDef rects[3];
+};
+
+// 深度为 1 的弱分类器：value < threshold 取 left，否则取 right
+struct HaarStumpDef {
+    int feature;
+    float threshold;
+    float left;
+    float right;
+};
+
+// threshold 已按 OpenCV 的做法减去 1e-5f
+struct HaarStageDef {
+    int firstStump;
+    int numStumps;
+    float threshold;
+};
+
+// 级联 XML 内容的 FNV-1a 哈希，运行时用来确认磁盘上的文件与编译进来的模型一致
+inline uint64_t fnv1a64(const char* data, size_t size) {
+    uint64_t h = 1469598103934665603ull;
+    for (size_t i = 0; i < size; ++i) {
+        h ^= static_cast<unsigned char>(data[i]);
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+}  // namespace haar
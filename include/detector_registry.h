@@ -0,0 +1,44 @@
+#pragma once
+
+#include "batch_runner.h"
+#include "detector_session.h"
+#include "frame_pipeline.h"
+#include "tunables.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace haar {
+
+// 读入检测器模型；assetRoot 为级联 XML、模板和自带序列所在的目录。失败时返回空并在 error 里说明原因
+using ModelLoader = std::unique_ptr<DetectorModel> (*)(const std::string& assetRoot, const Tunables& tunables,
+                                                       std::string& error);
+
+struct RegisteredDetector {
+    std::string name;             // 与可执行文件同名
+    ModelLoader load;
+    std::string imageSuffix;      // 标注图的文件名：源文件名 stem + 后缀；为空沿用源文件名
+    std::string defaultSequence;  // 不带序列参数时处理的序列，相对 assetRoot
+    std::string outputFolder;     // 输出目录，相对 assetRoot；批处理时各序列写到其下的 <序列名>
+    std::string previewWindow;    // 单序列运行时的预览窗口标题；为空不预览
+};
+
+// 全部检测器；各检测器源文件各自定义一个返回自己登记项的函数，这里显式列出（静态库里靠静态对象自动登记会被链接器丢掉）
+const std::vector<RegisteredDetector>& registeredDetectors();
+const RegisteredDetector* findDetector(const std::string& name);
+
+// 级联、模板和自带序列所在的目录：环境变量 HAAR_ASSETS，没有时为 ".."（即在 build 目录下运行）
+std::string defaultAssetRoot();
+std::string assetPath(const std::string& assetRoot, const std::string& relative);
+
+// 用已加载的模型处理一条序列：会话、FrameSource / FrameSink 只属于这条序列；批处理时关掉逐帧日志
+SequenceReport runSequence(const DetectorModel& model, const RegisteredDetector& detector, const std::string& folder,
+                           const std::string& outputFolder, const PipelineOptions& options, bool logFrames);
+
+// 检测器可执行文件的 main：模型只加载一次。不带序列参数时处理 defaultSequence；带序列参数时把每个参数当作
+// 一条序列并行批处理，结果写到 outputFolder/<序列名>。除输出与调参参数（见 result_sinks.h）外还认
+// --assets DIR（覆盖 defaultAssetRoot()）。任何一条序列抛异常或一帧也没处理时返回 1
+int detectorMain(const std::string& name, int argc, char** argv);
+
+}  // namespace haar
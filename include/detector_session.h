@@ -0,0 +1,51 @@
+#pragma once
+
+#include "frame_pipeline.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace haar {
+
+class LatencyRecorder;
+class WorkStealingPool;
+
+// 会话运行的环境
+struct SessionContext {
+    LatencyRecorder* latency = nullptr;  // 各阶段计时（见 latency_stats.h）
+    WorkStealingPool* pool = nullptr;    // 窗口并行用的池；为空时用 cv::parallel_for_
+    bool logFrames = false;              // 逐帧打印检测结果
+    std::string outputFolder;            // 会话自己的附带输出（如模板检测的逐帧用时日志）；为空不写
+};
+
+// 一路视频的检测状态：跟踪状态和逐帧复用的缓冲都属于会话，帧须按时间顺序送进 process()。
+// 同一个会话不能被多个线程同时使用，不同会话可以在不同线程上并发
+class DetectorSession {
+public:
+    virtual ~DetectorSession() = default;
+
+    virtual FrameResult process(const Frame& frame) = 0;
+    // 序列结束：logFrames 时打印汇总等
+    virtual void finish() {}
+    // 需要的 Frame::reduced 缩小倍数（同 PipelineOptions::reduceBy），1 为不需要
+    virtual int reduceBy() const { return 1; }
+
+    size_t detected() const { return detected_; }  // 有检出的帧数
+
+protected:
+    size_t detected_ = 0;
+};
+
+// 检测器的模型：级联、模板与可调参数在加载时读入一次，之后只读；createSession 可以在任意线程上并发调用，
+// 各会话共用模型里的级联和模板（见 HaarDetector::loadFrom）。会话引用模型，模型须比它创建的会话活得久
+class DetectorModel {
+public:
+    virtual ~DetectorModel() = default;
+
+    virtual std::unique_ptr<DetectorSession> createSession(const SessionContext& context) const = 0;
+    // 加载后给用户看的一行说明（编译状态、检测尺度等）；为空不打印
+    virtual std::string describe() const { return ""; }
+};
+
+}  // namespace haar
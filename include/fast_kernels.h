@@ -0,0 +1,17 @@
+#pragma once
+
+namespace haar {
+
+// 声称与 OpenCV 逐一相同的快速实现是否默认代替对应的 OpenCV 调用（CMake 选项 HAAR_FAST_KERNELS）：
+//   编译后的级联（HaarDetector / HaarEnsemble） ↔ CascadeClassifier，由 verify_compiled_cascade 比对
+//   ROI 内融合模糊 + Sobel 的方形检测（SquareDetector） ↔ 整帧 GaussianBlur → Canny，由 verify_square_detector 比对
+//   游程连通域提取（BlobExtractor） ↔ threshold → morphologyEx → findContours，由 verify_blob_extractor 比对
+// 打开前须在同一构建上用 img/video_0* 跑通对应的 verify_* 工具；关掉时检测器走 OpenCV，
+// verify_* 仍然显式选用快速实现与 OpenCV 比对
+#ifdef HAAR_FAST_KERNELS
+constexpr bool FAST_KERNELS = true;
+#else
+constexpr bool FAST_KERNELS = false;
+#endif
+
+}  // namespace haar
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <array>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "tunables.h"
+
+namespace haar {
+
+class LatencyRecorder;
+class WorkStealingPool;
+
+// 一帧输入：index 为在序列中的帧号（读取失败的帧也占号），image 为 8 位灰度图
+struct Frame {
+    size_t index = 0;
+    std::string path;
+    cv::Mat image;
+    cv::Mat reduced;      // PipelineOptions::reduceBy > 1 时，image 缩小 reduceBy 倍（INTER_AREA），由解码线程生成
+    double decodeMs = 0;  // 由流水线填写
+    std::chrono::steady_clock::time_point captured;  // 实时输入的采集时刻，由采集线程填写（见 live_source.h）
+};
+
+// 需要画到输出图上的框；score 和 label 只写进标注文件（label 须为字符串常量）
+struct BoxAnnotation {
+    cv::Rect box;
+    cv::Scalar color;
+    int thickness = 2;
+    double score = 0;
+    const char* label = "target";
+};
+
+// 一帧的标注框：定长、存放在对象内部，检测回调里 push_back 不做堆分配。超出容量的框存不下，
+// 只记在 dropped() 里；runSequence 把它累加进 SequenceReport::droppedBoxes 并报警，输出和检出统计因此不全时看得出来
+class BoxList {
+public:
+    static constexpr size_t kCapacity = 32;
+
+    void push_back(const BoxAnnotation& box) {
+        if (size_ < kCapacity) {
+            items_[size_++] = box;
+        } else {
+            ++dropped_;
+        }
+    }
+    void clear() {
+        size_ = 0;
+        dropped_ = 0;
+    }
+
+    size_t size() const { return size_; }
+    size_t dropped() const { return dropped_; }  // 超出容量没存下的框数
+    bool empty() const { return size_ == 0; }
+    const BoxAnnotation& operator[](size_t i) const { return items_[i]; }
+    const BoxAnnotation* begin() const { return items_.data(); }
+    const BoxAnnotation* end() const { return items_.data() + size_; }
+
+private:
+    std::array<BoxAnnotation, kCapacity> items_;
+    size_t size_ = 0;
+    size_t dropped_ = 0;
+};
+
+// 检测阶段的结果，由输出阶段负责绘制和编码
+struct FrameResult {
+    BoxList boxes;
+    bool colorOutput = true;  // true: 转 BGR 后绘制；false: 直接画在灰度图上
+    cv::Rect searchRegion;    // 本帧实际搜索的区域；为空或等于整帧时标注为整帧检测
+
+    // 以下由流水线填写
+    size_t sequence = 0;      // 送进输出阶段的次序，跳过的帧不占号；按帧序输出的 sink 据此重排
+    double detectMs = 0;      // 检测回调耗时
+};
+
+// 帧来源：load() 会被多个解码线程并发调用
+class FrameSource {
+public:
+    virtual ~FrameSource() = default;
+    virtual size_t size() const = 0;
+    virtual bool load(size_t index, Frame& frame) const = 0;
+
+    // 实时来源（见 live_source.h）为 true：帧数事先不知道，流水线不按帧号解码，改用 next() 逐帧取
+    virtual bool live() const { return false; }
+    // 实时来源：阻塞到有新帧，输入结束时返回 false；处理跟不上时期间的旧帧已被丢掉（帧号不连续）
+    virtual bool next(Frame& frame) const {
+        (void)frame;
+        return false;
+    }
+};
+
+// 按文件名排序的图片目录
+class ImageFolderSource : public FrameSource {
+public:
+    explicit ImageFolderSource(const std::string& folder);
+
+    size_t size() const override { return paths_.size(); }
+    bool load(size_t index, Frame& frame) const override;
+
+private:
+    std::vector<std::string> paths_;
+};
+
+// 结果输出：consume() 会被多个编码线程并发调用，调用顺序不保证与帧序一致。
+// 除 ImageWriterSink 外的实现见 result_sinks.h
+class FrameSink {
+public:
+    virtual ~FrameSink() = default;
+    virtual void consume(const Frame& frame, const FrameResult& result) = 0;
+};
+
+// 绘制标注并写出 JPEG：文件名为 源文件名(stem) + suffix，suffix 为空时沿用源文件名
+class ImageWriterSink : public FrameSink {
+public:
+    ImageWriterSink(const std::string& outputFolder, const std::string& suffix);
+
+    void consume(const Frame& frame, const FrameResult& result) override;
+
+private:
+    std::string outputFolder_;
+    std::string suffix_;
+};
+
+// 输出阶段写哪些东西，运行时用 --sink 选择（见 result_sinks.h 的 makeSink / parseOutputFlag）
+struct OutputOptions {
+    bool images = true;       // 每帧一张标注 JPEG
+    bool video = false;       // 标注帧按帧序写进一个视频文件
+    bool csv = false;         // 每个框一行的 CSV 标注
+    bool jsonLines = false;   // 每帧一行的 JSON 标注
+    double videoFps = 25.0;
+};
+
+// 实时输入（--live 等，见 result_sinks.h 的 parseOutputFlag）：序列参数改为 cv::VideoCapture 能打开的
+// 视频文件、命名管道、URL 或设备号，由采集线程读取，检测始终取最新的帧
+struct LiveSourceOptions {
+    bool enabled = false;
+    double replayFps = 0;     // 视频文件按该帧率回放，模拟相机；0 取文件自身的帧率。设备和管道由输入自己定速
+    size_t bufferFrames = 1;  // 采集与检测之间最多积压的帧数，满时丢掉最旧的
+    size_t maxFrames = 0;     // 采集这么多帧后结束；0 为直到输入结束
+};
+
+struct PipelineOptions {
+    size_t queueDepth = 8;    // 解码预取 / 待编码的最大帧数
+    int decodeThreads = 2;
+    int encodeThreads = 2;
+    std::string previewWindow;  // 非空时在检测线程上 imshow 预览
+    int previewEvery = 1;       // 每 N 帧预览一次（imshow + waitKey 至少阻塞 1 ms）；0 不预览
+    OutputOptions output;       // 由各检测器交给 makeSink
+    // 非空时解码和编码作为细粒度任务提交到该池，不再单独起线程（批处理模式下多条序列共用）；
+    // 此时 decodeThreads / encodeThreads 不起作用，run() 须在池的工作线程上调用
+    WorkStealingPool* pool = nullptr;
+    // 非空时记录解码、编码耗时；检测器也用它标注回调内的各阶段（见 latency_stats.h）
+    LatencyRecorder* latency = nullptr;
+    // 大于 1 时解码线程顺带生成缩小 reduceBy 倍的 Frame::reduced，检测线程不用再缩（见 reduced_detection.h）
+    int reduceBy = 1;
+    // 检测器的可调参数（--set / --config，见 tunables.h）
+    Tunables tunables;
+    // 非空时 makeSink 把每帧结果也交给它（不归流水线所有，须比流水线活得久），如 haar_sweep 据此统计检出
+    FrameSink* observer = nullptr;
+    // 实时输入，由 openFrameSource 据此打开 LiveSource
+    LiveSourceOptions live;
+};
+
+// 解码 -> 检测 -> 输出 三级流水线
+// 解码和编码在工作线程上进行；检测回调始终在调用 run() 的线程上按帧序执行，
+// 因此跟踪状态（上一帧中心、卡尔曼滤波器等）可以直接放在回调里。
+// 实时来源由采集线程代替解码线程，检测每次取最新的一帧，跟不上时丢帧，结束时打印丢帧数与采集到出结果的延迟
+class FramePipeline {
+public:
+    using DetectFn = std::function<FrameResult(const Frame&)>;
+
+    FramePipeline(const FrameSource& source, FrameSink& sink, PipelineOptions options = PipelineOptions());
+
+    // 返回成功送入检测阶段的帧数
+    size_t run(const DetectFn& detect);
+
+private:
+    void loadFrame(size_t index, Frame& frame) const;
+    size_t runThreaded(const DetectFn& detect);
+    size_t runOnPool(const DetectFn& detect);
+    size_t runLive(const DetectFn& detect);
+    void present(const Frame& frame, const FrameResult& result);
+
+    const FrameSource& source_;
+    FrameSink& sink_;
+    PipelineOptions options_;
+    cv::Mat preview_;
+};
+
+std::vector<std::string> getSortedImagePaths(const std::string& folder_path);
+
+cv::Mat renderAnnotations(const Frame& frame, const FrameResult& result);
+// 画到 display 上；display 尺寸类型不变时复用其缓冲
+void renderAnnotations(const Frame& frame, const FrameResult& result, cv::Mat& display);
+
+}  // namespace haar
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "frame_pipeline.h"
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace haar {
+
+// 打包帧文件（.frames）：一条序列的 8 位灰度平面按页对齐连续存放，回放时 mmap 后零拷贝取帧，
+// 省掉每次运行都要做的 JPEG 解码。布局（小端）：
+//   [FrameStoreHeader][FrameStoreEntry × frameCount] 填充到 dataOffset
+//   每帧一个平面，起始偏移按 pageSize 对齐，height 行、每行 step 字节
+struct FrameStoreHeader {
+    char magic[8];  // "HAARFRM\0"
+    uint32_t version;
+    uint32_t frameCount;
+    uint32_t pageSize;
+    uint32_t reserved;
+    uint64_t dataOffset;
+};
+
+struct FrameStoreEntry {
+    uint64_t offset;
+    uint32_t width;
+    uint32_t height;
+    uint32_t step;
+    uint32_t reserved;
+    char name[64];  // 源图片文件名，输出时沿用
+};
+
+static_assert(sizeof(FrameStoreHeader) == 32, "frame store header layout");
+static_assert(sizeof(FrameStoreEntry) == 88, "frame store entry layout");
+
+// 顺序写入；帧数需预先给定，索引在 finish() 时回填
+class FrameStoreWriter {
+public:
+    FrameStoreWriter(const std::string& path, size_t frameCount);
+    ~FrameStoreWriter();
+
+    FrameStoreWriter(const FrameStoreWriter&) = delete;
+    FrameStoreWriter& operator=(const FrameStoreWriter&) = delete;
+
+    bool isOpen() const { return file_ != nullptr; }
+    bool add(const std::string& name, const cv::Mat& gray);
+    bool finish();
+
+private:
+    FILE* file_ = nullptr;
+    std::vector<FrameStoreEntry> entries_;
+    size_t frameCount_ = 0;
+    uint64_t end_ = 0;
+};
+
+// 只读映射；frame() 返回直接指向映射内存的 Mat，数据不可写，生命周期不能超过本对象
+class MappedFrameStore {
+public:
+    MappedFrameStore() = default;
+    ~MappedFrameStore();
+
+    MappedFrameStore(const MappedFrameStore&) = delete;
+    MappedFrameStore& operator=(const MappedFrameStore&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    size_t size() const { return entries_ ? header().frameCount : 0; }
+    cv::Mat frame(size_t index) const;
+    std::string name(size_t index) const;
+
+private:
+    const FrameStoreHeader& header() const { return *reinterpret_cast<const FrameStoreHeader*>(data_); }
+
+    const unsigned char* data_ = nullptr;
+    size_t length_ = 0;
+    const FrameStoreEntry* entries_ = nullptr;
+#ifdef _WIN32
+    void* mapping_ = nullptr;
+#endif
+};
+
+// 以打包帧文件为来源；load() 只是构造视图，不做解码
+class FrameStoreSource : public FrameSource {
+public:
+    explicit FrameStoreSource(const std::string& path);
+
+    bool isOpen() const { return store_.size() > 0; }
+    size_t size() const override { return store_.size(); }
+    bool load(size_t index, Frame& frame) const override;
+
+private:
+    MappedFrameStore store_;
+};
+
+// path 是普通文件时按打包帧文件打开，否则按图片目录打开
+std::unique_ptr<FrameSource> openFrameSource(const std::string& path);
+// options.live.enabled 时把 path 当作实时输入打开（LiveSource，见 live_source.h），否则同上
+std::unique_ptr<FrameSource> openFrameSource(const std::string& path, const PipelineOptions& options);
+
+}  // namespace haar
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tunables.h"
+
+// 嵌入用的检测接口：模型（级联、模板、可调参数）加载一次，之后只读，可被任意多个会话在不同线程上共用；
+// 每路视频一个会话，帧按时间顺序送进去。可执行文件也是这套接口的客户端（见 detector_registry.h）。
+// 只依赖 OpenCV 与 tunables.h，流水线、队列和检测器的内部类型都藏在 haar_api.cpp 里
+//
+//     std::string error;
+//     auto model = haar::Model::load({"detect_haar_roi"}, &error);
+//     auto session = model->createSession();
+//     for (const cv::Mat& frame : frames) {
+//         for (const haar::Detection& d : session->process(frame)) { ... }
+//     }
+namespace haar {
+
+class DetectorModel;
+class Session;
+
+struct Detection {
+    cv::Rect box;        // 原图坐标
+    double score = 0;    // 检测器给出的得分，没有时为 0
+    std::string label;   // "drone" / "target" 等；跟踪预测为 "prediction"，未确认的候选为 "candidate"
+};
+
+struct ModelConfig {
+    std::string detector = "detect_haar_roi";  // 检测器名，同可执行文件名（见 detectorNames()）
+    std::string assetRoot;                     // 级联与模板所在目录；为空时同 defaultAssetRoot()
+    Tunables tunables;                         // 覆盖默认参数，名字同 --set（见 tunables.h）
+};
+
+class Model : public std::enable_shared_from_this<Model> {
+public:
+    // 失败时返回空，原因写进 error（不为空时）；参数取值超出范围、tunables 里有检测器不认的名字也算失败
+    static std::shared_ptr<const Model> load(const ModelConfig& config, std::string* error = nullptr);
+    ~Model();
+
+    // 可以在任意线程上并发调用；会话持有模型的引用，模型在最后一个会话销毁后才释放
+    std::unique_ptr<Session> createSession() const;
+
+    const std::string& detector() const { return detector_; }
+    // 加载后的一行说明（编译状态、检测尺度等），可能为空
+    std::string describe() const;
+
+private:
+    friend class Session;
+    Model(std::string detector, std::unique_ptr<DetectorModel> model);
+
+    std::string detector_;
+    std::unique_ptr<DetectorModel> model_;
+};
+
+// 一路视频的检测状态（跟踪、逐帧复用的缓冲）。同一个会话不能被多个线程同时使用
+class Session {
+public:
+    ~Session();
+
+    Session(const Session&) = delete;
+    Session& operator=(const Session&) = delete;
+
+    // image 为 8 位灰度、BGR 或 BGRA；作为序列的下一帧处理。空图或其他格式抛 cv::Exception（StsBadArg），
+    // 会话状态不变
+    std::vector<Detection> process(const cv::Mat& image);
+    // images 依次作为序列的下几帧：转灰度与缩小图并行做，检测仍按帧序进行（跟踪状态依赖前一帧）。
+    // 返回与 images 同序；任何一帧格式不对时先整批拒绝，同 process
+    std::vector<std::vector<Detection>> processBatch(const std::vector<cv::Mat>& images);
+
+    // 丢掉跟踪状态，下一帧当作新序列的第一帧
+    void reset();
+    size_t frames() const { return frames_; }  // 自创建或 reset() 以来处理的帧数
+
+private:
+    friend class Model;
+    struct Impl;  // 检测器会话与逐帧缓冲，见 haar_api.cpp
+
+    explicit Session(std::shared_ptr<const Model> model);
+
+    std::shared_ptr<const Model> model_;
+    std::unique_ptr<Impl> impl_;
+    size_t frames_ = 0;
+};
+
+// 可用的检测器名
+std::vector<std::string> detectorNames();
+
+}  // namespace haar
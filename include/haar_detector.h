@@ -0,0 +1,120 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "compiled_cascade.h"
+#include "fast_kernels.h"
+
+namespace haar {
+
+class WorkStealingPool;
+
+// CascadeClassifierImpl::detectMultiScaleNoGrouping 的尺度表、步长与条带划分，其中数值类型
+// （double / float 的混用）也保持一致，否则边界上的尺度和窗口会差一个像素。尺度只取决于 scaleFactor，
+// 窗口大小不同的级联在同一幅图上选出的尺度是同一个数列的不同片段，可以共用缩放层
+class ScalePlan {
+public:
+    // 返回 false 表示没有要扫描的层；maxSize 为空时取整幅图。scaleFactor 须大于 1（与 OpenCV 一样断言）
+    bool plan(cv::Size imageSize, cv::Size windowSize, double scaleFactor, cv::Size minSize, cv::Size maxSize);
+
+    const std::vector<float>& scales() const { return scales_; }  // 递增
+
+    cv::Size layerSize(float scale) const {
+        return cv::Size(cvRound(imageSize_.width / scale), cvRound(imageSize_.height / scale));
+    }
+    cv::Size objectSize(float scale) const {
+        return cv::Size(cvRound(windowSize_.width * scale), cvRound(windowSize_.height * scale));
+    }
+    static int yStep(float scale) { return scale >= 2 ? 1 : 2; }
+    // 第一个尺度的工作宽度决定条带数，条带总高可能短于工作高度，末尾几行不会被扫描
+    int yEnd(float scale) const;
+
+private:
+    cv::Size imageSize_, windowSize_;
+    int nstripes_ = 0;
+    std::vector<float> allScales_, scales_;
+};
+
+// 一个缩放层的图像与积分图，逐帧复用：缩放图写进 resized_ 左上角的视图，尺寸变化也不重新分配
+class IntegralLayerBuffer {
+public:
+    // image 为 CV_8UC1，size 不大于 image；返回的层在下一次 build 之前有效
+    const IntegralLayer& build(const cv::Mat& image, cv::Size size);
+
+private:
+    cv::Mat resized_;
+    std::vector<int> sum_, sqsum_;
+    IntegralLayer layer_;
+};
+
+// cv::groupRectangles(rects, groupThreshold, eps) 的逐步照搬（含 cv::partition 的并查集与类编号顺序），
+// 中间结果放在成员里复用。weights 不为空时填入每个保留框合并了多少个原始框
+class RectangleGrouper {
+public:
+    void group(std::vector<cv::Rect>& rects, int groupThreshold, double eps, std::vector<int>* weights = nullptr);
+
+private:
+    std::vector<int> nodes_, labels_, groupWeights_;
+    std::vector<cv::Rect> groupSums_;
+};
+
+// CascadeClassifier::detectMultiScale 末尾的 clipObjects：框裁到图内，裁空的丢弃（weights 随之对齐）
+void clipObjects(cv::Size imageSize, std::vector<cv::Rect>& objects, std::vector<int>* weights = nullptr);
+
+// cv::CascadeClassifier 的替身：级联在构建时被编译进来、且 load 时选用时走 SIMD 评估器，结果与 OpenCV 逐一相同；
+// 否则（未选用、未编译、XML 已改动）退回 OpenCV 的解释执行。与 CascadeClassifier 一样，同一个对象不能被多个线程同时使用
+class HaarDetector {
+public:
+    // compiled 为 false 时不查编译后的级联，直接用 OpenCV；默认随 HAAR_FAST_KERNELS
+    bool load(const std::string& path, bool compiled = FAST_KERNELS);
+    // 与已加载的 loaded 共用编译好的级联（只读，可跨线程共用），不再读文件；loaded 走 OpenCV 时按它的路径
+    // 重新加载一份，CascadeClassifier 不能被多个线程同时使用。多路会话共用一份模型时用它
+    bool loadFrom(const HaarDetector& loaded);
+    bool empty() const { return !compiled_ && fallback_.empty(); }
+
+    bool isCompiled() const { return compiled_ != nullptr; }
+    const char* backend() const { return compiled_ ? compiled_->backend() : "opencv"; }
+    // 级联的检测窗口，即能检出的最小目标
+    cv::Size windowSize() const { return compiled_ ? compiled_->windowSize() : fallback_.getOriginalWindowSize(); }
+
+    // 参数含义同 CascadeClassifier::detectMultiScale；新格式级联不使用 flags
+    void detectMultiScale(const cv::Mat& image, std::vector<cv::Rect>& objects,
+                          double scaleFactor = 1.1, int minNeighbors = 3, int flags = 0,
+                          cv::Size minSize = cv::Size(), cv::Size maxSize = cv::Size());
+
+    // 整帧重新捕获用的并行版：各尺度层的积分图并行建好后，每层按行切成固定高度的整行条带，
+    // (层, 条带) 作为任务在 pool 上并行扫描（为空时用 cv::parallel_for_），命中按串行扫描的顺序拼接后分组。
+    // 条带划分只取决于级联窗口，结果与 detectMultiScale 逐一相同、与线程数无关。未编译时退回串行的 OpenCV
+    void detectMultiScaleTiled(const cv::Mat& image, std::vector<cv::Rect>& objects, WorkStealingPool* pool,
+                               double scaleFactor = 1.1, int minNeighbors = 3,
+                               cv::Size minSize = cv::Size(), cv::Size maxSize = cv::Size());
+
+private:
+    // 一个扫描任务：第 layer 层窗口起点在 [yBegin, yEnd) 的行
+    struct ScanTile {
+        int layer, yBegin, yEnd;
+    };
+
+    void detectCompiled(const cv::Mat& image, std::vector<cv::Rect>& objects, double scaleFactor,
+                        int minNeighbors, cv::Size minSize, cv::Size maxSize);
+
+    std::string path_;
+    std::shared_ptr<const CompiledCascade> compiled_;
+    cv::CascadeClassifier fallback_;
+
+    // 逐帧复用的缓冲
+    ScalePlan plan_;
+    IntegralLayerBuffer layer_;
+    RectangleGrouper grouper_;
+    std::vector<cv::Point> hits_;
+    // detectMultiScaleTiled 的缓冲：每层一份积分图，每个条带一份命中
+    std::vector<IntegralLayerBuffer> layers_;
+    std::vector<const IntegralLayer*> built_;
+    std::vector<ScanTile> tiles_;
+    std::vector<std::vector<cv::Point>> tileHits_;
+};
+
+}  // namespace haar
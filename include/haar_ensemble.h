@@ -0,0 +1,85 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "compiled_cascade.h"
+#include "haar_detector.h"
+
+namespace haar {
+
+enum class EnsembleFusion {
+    Union,  // 各级联的结果合在一起做 NMS
+    Vote,   // 至少 minVotes 个级联都检出（IoU 够大）的目标才保留
+};
+
+struct HaarEnsembleOptions {
+    EnsembleFusion fusion = EnsembleFusion::Union;
+    int minVotes = 2;
+    double nmsIou = 0.3;  // IoU 不低于此值的框视为同一目标
+};
+
+// 多个级联一起检测：编译进来的级联共用每帧的缩放层和积分图，在同一趟扫描里评估，级联之间相同的特征
+// 每批窗口只算一次（见 CompiledEnsemble），开销随不重复的特征数而不是级联数增长；未编译的级联退回
+// OpenCV 单独检测。每个级联的结果与单独用 HaarDetector 检测相同，再按 options 融合。
+// 同一个对象不能被多个线程同时使用
+class HaarEnsemble {
+public:
+    explicit HaarEnsemble(HaarEnsembleOptions options = {});
+
+    // 任何一个级联加载失败时返回 false；同一个文件只加载一次。compiled 同 HaarDetector::load
+    bool load(const std::vector<std::string>& paths, bool compiled = FAST_KERNELS);
+    // 与已加载的 loaded 共用编译好的级联，不再读文件（走 OpenCV 的级联各自重新加载）；融合参数用本对象的
+    bool loadFrom(const HaarEnsemble& loaded);
+    size_t size() const { return members_.size(); }
+    bool empty() const { return members_.empty(); }
+
+    size_t compiledCount() const;  // 在共享扫描里评估的级联数
+    const char* backend() const { return compiled_ ? compiled_->backend() : "opencv"; }
+
+    // 参数含义同 CascadeClassifier::detectMultiScale，对所有级联相同；融合后的框按合并的原始框数从多到少
+    void detectMultiScale(const cv::Mat& image, std::vector<cv::Rect>& objects, double scaleFactor = 1.1,
+                          int minNeighbors = 3, cv::Size minSize = cv::Size(), cv::Size maxSize = cv::Size());
+
+    // 上一次检测中第 i 个级联（load 时的顺序）分组后的结果
+    const std::vector<cv::Rect>& lastDetections(size_t i) const { return members_[i].objects; }
+
+private:
+    struct Member {
+        std::string path;
+        int index = -1;                     // 在 compiled_ 中的下标，-1 表示走 OpenCV
+        std::unique_ptr<cv::CascadeClassifier> fallback;
+        ScalePlan plan;
+        size_t next = 0;                    // 扫描各层时 plan.scales() 的游标
+        std::vector<cv::Rect> objects;
+        std::vector<int> weights;
+    };
+
+    void detectCompiled(const cv::Mat& gray, double scaleFactor, int minNeighbors, cv::Size minSize,
+                        cv::Size maxSize);
+    void fuse(std::vector<cv::Rect>& objects);
+
+    HaarEnsembleOptions options_;
+    std::shared_ptr<const CompiledEnsemble> compiled_;
+    std::vector<Member> members_;
+
+    // 逐帧复用的缓冲
+    std::vector<float> layerScales_;            // 各级联尺度的并集，递增
+    std::vector<int> yEnds_;                    // 按 compiled_ 的下标
+    std::vector<std::vector<cv::Point>> hits_;  // 同上
+    IntegralLayerBuffer layer_;
+    RectangleGrouper grouper_;
+
+    struct Candidate {
+        cv::Rect box;
+        int weight;
+        size_t member;
+    };
+    std::vector<Candidate> candidates_;
+    std::vector<char> suppressed_;
+    std::vector<char> voters_;
+};
+
+}  // namespace haar
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+#include "haar_detector.h"
+#include "haar_ensemble.h"
+#include "tunables.h"
+
+namespace haar {
+
+// Haar 检测器（detect_haar_roi、detect_haar_threshold_roi、detect_haar_ensemble、detect_haar_hybrid）加载模型时
+// 共用的部分。模型里的级联只作为各会话 loadFrom 的来源，本身不用来检测
+
+// detectMultiScale 的公共参数
+struct HaarScanSettings {
+    cv::Size minObject;
+    double scaleFactor = 1.1;
+    int minNeighbors = 3;
+};
+
+// 读 min_width / min_height、scale_factor、min_neighbors（settings 传入时为检测器的默认值）并检查取值范围；
+// 不合法时返回 false 并在 error 里说明
+bool readHaarScanSettings(const Tunables& tune, HaarScanSettings& settings, std::string& error);
+
+// 读入 assetRoot 下的级联；失败时返回 false，error 为 "Failed to load Haar classifier: <路径>"
+bool loadCascade(const std::string& assetRoot, const std::string& relative, HaarDetector& cascade,
+                 std::string& error);
+bool loadCascades(const std::string& assetRoot, const std::vector<std::string>& relative, HaarEnsemble& cascades,
+                  std::string& error);
+
+}  // namespace haar
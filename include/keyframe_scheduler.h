@@ -0,0 +1,75 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <memory>
+
+#include "search_window.h"
+#include "template_matcher.h"
+
+namespace haar {
+
+struct KeyframeSchedulerOptions {
+    int keyframeInterval = 10;     // 跟踪稳定时每隔几帧跑一次 Haar
+    int maxKeyframeInterval = 40;  // 超预算时关键帧间隔最多拉长到这里
+    double budgetMs = 0;           // 每帧平均用时预算；0 表示不按预算调节
+    double costSmoothing = 0.1;    // 平均用时的指数平滑系数
+    double trackScore = 0.5;       // 模板得分低于此值视为跟丢，本帧立即跑 Haar
+    double refreshScore = 0.7;     // 低于此值说明外观在变，下一帧跑 Haar 重切模板
+    int searchMargin = 24;         // 模板搜索窗口在预测位置外扩的像素
+    int minTemplateSide = 12;      // 检测框裁到帧内后短边不足该值时不切模板
+    SearchWindowOptions window;    // 关键帧上 Haar 的搜索窗口
+};
+
+enum class FramePath {
+    Detect,  // 关键帧：跑 Haar
+    Track,   // 模板跟踪
+};
+
+// 关键帧调度：Haar 只在关键帧（定期、或模板跟踪置信度下降时）运行，中间帧用从最近一次 Haar 检测框
+// 重新切出的模板在预测位置附近的小窗口里跟踪。关键帧间隔按平均每帧用时与预算自动伸缩，
+// 平均开销接近模板跟踪，尺度和外观的变化仍由 Haar 定期纠正。
+// 每帧先 path()；Track 时调用 track()，失败则本帧改跑 Haar；跑 Haar 时用 detectWindow() 给出的区域，
+// 结果交给 detected() / missed()；最后 finish() 记入本帧用时
+class KeyframeScheduler {
+public:
+    explicit KeyframeScheduler(KeyframeSchedulerOptions options = {});
+
+    // 本帧走哪条路径；同时预测目标位置
+    FramePath path(cv::Size frameSize);
+
+    // 模板跟踪：得分不低于 trackScore 时把框写进 box 并返回 true
+    bool track(const cv::Mat& frame, cv::Rect& box, double& score);
+
+    // Haar 的搜索区域：跟踪中按预测与不确定度定大小（见 SearchWindowPlanner），否则为整帧
+    const SearchWindow& detectWindow() const { return window_; }
+    // Haar 检出目标：更新跟踪并从本帧重切模板；框裁到帧内后太小时丢掉旧模板，跟踪改由 Haar 接替
+    void detected(const cv::Mat& frame, const cv::Rect& box);
+    void missed();
+
+    void finish(double elapsedMs);
+
+    bool tracking() const { return planner_.tracking(); }
+    // 本帧预测的目标框（path() 之后有效，tracking() 时才有意义）
+    cv::Rect predicted() const { return planner_.predicted(); }
+    int keyframeInterval() const { return interval_; }
+    double averageMs() const { return averageMs_; }
+    size_t keyframes() const { return keyframes_; }      // 跑过 Haar 的帧数（含升级的）
+    size_t escalations() const { return escalations_; }  // 其中由模板跟丢升级的帧数
+    // 本帧的模板搜索窗口（track() 之后有效）
+    const cv::Rect& trackWindow() const { return trackWindow_; }
+
+private:
+    KeyframeSchedulerOptions options_;
+    SearchWindowPlanner planner_;
+    std::unique_ptr<TemplateMatcher> matcher_;  // 第一次切模板时创建，之后 reset() 复用缓冲
+    bool hasTemplate_ = false;                  // matcher_ 里的模板是否属于当前目标
+    SearchWindow window_;
+    cv::Rect trackWindow_;
+    int interval_;
+    int sinceKeyframe_ = 0;
+    bool refresh_ = false;    // 模板得分偏低，预算允许时下一帧跑 Haar
+    double averageMs_ = 0;
+    size_t frames_ = 0, keyframes_ = 0, escalations_ = 0;
+};
+
+}  // namespace haar
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#include "trace.h"
+
+namespace haar {
+
+// 单帧处理的各阶段；解码和编码由 FramePipeline 计时，其余由各检测器在回调里标注
+enum Stage {
+    STAGE_DECODE = 0,
+    STAGE_PREPROCESS,  // 模糊、阈值化等整帧预处理
+    STAGE_ROI,         // 候选区域 / 搜索窗口的确定
+    STAGE_DETECT,      // 级联检测、边缘与轮廓、模板匹配
+    STAGE_TRACK,       // 结果筛选与跟踪状态更新
+    STAGE_ENCODE,
+    STAGE_CAPTURE_TO_RESULT,  // 实时输入：采集时刻到检测出结果，含排队等待，不是单独的处理阶段
+    STAGE_COUNT
+};
+
+const char* stageName(Stage stage);
+
+struct LatencySummary {
+    size_t count = 0;
+    double p50 = 0, p95 = 0, p99 = 0, max = 0;  // 毫秒
+};
+
+// 各阶段的耗时样本；record() 可被解码、编码线程并发调用
+class LatencyRecorder {
+public:
+    void record(Stage stage, double ms);
+    LatencySummary summary(Stage stage) const;  // 最近秩法取分位数
+    void clear();
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<double> samples_[STAGE_COUNT];
+};
+
+// 分段计时：构造时进入 stage，next() 结束当前阶段并进入下一阶段，stop() 或析构时结束；
+// recorder 为空时不计时，检测代码不需要为计时改变变量作用域。
+// 追踪开启时（见 trace.h）每个阶段同时记为一条以 stageName() 命名的 span，阶段内的 HAAR_TRACE_ARG 标注到这条 span 上
+class StageTimer {
+public:
+    StageTimer(LatencyRecorder* recorder, Stage stage)
+        : recorder_(recorder), stage_(stage) {
+        if (recorder_) start_ = std::chrono::steady_clock::now();
+#ifdef HAAR_TRACING
+        if (trace::enabled()) span_.begin(stageName(stage));
+#endif
+    }
+    ~StageTimer() { stop(); }
+
+    void next(Stage stage) {
+#ifdef HAAR_TRACING
+        span_.begin(stageName(stage));
+#endif
+        if (!recorder_) return;
+        const auto now = std::chrono::steady_clock::now();
+        if (running_) recorder_->record(stage_, std::chrono::duration<double, std::milli>(now - start_).count());
+        stage_ = stage;
+        start_ = now;
+        running_ = true;
+    }
+
+    void stop() {
+#ifdef HAAR_TRACING
+        span_.end();
+#endif
+        if (!recorder_ || !running_) return;
+        recorder_->record(stage_, std::chrono::duration<double, std::milli>(
+                                      std::chrono::steady_clock::now() - start_).count());
+        running_ = false;
+    }
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+private:
+    LatencyRecorder* recorder_;
+    Stage stage_;
+    bool running_ = true;
+    std::chrono::steady_clock::time_point start_;
+#ifdef HAAR_TRACING
+    trace::Span span_;
+#endif
+};
+
+}  // namespace haar
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "bounded_queue.h"
+#include "frame_pipeline.h"
+
+namespace haar {
+
+// 实时输入：采集线程从 cv::VideoCapture（视频文件、命名管道、URL，或全数字时为设备号）读帧、转灰度、
+// 打上采集时刻，放进只保留最新 bufferFrames 帧的队列；检测比输入慢时旧帧被挤掉，端到端延迟不会越积越大。
+// 视频文件按 replayFps（或文件自身帧率）定速回放，可以代替相机做测试。
+// 构造时即开始采集（相机不会等检测），析构时停止。帧号为采集序号，被丢掉的帧不交出，帧号因此不连续
+class LiveSource : public FrameSource {
+public:
+    // reduceBy > 1 时采集线程顺带生成 Frame::reduced（同 PipelineOptions::reduceBy）
+    LiveSource(const std::string& uri, LiveSourceOptions options, int reduceBy = 1);
+    ~LiveSource() override;
+
+    LiveSource(const LiveSource&) = delete;
+    LiveSource& operator=(const LiveSource&) = delete;
+
+    bool isOpen() const { return opened_; }
+
+    size_t size() const override { return 0; }
+    bool load(size_t, Frame&) const override { return false; }
+    bool live() const override { return true; }
+    bool next(Frame& frame) const override;
+
+    size_t captured() const { return captured_.load(); }
+    size_t dropped() const { return frames_.dropped(); }
+
+private:
+    void captureLoop();
+
+    std::string uri_;
+    LiveSourceOptions options_;
+    int reduceBy_;
+    cv::VideoCapture capture_;  // 打开后只由采集线程使用
+    double fps_ = 0;            // 回放帧率；0 不定速
+    bool opened_ = false;
+
+    mutable LatestQueue<Frame> frames_;  // 内部加锁，next() 只是取走一帧
+    std::atomic<bool> stopping_{false};
+    std::atomic<size_t> captured_{0};
+    std::thread thread_;
+};
+
+}  // namespace haar
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+#include "blob_extractor.h"
+
+namespace haar {
+
+struct MotionGateOptions {
+    int threshold = 25;              // |帧 - 背景| > threshold 为变化像素
+    int learningShift = 3;           // 背景每帧向当前帧靠近差值的 1/2^shift；0 表示背景就是上一帧
+    int closeSize = 9;               // 变化掩码闭运算的结构元素边长，把目标上零散的变化点连成一块
+    size_t maxCandidates = 4;        // 输出外接框最大的前 N 个变化区域
+    int padding = 24;                // 候选框向四周外扩的像素
+    cv::Size minCandidate = cv::Size(64, 64);  // 候选框不小于该尺寸（以原框中心外扩），容得下检测窗口
+    int fullScanInterval = 30;       // 兜底：每隔几帧整帧检测一次，找回静止或变化太弱的目标
+    double maxChangedFraction = 0.3; // 候选框总面积超过整帧的这个比例时（镜头移动、光照突变）改为整帧检测
+};
+
+// 时域预检：维护一个滑动平均背景（learningShift = 0 时即上一帧），每帧逐行求 |帧 - 背景| 并同时更新背景
+// （SSE2 / NEON 一次 16 像素），差值图交给 BlobExtractor 阈值化、闭运算、取连通域外接框，
+// 输出少量紧凑的候选框，后面的 Haar / 模板只在这些区域里找新目标。
+// 第一帧、兜底周期到了、或变化面积过大时 fullScan() 为 true，此时不给候选框。
+// 缓冲逐帧复用，同一个对象不能被多个线程同时使用
+class MotionGate {
+public:
+    explicit MotionGate(MotionGateOptions options = {});
+
+    // gray 为 CV_8UC1；返回的引用在下一次 update 之前有效
+    const std::vector<cv::Rect>& update(const cv::Mat& gray);
+    bool fullScan() const { return fullScan_; }
+    const std::vector<cv::Rect>& candidates() const { return candidates_; }
+
+    void reset() { background_.release(); }
+
+private:
+    void differenceRow(const uchar* frame, uchar* background, uchar* diff, int width) const;
+
+    MotionGateOptions options_;
+    BlobExtractor blobs_;
+    cv::Mat background_, diff_;
+    std::vector<cv::Rect> candidates_;
+    int sinceFullScan_ = 0;
+    bool fullScan_ = true;
+};
+
+}  // namespace haar
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+#include "haar_detector.h"
+
+namespace haar {
+
+struct ReducedDetectionOptions {
+    std::vector<int> factors = {4, 2};  // 可选的缩小倍数，从大到小试
+    double refinePadding = 0.5;         // 精修窗口在粗检框四周各外扩框边长的这个比例
+    int minRefinePadding = 8;           // 外扩至少这么多像素，吸收缩小带来的定位误差
+    double refineSizeSlack = 1.4;       // 精修时目标尺寸限制在粗检框的 [1/slack, slack] 倍
+    bool keepUnrefined = true;          // 原分辨率精修没找到时保留放大回来的粗检框；false 时精修兼作复核
+    double nmsIou = 0.5;                // 不同粗检框精修到同一目标时按 IoU 去重
+};
+
+// 缩小倍数：级联只能检出不小于检测窗口的目标，缩小 f 倍后能检出的最小目标是 f 倍窗口。
+// 在 factors 里取满足 f × 窗口 ≤ max(minTarget, 窗口) 的最大倍数，不满足时为 1
+int chooseReduction(cv::Size windowSize, cv::Size minTarget, const std::vector<int>& factors);
+
+// 低分辨率检测 + 原分辨率精修：先在缩小 reduceBy() 倍的图上跑级联，每个粗检框再在原图上
+// 以它为中心的小窗口里、只在与它相近的尺寸上重新检测，定位与原分辨率检测一致。
+// 缩小倍数由 configure() 按最小目标尺寸自动选择；缩小图最好由解码线程生成（PipelineOptions::reduceBy）。
+// 与 HaarDetector 一样，同一个对象不能被多个线程同时使用
+class ReducedResolutionDetector {
+public:
+    explicit ReducedResolutionDetector(ReducedDetectionOptions options = {});
+
+    bool load(const std::string& path) { return detector_.load(path); }
+    bool load(const HaarDetector& loaded) { return detector_.loadFrom(loaded); }  // 见 HaarDetector::loadFrom
+    HaarDetector& detector() { return detector_; }
+
+    // 按最小目标尺寸选缩小倍数，返回该倍数
+    int configure(cv::Size minTarget);
+    int reduceBy() const { return reduceBy_; }
+
+    // image 为原分辨率；reduced 为 image 缩小 reduceBy() 倍的图（为空或尺寸不符时自己缩小）；
+    // roi 与结果都是原分辨率坐标。其余参数同 HaarDetector::detectMultiScale，尺寸按原分辨率给。
+    // tiled 时粗检（不缩小时即整个检测）走 HaarDetector::detectMultiScaleTiled，在 pool 上分块并行，
+    // 结果不变；用于整帧重新捕获，精修窗口很小，仍在调用线程上
+    void detectMultiScale(const cv::Mat& image, const cv::Mat& reduced, cv::Rect roi, std::vector<cv::Rect>& objects,
+                          double scaleFactor, int minNeighbors, cv::Size minSize, cv::Size maxSize = cv::Size(),
+                          bool tiled = false, WorkStealingPool* pool = nullptr);
+
+private:
+    ReducedDetectionOptions options_;
+    HaarDetector detector_;
+    int reduceBy_ = 1;
+
+    // 逐帧复用的缓冲
+    cv::Mat reducedBuffer_;
+    std::vector<cv::Rect> coarse_, found_;
+};
+
+}  // namespace haar
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bounded_queue.h"
+#include "frame_pipeline.h"
+
+namespace haar {
+
+enum class AnnotationFormat { Csv, JsonLines };
+
+// 只写标注、不出图。字段：帧号、文件名、框（标签、位置、得分）、是否在 ROI 内检测及实际搜索区域、解码与检测耗时。
+// CSV 每个框一行，没有框的帧也写一行、框字段留空；JSON Lines 每帧一行。
+// consume() 在编码线程上格式化，后台线程按帧序写文件
+class AnnotationWriterSink : public FrameSink {
+public:
+    AnnotationWriterSink(const std::string& path, AnnotationFormat format, size_t window = 32);
+    ~AnnotationWriterSink() override;
+
+    void consume(const Frame& frame, const FrameResult& result) override;
+
+private:
+    void writeLoop();
+
+    std::ofstream out_;
+    AnnotationFormat format_;
+    OrderedQueue<std::string> lines_;
+    std::thread writer_;
+};
+
+// 标注帧按帧序写进一个 MJPG/AVI 视频：绘制在编码线程上并行做，VideoWriter::write 在后台线程上串行做。
+// 视频尺寸与颜色取第一帧，之后尺寸不同的帧缩放到第一帧大小
+class VideoWriterSink : public FrameSink {
+public:
+    VideoWriterSink(const std::string& path, double fps, size_t window = 32);
+    ~VideoWriterSink() override;
+
+    void consume(const Frame& frame, const FrameResult& result) override;
+
+private:
+    void writeLoop();
+
+    std::string path_;
+    double fps_;
+    OrderedQueue<cv::Mat> frames_;
+    std::thread writer_;
+};
+
+// 把每帧依次交给多个 sink；一个都没有时什么也不写
+class TeeSink : public FrameSink {
+public:
+    void add(std::unique_ptr<FrameSink> sink) { sinks_.push_back(std::move(sink)); }
+    bool empty() const { return sinks_.empty(); }
+
+    void consume(const Frame& frame, const FrameResult& result) override;
+
+private:
+    std::vector<std::unique_ptr<FrameSink>> sinks_;
+};
+
+// 按 options.output 建立一条序列的输出：images 写 outputFolder/<源文件名 stem><imageSuffix>
+// （imageSuffix 为空时沿用源文件名），video 写 outputFolder/annotated.avi，
+// csv / jsonLines 写 outputFolder/annotations.csv / annotations.jsonl
+std::unique_ptr<FrameSink> makeSink(const PipelineOptions& options, const std::string& outputFolder,
+                                    const std::string& imageSuffix);
+
+// 认得 argv[i] 处的输出参数时写进 options、把 i 移到用掉的最后一个参数并返回 true：
+//   --sink images,video,csv,jsonl,none   选择输出（可组合，默认 images）
+//   --preview-every N                    每 N 帧预览一次，0 关闭预览（无显示环境下使用）
+//   --video-fps F                        视频帧率
+//   --trace PREFIX                       记录追踪，退出时写 PREFIX.json（Chrome trace）和 PREFIX.trace（见 trace.h）
+//   --set NAME=VALUE                     设置检测器的一个可调参数（见 tunables.h），可重复
+//   --config FILE                        从文件读入可调参数，每行一个 NAME=VALUE；与 --set 按出现顺序覆盖
+//   --live                               序列参数作为实时输入（视频文件、命名管道、URL 或设备号，见 live_source.h）
+//   --live-fps F                         视频文件按 F 帧率回放（默认取文件自身帧率）
+//   --live-buffer N                      采集与检测之间最多积压 N 帧，满时丢最旧的（默认 1）
+//   --live-frames N                      采集 N 帧后结束（默认直到输入结束）
+// 取值不合法时打印错误并 exit(2)
+bool parseOutputFlag(int argc, char** argv, int& i, PipelineOptions& options);
+
+// 检测器可执行文件的命令行：输出参数写进 options，其余参数作为序列（图片目录或 .frames 打包文件）返回；
+// 没有序列时按各程序原来的单序列方式运行
+std::vector<std::string> parseDetectorArgs(int argc, char** argv, PipelineOptions& options);
+
+}  // namespace haar
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+#include "track_filter.h"
+
+namespace haar {
+
+struct SearchWindowOptions {
+    double sigmas = 3.0;                   // 搜索边距 = sigmas × 预测位置的标准差
+    int minMargin = 16;                    // 边距下限（像素），速度已收敛时窗口也不会紧贴目标
+    std::vector<double> stages = {1, 2, 4};  // 连续未命中时逐帧放大窗口的倍数，用完仍未命中则丢失目标
+    double sizeSlack = 1.5;                // 目标尺寸范围 [上次尺寸 / sizeSlack, 上次尺寸 × sizeSlack]
+    double measurementStd = 4.0;           // 检测框中心的测量噪声（像素）
+    double accelerationStd = 2.0;          // 匀速模型的加速度噪声（像素 / 帧²）
+    double initialVelocityStd = 20.0;      // 首次检测时未知速度的标准差（像素 / 帧）
+};
+
+// 本帧要搜索的区域
+struct SearchWindow {
+    cv::Rect roi;             // 已裁到帧内；丢失目标时为整帧
+    bool fullFrame = true;
+    int stage = -1;           // 第几级放大（0 为 1 倍），整帧时为 -1
+    cv::Size minObject, maxObject;  // 与上次检测一致的目标尺寸范围，整帧时为空
+
+    // 把检测器的尺寸范围收窄到与上次检测一致；maxSize 为空表示不限。整帧时不改
+    void narrow(cv::Size& minSize, cv::Size& maxSize) const;
+};
+
+// 跟踪器驱动的搜索窗口：匀速卡尔曼滤波（ConstantVelocityFilter）预测目标位置，窗口大小由预测的位置协方差决定，
+// 连续未命中时按 stages 逐帧放大，全部用完才丢失目标、回到整帧搜索。
+// 每帧先 begin() 取窗口，再按检测结果调用 update() 或 miss()
+class SearchWindowPlanner {
+public:
+    explicit SearchWindowPlanner(SearchWindowOptions options = {});
+
+    bool tracking() const { return tracking_; }
+    int misses() const { return misses_; }
+
+    // 预测本帧目标位置并给出搜索窗口
+    SearchWindow begin(cv::Size frameSize);
+
+    // 本帧检测到目标（整幅图坐标）
+    void update(const cv::Rect& box);
+    // 本帧没有检测到目标
+    void miss();
+
+    // 本帧预测的目标框（begin() 之后有效），中心为预测位置、尺寸为上次检测的尺寸
+    cv::Rect predicted() const;
+    // 本帧预测位置到 box 中心的马氏距离（begin() 之后有效），用于关联门限
+    double distance(const cv::Rect& box) const;
+
+private:
+    SearchWindowOptions options_;
+    ConstantVelocityFilter filter_;
+    bool tracking_ = false;
+    int misses_ = 0;
+    cv::Size lastSize_;
+};
+
+}  // namespace haar
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <vector>
+
+#include "fast_kernels.h"
+
+namespace haar {
+
+// 逐帧复用的轮廓与点集存储：reset() 只把长度清零，已分配的容量保留。
+// 注意 cv::findContours 会把外层 resize 成本帧轮廓数，轮廓数比上一帧少时多出的内层会被释放，
+// 这部分分配只能靠不经过 findContours 的轮廓提取消除
+class ContourArena {
+public:
+    std::vector<std::vector<cv::Point>>& contours() { return contours_; }
+    std::vector<cv::Point>& scratch() { return scratch_; }  // approxPolyDP 等的临时点集
+
+    void reset() {
+        for (auto& c : contours_) c.clear();
+        scratch_.clear();
+    }
+
+private:
+    std::vector<std::vector<cv::Point>> contours_;
+    std::vector<cv::Point> scratch_;
+};
+
+struct SquareDetectorOptions {
+    double cannyLow = 50;
+    double cannyHigh = 150;
+    double approxEpsilon = 0.02;  // approxPolyDP 精度，按轮廓周长的比例
+    double minAspect = 0.8;       // 外接框宽高比与面积都是开区间
+    double maxAspect = 1.2;
+    double minArea = 3000;
+    double maxArea = 10000;
+    bool fused = FAST_KERNELS;    // false 时走原来的整帧 GaussianBlur → 裁 ROI → Canny，不做外接框预筛
+};
+
+// detect.cpp 的方形目标检测：5x5 / σ=1.5 高斯模糊 → Canny → 外轮廓 → 凸四边形，取面积最大的近似正方形。
+// 只处理 ROI：模糊和 Sobel 在一趟逐行流水里完成（只多读模糊核需要的 2 像素边），梯度直接交给 Canny；
+// 轮廓先按外接框排除不可能的候选再做多边形逼近。结果应与“整帧 GaussianBlur、裁 ROI、Canny”逐位相同，
+// 由 verify_square_detector 比对；options.fused 为 false（HAAR_FAST_KERNELS 关闭时的默认）时直接走后者。
+// 缓冲逐帧复用，同一个对象不能被多个线程同时使用
+class SquareDetector {
+public:
+    explicit SquareDetector(SquareDetectorOptions options = {});
+
+    // 在 gray（CV_8UC1）的 roi 内查找；找到时返回 true，box 为整幅图坐标，score 为其面积
+    bool detect(const cv::Mat& gray, cv::Rect roi, cv::Rect& box, double& score);
+
+    // detect() 交给 Canny 的梯度：roi 内模糊后的 3x3 Sobel（CV_16SC1，roi 大小，roi 须在图内且非空）。
+    // 返回的视图在下一次调用之前有效；verify_square_detector 用它与 OpenCV 逐位比对
+    void gradients(const cv::Mat& gray, cv::Rect roi, cv::Mat& dx, cv::Mat& dy);
+
+private:
+    void blurSobel(const cv::Mat& gray, cv::Rect roi, cv::Mat& dx, cv::Mat& dy);
+    bool mayHoldSquare(const cv::Rect& bounds, size_t points) const;
+
+    SquareDetectorOptions options_;
+    cv::Mat dx_, dy_, edges_;
+    cv::Mat blurred_;                 // 未融合时的整帧模糊结果
+    std::vector<int> cols_;           // ROI 左右各扩 2 列后对应的帧内列号（BORDER_REFLECT_101）
+    std::vector<uchar> gathered_;     // ROI 贴着帧左右边界时，按 cols_ 取出的一行源像素
+    std::vector<uint16_t> hrows_;     // 水平模糊结果的 5 行环形缓冲（8 位小数定点）
+    std::vector<uchar> brows_;        // 模糊结果的 3 行环形缓冲，左右各复制 1 像素给 Sobel
+    ContourArena arena_;
+};
+
+}  // namespace haar
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+#include "template_matcher.h"
+#include "tunables.h"
+
+namespace haar {
+
+class WorkStealingPool;
+
+struct TemplateBankOptions {
+    std::vector<double> scales = {1.0};  // 模板的缩放倍数
+    std::vector<double> angles = {0.0};  // 绕模板中心的旋转角度（度，逆时针为正）
+    double earlyAccept = 1.0;            // 某个变体得分达到该值时，排在它后面的变体不再匹配；> 1 为不提前结束
+    TemplateMatcherOptions matcher;      // 每个变体的匹配参数
+};
+
+// 以 1 为中心的等比缩放：1/maxScale .. maxScale，两侧各 stepsPerSide 个，共 2 × stepsPerSide + 1 个，总含 1.0
+std::vector<double> geometricScales(double maxScale, int stepsPerSide);
+// 以 0 为中心的等距角度：-maxAngle .. maxAngle，两侧各 stepsPerSide 个，总含 0
+std::vector<double> symmetricAngles(double maxAngle, int stepsPerSide);
+
+// 模板检测器共用的模板库参数：默认缩放 1/1.2、1、1.2 三档，不旋转，得分达到 0.9 提前结束。
+// 运行时可覆盖（见 tunables.h）：bank_max_scale、bank_scale_steps、bank_max_angle、bank_angle_steps、early_accept。
+// 取值超出范围时返回 false 并在 error 里说明
+bool readTemplateBankOptions(const Tunables& tune, TemplateBankOptions& options, std::string& error);
+
+struct BankMatch : TemplateMatch {
+    int variant = -1;   // 得分最高的变体，-1 表示没有变体放得进搜索区域
+    double scale = 1.0;
+    double angle = 0.0;
+    cv::Size size;      // 该变体的模板尺寸，location 为其左上角
+
+    cv::Point center() const { return location + cv::Point(size.width / 2, size.height / 2); }
+};
+
+// 模板库：启动时把一张模板按 scales × angles 生成一组变体（旋转时边缘用复制填充，尺寸与缩放后相同），
+// 每个变体一个 TemplateMatcher，均值、范数、金字塔和频谱各自只算一次。
+// match() 把放得进搜索区域的变体并行匹配，取得分最高的；变体按离原模板的远近排序（先缩放 1、角度 0）。
+// 提前结束与调度无关：序号最小的达到 earlyAccept 的变体记为 k，结果只在 0..k 号里取（同分取序号小的），
+// 这些变体一定都匹配过；序号大于 k 的变体还没开始就跳过，已经算完的也不参与比较。结果与线程数无关。
+// 构建后只读，match() 可以被多个线程同时调用
+class TemplateBank {
+public:
+    TemplateBank(const cv::Mat& templ, TemplateBankOptions options = TemplateBankOptions());
+
+    size_t size() const { return variants_.size(); }
+    cv::Size templateSize(size_t variant) const { return variants_[variant].matcher.size(); }
+    double scale(size_t variant) const { return variants_[variant].scale; }
+    double angle(size_t variant) const { return variants_[variant].angle; }
+    cv::Size maxSize() const { return maxSize_; }  // 各变体模板尺寸的外包
+
+    // 跟踪时的搜索区域：以 center 为中心放得下最大的变体，再向四周各留 radius，裁到帧内；
+    // center 无效（有一维 <= 0，即还没有匹配到过）时为整帧
+    cv::Rect searchWindow(cv::Size frameSize, cv::Point center, int radius) const;
+
+    // pool 的含义同 parallelFor：不为空时提交到池里，为空时用 cv::parallel_for_
+    BankMatch match(const cv::Mat& image, cv::Rect searchRect, WorkStealingPool* pool = nullptr) const;
+
+private:
+    struct Variant {
+        double scale;
+        double angle;
+        TemplateMatcher matcher;
+    };
+
+    TemplateBankOptions options_;
+    std::vector<Variant> variants_;
+    cv::Size maxSize_;
+};
+
+}  // namespace haar
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace haar {
+
+struct TemplateMatch {
+    double score = -1.0;  // TM_CCOEFF_NORMED 得分
+    cv::Point location;   // 模板左上角，整图坐标
+};
+
+struct TemplateMatcherOptions {
+    int maxLevels = 2;                 // 粗搜最多下采样几层
+    int minCoarseSide = 8;             // 顶层模板短边不小于该值
+    int topK = 3;                      // 粗搜保留的候选峰数
+    int pyramidMinResultArea = 65536;  // 原分辨率结果图面积超过该值才走金字塔
+};
+
+// TM_CCOEFF_NORMED 模板匹配引擎：模板的均值、范数、金字塔和频谱只算一次。
+// 搜索区域较小时直接在原分辨率匹配，较大时（如跟丢后的整帧重捕获）先在金字塔顶层粗搜，
+// 再在原分辨率上精修得分最高的 topK 个峰。相关运算按搜索面积在空域和频域之间自动选择
+class TemplateMatcher {
+public:
+    explicit TemplateMatcher(const cv::Mat& templ, TemplateMatcherOptions options = TemplateMatcherOptions());
+
+    // 换一个模板（复制进来），各层的缓冲尺寸不变时原地复用；频谱缓存清空。不能与 match 同时调用
+    void reset(const cv::Mat& templ);
+
+    cv::Size size() const { return levels_[0].templ.size(); }
+
+    TemplateMatch match(const cv::Mat& image, cv::Rect searchRect) const;
+
+    // 只在原分辨率上匹配
+    TemplateMatch matchExact(const cv::Mat& image, cv::Rect searchRect) const;
+
+private:
+    struct Level {
+        cv::Mat templ;      // 8 位模板
+        cv::Mat zeroMean;   // 去均值后的 CV_32F 模板
+        double norm = 0.0;  // 去均值模板的 L2 范数
+        mutable std::map<std::pair<int, int>, cv::Mat> spectra;  // 按 DFT 尺寸缓存的模板频谱
+    };
+
+    // 在 image（已是某一层的搜索区域）上计算完整的得分图
+    void scoreMap(const cv::Mat& image, int level, cv::Mat& scores) const;
+    void correlateSpatial(const cv::Mat& image, const Level& lv, cv::Mat& corr) const;
+    void correlateDft(const cv::Mat& image, const Level& lv, cv::Mat& corr) const;
+
+    TemplateMatcherOptions options_;
+    std::vector<Level> levels_;
+    std::unique_ptr<std::mutex> spectraMutex_;  // 放在堆上，匹配器可以移动（模板库按值存放）
+};
+
+}  // namespace haar
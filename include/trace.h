@@ -0,0 +1,148 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// 热路径追踪：作用域 span + 整数标注，记在每个线程自己的定长环形缓冲里，
+// 结束时导出 Chrome trace JSON（chrome://tracing、Perfetto 可直接打开）和紧凑的二进制日志（trace_summary 汇总）。
+//
+//   HAAR_TRACE_SCOPE("haar.detect");          // 作用域结束时记一条 span
+//   HAAR_TRACE_ARG("roi_width", roi.width);   // 标注到本线程最内层未结束的 span 上
+//
+// 构建时不定义 HAAR_TRACING（CMake 选项 HAAR_TRACING=OFF）时两个宏展开为空；
+// 编译进来但运行时没有 --trace 时，每个 span 只多一次原子读。
+// StageTimer 的各阶段也作为 span 记录（见 latency_stats.h），名字即 stageName()
+
+namespace haar {
+namespace trace {
+
+constexpr int kMaxArgs = 6;            // 每个 span 最多保留的标注数，多出的丢弃
+constexpr size_t kRingCapacity = 1 << 15;  // 每个线程保留最近的 span 数
+
+struct Arg {
+    const char* key;  // 须为字符串常量
+    int64_t value;
+};
+
+// 环形缓冲里的一条记录；name / key 只存指针，导出时才转成字符串
+struct Event {
+    const char* name;
+    uint64_t startNs;  // 相对进程启动的时刻
+    uint64_t durationNs;
+    int argCount;
+    Arg args[kMaxArgs];
+};
+
+namespace detail {
+extern std::atomic<bool> active;
+}
+
+inline bool enabled() { return detail::active.load(std::memory_order_relaxed); }
+
+// 开始记录：结束时（flush() 或进程正常退出）写 <pathPrefix>.json 和 <pathPrefix>.trace
+void start(const std::string& pathPrefix);
+
+// 写出已记录的 span 并停止记录；须在各工作线程都不再记录之后调用。没有 start() 时什么也不做
+void flush();
+
+// 本线程在导出文件里显示的名字（如 "worker 3"），默认 "thread N"
+void setThreadName(const std::string& name);
+
+uint64_t nowNs();
+
+// 记一条 span。begin / end 分开，供 StageTimer 这种跨阶段复用同一对象的计时器使用
+class Span {
+public:
+    Span() = default;
+    explicit Span(const char* name) {
+        if (enabled()) begin(name);
+    }
+    ~Span() { end(); }
+
+    void begin(const char* name);
+    void end();
+    bool active() const { return active_; }
+    void arg(const char* key, int64_t value) {
+        if (argCount_ < kMaxArgs) args_[argCount_++] = {key, value};
+    }
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+private:
+    bool active_ = false;
+    const char* name_ = nullptr;
+    uint64_t start_ = 0;
+    int argCount_ = 0;
+    Arg args_[kMaxArgs];
+    Span* parent_ = nullptr;
+};
+
+// 标注到本线程最内层未结束的 span；没有时丢弃
+void annotate(const char* key, int64_t value);
+
+// ---- 二进制日志 ----
+// 文件头 + 字符串表（uint16 长度 + 字节）+ 线程表 + 事件（TraceFileEvent 后跟 argCount 个 TraceFileArg）
+// 均按本机字节序写出
+
+struct TraceFileHeader {
+    char magic[8];  // "HAARTRC"
+    uint32_t version;
+    uint32_t stringCount;
+    uint32_t threadCount;
+    uint32_t reserved;
+    uint64_t eventCount;
+};
+static_assert(sizeof(TraceFileHeader) == 32, "TraceFileHeader layout");
+
+struct TraceFileThread {
+    uint32_t id;
+    uint32_t nameId;
+};
+
+struct TraceFileEvent {
+    uint64_t startNs;
+    uint64_t durationNs;
+    uint32_t thread;
+    uint16_t nameId;
+    uint16_t argCount;
+};
+static_assert(sizeof(TraceFileEvent) == 24, "TraceFileEvent layout");
+
+struct TraceFileArg {
+    int64_t value;
+    uint32_t keyId;
+    uint32_t reserved;
+};
+static_assert(sizeof(TraceFileArg) == 16, "TraceFileArg layout");
+
+struct TraceRecord {
+    std::string name;
+    uint32_t thread = 0;
+    uint64_t startNs = 0, durationNs = 0;
+    std::vector<std::pair<std::string, int64_t>> args;
+};
+
+struct TraceLog {
+    std::vector<std::pair<uint32_t, std::string>> threads;  // 线程号与名字
+    std::vector<TraceRecord> events;                        // 按开始时刻排序，同时开始的外层在前
+};
+
+// 读取 start() 写出的二进制日志；格式不对时打印错误并返回 false
+bool readTraceLog(const std::string& path, TraceLog& log);
+
+}  // namespace trace
+}  // namespace haar
+
+#ifdef HAAR_TRACING
+#define HAAR_TRACE_CONCAT_(a, b) a##b
+#define HAAR_TRACE_CONCAT(a, b) HAAR_TRACE_CONCAT_(a, b)
+#define HAAR_TRACE_SCOPE(name) ::haar::trace::Span HAAR_TRACE_CONCAT(haarTraceSpan_, __LINE__)(name)
+#define HAAR_TRACE_ARG(key, value) ::haar::trace::annotate(key, static_cast<int64_t>(value))
+#else
+#define HAAR_TRACE_SCOPE(name) ((void)0)
+#define HAAR_TRACE_ARG(key, value) ((void)sizeof(value))  // 不求值，只免掉未使用变量的告警
+#endif
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <cmath>
+
+namespace haar {
+
+// 匀速模型的卡尔曼滤波，一帧为一个时间单位。过程噪声（离散白噪声加速度）和测量噪声都按轴独立，
+// x、y 两轴各是一个 2 维状态 (位置, 速度)，与 4 维的 cv::KalmanFilter 结果相同；
+// 状态和协方差都是定长成员，可以按值放进容器，predict / correct 不做堆分配
+class ConstantVelocityFilter {
+public:
+    explicit ConstantVelocityFilter(double accelerationStd = 2.0, double measurementStd = 4.0)
+        : q_(static_cast<float>(accelerationStd * accelerationStd)),
+          r_(static_cast<float>(measurementStd * measurementStd)) {}
+
+    // 首次测量：位置取测量值，速度为 0、标准差 velocityStd
+    void reset(cv::Point2f position, double velocityStd) {
+        const float v = static_cast<float>(velocityStd * velocityStd);
+        x_ = Axis{position.x, 0, r_, 0, v};
+        y_ = Axis{position.y, 0, r_, 0, v};
+    }
+
+    void predict() {
+        x_.predict(q_);
+        y_.predict(q_);
+    }
+    void correct(cv::Point2f measurement) {
+        x_.correct(measurement.x, r_);
+        y_.correct(measurement.y, r_);
+    }
+
+    cv::Point2f position() const { return cv::Point2f(x_.p, y_.p); }
+    cv::Point2f velocity() const { return cv::Point2f(x_.v, y_.v); }
+    // 位置估计的标准差
+    cv::Point2f positionStd() const { return cv::Point2f(std::sqrt(std::max(x_.pp, 0.f)), std::sqrt(std::max(y_.pp, 0.f))); }
+
+    // 测量值到当前位置估计的马氏距离（按新息协方差 P + R）
+    double distance(cv::Point2f measurement) const {
+        const double dx = measurement.x - x_.p, dy = measurement.y - y_.p;
+        return std::sqrt(dx * dx / (x_.pp + r_) + dy * dy / (y_.pp + r_));
+    }
+
+private:
+    struct Axis {
+        float p, v;        // 状态
+        float pp, pv, vv;  // 协方差
+
+        // x = F x，P = F P Fᵀ + Q，F = [1 1; 0 1]，Q = q [1/4 1/2; 1/2 1]
+        void predict(float q) {
+            p += v;
+            pp += 2 * pv + vv + q / 4;
+            pv += vv + q / 2;
+            vv += q;
+        }
+        // H = [1 0]
+        void correct(float z, float r) {
+            const float s = pp + r;
+            const float k0 = pp / s, k1 = pv / s;
+            const float y = z - p;
+            p += k0 * y;
+            v += k1 * y;
+            vv -= k1 * pv;
+            pv -= k0 * pv;
+            pp -= k0 * pp;
+        }
+    };
+
+    float q_, r_;
+    Axis x_{0, 0, 0, 0, 0}, y_{0, 0, 0, 0, 0};
+};
+
+}  // namespace haar
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+#include "search_window.h"
+
+namespace haar {
+
+struct TrackManagerOptions {
+    SearchWindowOptions window;   // 每条轨迹的搜索窗口与滤波参数
+    double gateSigmas = 4.0;      // 检测框中心到预测位置的马氏距离超过该值不关联
+    int confirmHits = 2;          // 连续命中几帧算确认；未确认的轨迹一帧未命中即删除
+    int fullScanInterval = 10;    // 有轨迹时每隔几帧整帧扫描一次找新目标；没有轨迹时每帧整帧扫描
+    int reacquireScans = 2;       // 已确认的轨迹丢失后接着整帧扫描几帧，按区域找新目标时也一样
+    size_t maxTracks = 8;
+    double nmsIou = 0.3;          // 各窗口的检测框合并时，IoU 不低于此值视为同一目标
+};
+
+struct Track {
+    int id = 0;
+    cv::Rect box;           // 最近一次关联到的检测框
+    int hits = 0;           // 连续命中帧数
+    bool confirmed = false;
+    bool updated = false;   // 本帧关联到了检测
+    SearchWindowPlanner planner;
+};
+
+// plan() 给出的一个检测窗口
+struct DetectionWindow {
+    int track = -1;         // 在 tracks() 中的下标；-1 为找新目标的扫描窗口（整帧或调用方给的区域）
+    SearchWindow window;
+};
+
+// 多目标跟踪：每条轨迹有自己的搜索窗口（定长匀速滤波 + 逐级放大，见 SearchWindowPlanner），
+// 各轨迹的窗口作为一批交给检测器（窗口之间互不依赖，可以并行）；找新目标的整帧扫描按 fullScanInterval
+// 的节奏单独进行，也可以由调用方每帧给出只需扫描的区域；整帧扫描帧不再查各轨迹的窗口。
+// 检测框按马氏距离门限贪心关联到轨迹，没关联上的新建轨迹，搜索窗口全部放大过仍未命中的轨迹删除。
+// 每帧先 plan()，把各窗口的检测结果（整幅图坐标）写进 detections(w)，再 update()
+class TrackManager {
+public:
+    explicit TrackManager(TrackManagerOptions options = {});
+
+    // 本帧要检测的窗口：各轨迹的窗口，或按 fullScanInterval 的节奏只有一个整帧窗口
+    const std::vector<DetectionWindow>& plan(cv::Size frameSize);
+    // 找新目标只查 scanRegions（如 MotionGate 给出的变化区域），各轨迹的窗口照常检测；
+    // fullScan 为 true 时与 plan(frameSize) 的扫描帧相同，只有一个整帧窗口。不再按 fullScanInterval 扫描，
+    // 但已确认的轨迹刚丢失时仍整帧扫描 reacquireScans 帧：悬停或慢速的目标很快被背景吸收，变化区域里找不到
+    const std::vector<DetectionWindow>& plan(cv::Size frameSize, const std::vector<cv::Rect>& scanRegions,
+                                             bool fullScan);
+    bool fullScan() const { return fullScan_; }
+
+    // 第 w 个窗口的检测结果，由调用方填写；不同窗口的缓冲可以在不同线程上同时写
+    std::vector<cv::Rect>& detections(size_t w) { return detections_[w]; }
+
+    void update();
+
+    const std::vector<Track>& tracks() const { return tracks_; }
+
+private:
+    void predict(cv::Size frameSize);
+    void scanFullFrame(cv::Size frameSize);
+    void finishPlan();
+    void lost(const Track& t);
+
+    TrackManagerOptions options_;
+    std::vector<Track> tracks_;
+    int nextId_ = 1;
+    int sinceFullScan_ = 0;
+    int reacquire_ = 0;  // 还要为丢失的轨迹整帧扫描几帧
+    bool fullScan_ = true;
+
+    // 逐帧复用的缓冲
+    std::vector<DetectionWindow> windows_;
+    std::vector<std::vector<cv::Rect>> detections_;
+    std::vector<cv::Rect> merged_;
+    struct Pair {
+        double distance;
+        size_t track, detection;
+    };
+    std::vector<Pair> pairs_;
+    std::vector<char> taken_;
+};
+
+}  // namespace haar
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace haar {
+
+// 运行时可调参数：检测器里影响速度与检出的数值（scaleFactor、minNeighbors、最小目标尺寸、搜索半径、
+// 匹配阈值、二值化阈值、Canny 阈值等）按名字取值，没有设置的用检测器源文件里的默认值。
+// 命令行用 --set name=value 或 --config 文件设置（见 result_sinks.h 的 parseOutputFlag），
+// 经 PipelineOptions::tunables 传给检测器；haar_sweep 按网格生成多组取值比较速度与检出。
+// 各检测器认哪些名字见其源文件开头的配置参数。加载模型时读过哪些名字记在对象里，加载后用 unread()
+// 找出拼错或没有检测器认的名字；取值范围由各检测器加载时检查（见 checkMin / checkAbove / checkRange）。
+// 因为要记录读过的名字，同一个对象不能同时给多个线程加载模型用，各自拷贝一份
+class Tunables {
+public:
+    void set(const std::string& name, double value) { values_[name] = value; }
+    bool has(const std::string& name) const { return values_.count(name) > 0; }
+    bool empty() const { return values_.empty(); }
+    const std::map<std::string, double>& values() const { return values_; }
+
+    double get(const std::string& name, double fallback) const;
+    // 取值须是 int 范围内的整数，不四舍五入；不是时返回 false，error 为 "Invalid tunable name=value (...)"
+    bool getInt(const std::string& name, int fallback, int& value, std::string& error) const;
+    // prefix_width / prefix_height，如 getSize("min", MIN_OBJECT, ...) 读 min_width、min_height；要求同 getInt
+    bool getSize(const std::string& prefix, cv::Size fallback, cv::Size& value, std::string& error) const;
+
+    // 解析 "name=value"；不合法时返回 false，不改变已有取值
+    bool parse(const std::string& assignment);
+    // 每行一个 name=value，# 之后为注释，空行忽略；出错时返回 false，error 为出错的行
+    bool load(const std::string& path, std::string& error);
+    // 按名字排序的 "name=value,name=value"，没有设置时为 "default"
+    std::string describe() const;
+
+    // 设置了、但 get / getInt / getSize 从没读过的名字（按名字排序）
+    std::vector<std::string> unread() const;
+    // 只保留读过的名字：参数扫描里检测器不认的维度不算一组不同的参数
+    Tunables readOnly() const;
+
+private:
+    std::map<std::string, double> values_;
+    mutable std::set<std::string> read_;
+};
+
+// 加载模型时检查参数取值，不满足时返回 false，error 为 "Invalid tunable name=value (...)"
+bool checkMin(const std::string& name, double value, double lo, std::string& error);    // value >= lo
+bool checkAbove(const std::string& name, double value, double lo, std::string& error);  // value > lo
+bool checkRange(const std::string& name, double value, double lo, double hi, std::string& error);  // [lo, hi]
+// 名字列表拼成 "a, b"，用于报告 unread() 的结果
+std::string joinNames(const std::vector<std::string>& names);
+
+}  // namespace haar
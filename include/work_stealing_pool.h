@@ -0,0 +1,73 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace haar {
+
+// 工作窃取线程池，任务分两级：
+// - 顶层任务（一整条序列）进共享 FIFO，只由空闲的工作线程领取；
+// - 细粒度任务（解码、编码一帧）进提交线程自己的双端队列，自己从队尾取（LIFO，缓存热），
+//   其他线程没活时从队头窃取。
+// 这样长序列拖到最后时，它的解码/编码会被其他核分走，各核在序列长度不一时也能保持忙碌
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    // threads <= 0 时取硬件并发数
+    explicit WorkStealingPool(int threads = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    int threadCount() const { return static_cast<int>(threads_.size()); }
+
+    void submitRoot(Task task);
+    void submit(Task task);
+
+    // 等待 done() 成立，期间帮忙执行细粒度任务（不领顶层任务，免得一条序列被另一条整段卡住）。
+    // done() 的结果只能因为池内任务完成或调用线程自己的动作而改变
+    void helpUntil(const std::function<bool()>& done);
+
+    // 等待所有已提交任务完成；任务抛出的第一个异常在这里重新抛出
+    void wait();
+
+private:
+    struct TaskQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void workerLoop(size_t index);
+    bool takeTask(Task& task);
+    bool takeRoot(Task& task);
+    void execute(Task& task);
+    size_t localIndex() const;
+    void signal();
+
+    std::vector<std::unique_ptr<TaskQueue>> queues_;  // 每个工作线程一个，最后一个给池外线程
+    TaskQueue roots_;
+    std::vector<std::thread> threads_;
+
+    std::mutex stateMutex_;
+    std::condition_variable changed_;
+    size_t generation_ = 0;  // 每次提交或完成任务加一，等待方据此判断是否需要重新检查
+    size_t outstanding_ = 0;
+    bool stopping_ = false;
+    std::exception_ptr error_;
+};
+
+// 并行执行 body(0) .. body(n - 1)，全部完成后返回，第一个异常在这里重新抛出。
+// pool 不为空时作为细粒度任务提交到池里、调用线程也参与（须在池的工作线程或池外线程上调用）；
+// 为空时用 cv::parallel_for_。n 只有 1 时直接在调用线程上执行
+void parallelFor(WorkStealingPool* pool, size_t n, const std::function<void(size_t)>& body);
+
+}  // namespace haar
@@ -0,0 +1,134 @@
+#include "alloc_counter.h"
+
+#include <algorithm>
+#include <iostream>
+
+#ifdef HAAR_COUNT_ALLOCATIONS
+#include <opencv2/opencv.hpp>
+#include <cstdlib>
+#include <new>
+#endif
+
+using namespace std;
+
+namespace haar {
+
+#ifdef HAAR_COUNT_ALLOCATIONS
+
+namespace {
+
+thread_local size_t tlsAllocations = 0;
+
+void* countedAlloc(size_t n) {
+    ++tlsAllocations;
+    return malloc(n ? n : 1);
+}
+
+void* countedAlignedAlloc(size_t n, size_t align) {
+    ++tlsAllocations;
+    void* p = nullptr;
+#ifdef _WIN32
+    p = _aligned_malloc(n ? n : 1, align);
+#else
+    if (posix_memalign(&p, max(align, sizeof(void*)), n ? n : 1) != 0) p = nullptr;
+#endif
+    return p;
+}
+
+void alignedFree(void* p) {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
+// Mat 的数据缓冲由 StdMatAllocator 用 fastMalloc 分配；包一层只为计数，释放仍由 UMatData 记下的原分配器完成
+class CountingMatAllocator : public cv::MatAllocator {
+public:
+    CountingMatAllocator() : base_(cv::Mat::getStdAllocator()) {}
+
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override {
+        if (!data) ++tlsAllocations;
+        return base_->allocate(dims, sizes, type, data, step, flags, usageFlags);
+    }
+    bool allocate(cv::UMatData* data, cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override {
+        return base_->allocate(data, flags, usageFlags);
+    }
+    void deallocate(cv::UMatData* data) const override { base_->deallocate(data); }
+
+private:
+    cv::MatAllocator* base_;
+};
+
+struct InstallMatAllocator {
+    InstallMatAllocator() {
+        static CountingMatAllocator allocator;
+        cv::Mat::setDefaultAllocator(&allocator);
+    }
+} installMatAllocator;
+
+}  // namespace
+
+bool allocationCountingEnabled() { return true; }
+size_t threadAllocationCount() { return tlsAllocations; }
+
+#else
+
+bool allocationCountingEnabled() { return false; }
+size_t threadAllocationCount() { return 0; }
+
+#endif
+
+void AllocationStats::add(size_t allocations) {
+    if (frames++ < warmupFrames) return;
+    ++steadyFrames;
+    steadyAllocations += allocations;
+    if (allocations > 0) ++steadyFramesWithAllocations;
+    maxPerFrame = max(maxPerFrame, allocations);
+}
+
+void AllocationStats::print(const char* what) const {
+    if (steadyFrames == 0) return;
+    cout << (steadyFramesWithAllocations == 0 ? "✅" : "⚠️") << " Heap allocations in " << what
+         << ": " << steadyFrames - steadyFramesWithAllocations << "/" << steadyFrames
+         << " steady-state frames allocation-free, " << steadyAllocations << " total, max "
+         << maxPerFrame << " per frame" << endl;
+}
+
+}  // namespace haar
+
+#ifdef HAAR_COUNT_ALLOCATIONS
+
+void* operator new(std::size_t n) {
+    if (void* p = haar::countedAlloc(n)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t n) {
+    if (void* p = haar::countedAlloc(n)) return p;
+    throw std::bad_alloc();
+}
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept { return haar::countedAlloc(n); }
+void* operator new[](std::size_t n, const std::nothrow_t&) noexcept { return haar::countedAlloc(n); }
+void* operator new(std::size_t n, std::align_val_t a) {
+    if (void* p = haar::countedAlignedAlloc(n, static_cast<std::size_t>(a))) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t n, std::align_val_t a) {
+    if (void* p = haar::countedAlignedAlloc(n, static_cast<std::size_t>(a))) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { haar::alignedFree(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { haar::alignedFree(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { haar::alignedFree(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { haar::alignedFree(p); }
+
+#endif
@@ -0,0 +1,6 @@
+#include "detector_registry.h"
+
+// 检测器逻辑在 haar 库里（见 detector_registry.h），这里只解析参数并跑序列
+int main(int argc, char** argv) {
+    return haar::detectorMain("detect_drone_template", argc, argv);
+}
@@ -0,0 +1,89 @@
+#include "batch_runner.h"
+#include "work_stealing_pool.h"
+
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+
+namespace fs = std::filesystem;
+using namespace std;
+
+namespace haar {
+
+string sequenceName(const string& folder) {
+    fs::path p = fs::path(folder).lexically_normal();
+    if (p.filename().empty()) p = p.parent_path();  // 末尾带 '/'
+    if (fs::is_regular_file(p)) return p.stem().string();  // 打包帧文件去掉扩展名
+    return p.filename().string();
+}
+
+BatchReport runBatch(const vector<string>& folders, const SequenceJob& job, int threads) {
+    BatchReport report;
+    report.sequences.resize(folders.size());
+
+    auto start = chrono::steady_clock::now();
+    {
+        WorkStealingPool pool(threads);
+        report.threads = pool.threadCount();
+        for (size_t s = 0; s < folders.size(); ++s) {
+            pool.submitRoot([&, s] {
+                auto t0 = chrono::steady_clock::now();
+                SequenceReport r;
+                try {
+                    r = job(folders[s], pool);
+                } catch (const exception& e) {
+                    r = SequenceReport();
+                    r.error = e.what();
+                } catch (...) {
+                    r = SequenceReport();
+                    r.error = "unknown exception";
+                }
+                r.seconds = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+                if (r.name.empty()) r.name = sequenceName(folders[s]);
+                report.sequences[s] = r;
+            });
+        }
+        pool.wait();
+    }
+    report.wallSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return report;
+}
+
+void printBatchReport(const BatchReport& report) {
+    size_t frames = 0, detected = 0, failed = 0;
+    double busySeconds = 0.0;
+
+    cout << "📊 Batch report (" << report.sequences.size() << " sequences, "
+         << report.threads << " threads)" << endl;
+    cout << fixed << setprecision(2);
+    for (const auto& s : report.sequences) {
+        if (!s.error.empty()) {
+            cout << "❌ " << s.name << " | Failed: " << s.error << " | Time: " << s.seconds << " s" << endl;
+            ++failed;
+            busySeconds += s.seconds;
+            continue;
+        }
+        double rate = s.frames ? 100.0 * s.detected / s.frames : 0.0;
+        double fps = s.seconds > 0 ? s.frames / s.seconds : 0.0;
+        cout << "   " << s.name << " | Frames: " << s.frames << " | Detected: " << s.detected
+             << " (" << rate << "%) | Time: " << s.seconds << " s | " << fps << " FPS";
+        if (s.droppedBoxes > 0) cout << " | ⚠️ Dropped boxes: " << s.droppedBoxes;
+        cout << endl;
+        frames += s.frames;
+        detected += s.detected;
+        busySeconds += s.seconds;
+    }
+
+    double rate = frames ? 100.0 * detected / frames : 0.0;
+    double fps = report.wallSeconds > 0 ? frames / report.wallSeconds : 0.0;
+    double overlap = report.wallSeconds > 0 ? busySeconds / report.wallSeconds : 0.0;
+    cout << (failed ? "❌" : "✅") << " Total | Frames: " << frames << " | Detected: " << detected << " (" << rate
+         << "%) | Wall: " << report.wallSeconds << " s | Throughput: " << fps << " FPS"
+         << " | Sequence overlap: " << overlap << "x";
+    if (failed > 0) cout << " | Failed: " << failed << "/" << report.sequences.size();
+    cout << endl;
+}
+
+}  // namespace haar
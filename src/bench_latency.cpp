@@ -0,0 +1,256 @@
+// 延迟基准：把所有检测器依次跑过自带序列，统计各阶段 p50/p95/p99/max 与帧率，结果写成 JSON。
+// 给了 --baseline 时与该基线比较，退化超出容差、基线里的检测器或阶段没有结果（--detector 排除的除外）、
+// 或基线读不出来时返回非零；不给时只测量不判定。任何检测器加载失败都直接返回非零，不跑也不写基线。
+// 基线须在参考机器上用 --update-baseline 生成（默认写到 assetRoot 下的 bench/latency_baseline.json），
+// 仓库里有了才把 --baseline 接进回归检查，别的机器上测出的数字不能当基线。
+// 模型、自带序列与默认的结果 / 输出目录都在 --assets 目录下（默认 defaultAssetRoot()，即 HAAR_ASSETS 或 ".."）
+//
+// 用法：bench_latency [--baseline 文件] [--out 文件] [--tolerance 0.10] [--slack-ms 0.25]
+//                     [--detector 名称]... [--update-baseline] [--assets 目录] [--sink 输出...] [--trace 前缀]
+//                     [--set 名称=取值]... [--config 文件] [序列目录...]
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <map>
+
+#include "batch_runner.h"
+#include "detector_registry.h"
+#include "frame_pipeline.h"
+#include "latency_stats.h"
+#include "result_sinks.h"
+
+namespace fs = std::filesystem;
+using namespace cv;
+using namespace std;
+using namespace haar;
+
+// 路径相对 assetRoot
+const string BASELINE_FILE = "bench/latency_baseline.json";
+const string RESULT_FILE   = "output/bench_latency.json";
+const string OUTPUT_FOLDER = "output/bench";
+const vector<string> DEFAULT_SEQUENCES = {"img/video_01", "img/video_02", "img/video_03", "img/video_04"};
+
+struct BenchResult {
+    size_t frames = 0;
+    size_t detected = 0;
+    double fps = 0.0;
+    LatencySummary stages[STAGE_COUNT];
+};
+
+static void writeResults(const string& path, const map<string, BenchResult>& results) {
+    fs::create_directories(fs::path(path).parent_path());
+    FileStorage out(path, FileStorage::WRITE | FileStorage::FORMAT_JSON);
+    out << "detectors" << "{";
+    for (const auto& [name, r] : results) {
+        out << name << "{";
+        out << "frames" << static_cast<int>(r.frames);
+        out << "detected" << static_cast<int>(r.detected);
+        out << "fps" << r.fps;
+        out << "stages" << "{";
+        for (int s = 0; s < STAGE_COUNT; ++s) {
+            const LatencySummary& l = r.stages[s];
+            if (l.count == 0) continue;
+            out << stageName(static_cast<Stage>(s)) << "{"
+                << "count" << static_cast<int>(l.count)
+                << "p50_ms" << l.p50 << "p95_ms" << l.p95 << "p99_ms" << l.p99 << "max_ms" << l.max
+                << "}";
+        }
+        out << "}" << "}";
+    }
+    out << "}";
+}
+
+static bool selected(const vector<string>& onlyDetectors, const string& name) {
+    return onlyDetectors.empty() || find(onlyDetectors.begin(), onlyDetectors.end(), name) != onlyDetectors.end();
+}
+
+// 只比较 p50/p95/p99 和帧率；max 受单帧抖动影响太大，只报告不判定。基线里有、这次选中却没有结果的
+// 检测器或阶段也算退化，否则跑挂的检测器会被当成没有退化。返回退化项数，基线读不出来时返回 -1
+static int compareWithBaseline(const string& path, const map<string, BenchResult>& results,
+                               const vector<string>& onlyDetectors, double tolerance, double slackMs) {
+    FileStorage base(path, FileStorage::READ | FileStorage::FORMAT_JSON);
+    if (!base.isOpened()) {
+        cerr << "❌ Cannot read baseline " << path << " (create it on the reference machine with --update-baseline)"
+             << endl;
+        return -1;
+    }
+
+    int regressions = 0;
+    FileNode detectors = base["detectors"];
+    for (const FileNode& d : detectors) {
+        if (!selected(onlyDetectors, d.name())) continue;
+        auto it = results.find(d.name());
+        if (it == results.end()) {
+            cout << "❌ " << d.name() << " is in the baseline but produced no result" << endl;
+            ++regressions;
+            continue;
+        }
+        const BenchResult& r = it->second;
+
+        double baseFps = (double)d["fps"];
+        if (r.fps < baseFps * (1.0 - tolerance)) {
+            cout << "❌ " << d.name() << " fps " << r.fps << " < baseline " << baseFps << endl;
+            ++regressions;
+        }
+
+        FileNode stages = d["stages"];
+        for (int s = 0; s < STAGE_COUNT; ++s) {
+            const char* stage = stageName(static_cast<Stage>(s));
+            FileNode b = stages[stage];
+            if (b.empty()) continue;
+            if (r.stages[s].count == 0) {
+                cout << "❌ " << d.name() << " " << stage << " is in the baseline but recorded no samples" << endl;
+                ++regressions;
+                continue;
+            }
+            const pair<const char*, double> checks[] = {
+                {"p50_ms", r.stages[s].p50}, {"p95_ms", r.stages[s].p95}, {"p99_ms", r.stages[s].p99}};
+            for (const auto& [key, value] : checks) {
+                double limit = (double)b[key] * (1.0 + tolerance) + slackMs;
+                if (value > limit) {
+                    cout << "❌ " << d.name() << " " << stage << " " << key << " " << value
+                         << " ms > limit " << limit << " ms" << endl;
+                    ++regressions;
+                }
+            }
+        }
+    }
+
+    if (regressions == 0) {
+        cout << "✅ No regression against " << path << " (tolerance " << tolerance * 100 << "%)" << endl;
+    }
+    return regressions;
+}
+
+int main(int argc, char** argv) {
+    string assetRoot = defaultAssetRoot();
+    string baselinePath;  // 为空时不与基线比较
+    string resultPath;    // 为空时为 assetRoot 下的 RESULT_FILE
+    double tolerance = 0.10;
+    double slackMs = 0.25;  // 亚毫秒级阶段的绝对余量，避免计时抖动误报
+    bool updateBaseline = false;
+    vector<string> onlyDetectors;
+    vector<string> sequences;
+    PipelineOptions base;  // --sink 等输出参数与 --set / --config 调参，同各检测器
+
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        auto value = [&]() -> string {
+            if (i + 1 >= argc) {
+                cerr << "❌ Missing value for " << arg << endl;
+                exit(2);
+            }
+            return argv[++i];
+        };
+        if (arg == "--baseline") baselinePath = value();
+        else if (arg == "--out") resultPath = value();
+        else if (arg == "--assets") assetRoot = value();
+        else if (arg == "--tolerance") tolerance = stod(value());
+        else if (arg == "--slack-ms") slackMs = stod(value());
+        else if (arg == "--detector") onlyDetectors.push_back(value());
+        else if (arg == "--update-baseline") updateBaseline = true;
+        else if (parseOutputFlag(argc, argv, i, base)) continue;
+        else sequences.push_back(arg);
+    }
+    if (resultPath.empty()) resultPath = assetPath(assetRoot, RESULT_FILE);
+    const string outputFolder = assetPath(assetRoot, OUTPUT_FOLDER);
+    if (sequences.empty()) {
+        for (const auto& s : DEFAULT_SEQUENCES) {
+            const string path = assetPath(assetRoot, s);
+            if (fs::is_directory(path)) sequences.push_back(path);
+        }
+    }
+    if (sequences.empty()) {
+        cerr << "❌ No sequences to benchmark" << endl;
+        return 2;
+    }
+
+    for (const auto& name : onlyDetectors) {
+        if (!findDetector(name)) {
+            cerr << "❌ Unknown detector: " << name << endl;
+            return 2;
+        }
+    }
+
+    // 先把模型都加载好（不计入延迟），--set / --config 里没有任何检测器认的名字在跑之前就报错。
+    // 选中的检测器有一个加载失败就不跑：少一个检测器的结果既不能通过比较，也不能写成基线
+    vector<pair<const RegisteredDetector*, unique_ptr<DetectorModel>>> models;
+    int failed = 0;
+    for (const auto& det : registeredDetectors()) {
+        if (!selected(onlyDetectors, det.name)) continue;
+        string error;
+        unique_ptr<DetectorModel> model = det.load(assetRoot, base.tunables, error);
+        if (!model) {
+            cerr << "❌ " << det.name << ": " << error << endl;
+            ++failed;
+            continue;
+        }
+        models.emplace_back(&det, std::move(model));
+    }
+    if (failed > 0) {
+        cerr << "❌ " << failed << " detector(s) failed to load" << endl;
+        return 1;
+    }
+    const vector<string> unknown = base.tunables.unread();
+    if (!models.empty() && !unknown.empty()) {
+        cerr << "❌ Unknown tunable: " << joinNames(unknown) << endl;
+        return 2;
+    }
+
+    map<string, BenchResult> results;
+    for (auto& [detector, model] : models) {
+        const RegisteredDetector& det = *detector;
+
+        // 逐条序列顺序跑，不开批处理，测的是单序列延迟而不是多序列争抢下的延迟
+        LatencyRecorder recorder;
+        PipelineOptions options = base;
+        options.latency = &recorder;
+
+        BenchResult r;
+        auto start = chrono::steady_clock::now();
+        for (const auto& seq : sequences) {
+            SequenceReport rep =
+                runSequence(*model, det, seq, outputFolder + "/" + det.name + "/" + sequenceName(seq), options, false);
+            r.frames += rep.frames;
+            r.detected += rep.detected;
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        r.fps = seconds > 0 ? r.frames / seconds : 0.0;
+        for (int s = 0; s < STAGE_COUNT; ++s) r.stages[s] = recorder.summary(static_cast<Stage>(s));
+        results[det.name] = r;
+
+        cout << "📊 " << det.name << " | Frames: " << r.frames << " | " << fixed << setprecision(2)
+             << r.fps << " FPS" << endl;
+        for (int s = 0; s < STAGE_COUNT; ++s) {
+            const LatencySummary& l = r.stages[s];
+            if (l.count == 0) continue;
+            cout << "   " << left << setw(10) << stageName(static_cast<Stage>(s)) << right
+                 << " p50 " << setw(7) << l.p50 << " | p95 " << setw(7) << l.p95
+                 << " | p99 " << setw(7) << l.p99 << " | max " << setw(7) << l.max << " ms" << endl;
+        }
+    }
+
+    if (results.empty()) {
+        cerr << "❌ No detector matched" << endl;
+        return 2;
+    }
+
+    writeResults(resultPath, results);
+    cout << "✅ Results written to " << resultPath << endl;
+
+    if (updateBaseline) {
+        const string path = baselinePath.empty() ? assetPath(assetRoot, BASELINE_FILE) : baselinePath;
+        writeResults(path, results);
+        cout << "✅ Baseline updated: " << path << endl;
+        return 0;
+    }
+    if (baselinePath.empty()) {
+        cout << "ℹ️ No --baseline given, regression check skipped" << endl;
+        return 0;
+    }
+    const int regressions = compareWithBaseline(baselinePath, results, onlyDetectors, tolerance, slackMs);
+    return regressions < 0 ? 2 : regressions > 0 ? 1 : 0;
+}
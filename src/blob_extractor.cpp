@@ -0,0 +1,290 @@
+#include "blob_extractor.h"
+#include "trace.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define HAAR_BLOB_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define HAAR_BLOB_NEON
+#endif
+
+using namespace cv;
+using namespace std;
+
+namespace haar {
+
+BlobExtractor::BlobExtractor(BlobExtractorOptions options)
+    : options_(options), radius_(max(options.closeSize, 1) / 2) {
+    dilated_.resize(2 * radius_ + 1);
+    eroded_.resize(2 * radius_ + 1);
+    if (options_.closeSize > 1) {
+        closeKernel_ = getStructuringElement(MORPH_RECT, Size(options_.closeSize, options_.closeSize));
+    }
+}
+
+// 一行灰度 → 前景游程。16 像素一组比较，整组与当前状态相同（全在游程内或全在外）时直接跳过，
+// 只在有跳变的组里逐像素找边界；x86-64 用 SSE2、AArch64 用 NEON，都是基线指令集，不需要运行时分派
+void BlobExtractor::binarize(const uchar* row, int width, RunList& out) const {
+    out.clear();
+    const int t = options_.threshold;
+    bool inRun = false;
+    int begin = 0;
+    auto scan = [&](int from, int to) {
+        for (int x = from; x < to; ++x) {
+            bool fg = row[x] > t;
+            if (fg == inRun) continue;
+            if (fg) begin = x;
+            else out.push_back({begin, x});
+            inRun = fg;
+        }
+    };
+
+    int x = 0;
+    if (t >= 0 && t < 255) {
+#if defined(HAAR_BLOB_SSE2)
+        // 无符号比较：两边都翻转最高位后做有符号比较
+        const __m128i bias = _mm_set1_epi8(char(0x80));
+        const __m128i th = _mm_set1_epi8(char(t ^ 0x80));
+        for (; x + 16 <= width; x += 16) {
+            __m128i v = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x)), bias);
+            int mask = _mm_movemask_epi8(_mm_cmpgt_epi8(v, th));
+            if (mask == (inRun ? 0xFFFF : 0)) continue;
+            scan(x, x + 16);
+        }
+#elif defined(HAAR_BLOB_NEON)
+        const uint8x16_t th = vdupq_n_u8(uint8_t(t));
+        for (; x + 16 <= width; x += 16) {
+            uint8x16_t m = vcgtq_u8(vld1q_u8(row + x), th);
+            if (inRun ? vminvq_u8(m) == 0xFF : vmaxvq_u8(m) == 0) continue;
+            scan(x, x + 16);
+        }
+#endif
+    }
+    scan(x, width);
+    if (inRun) out.push_back({begin, width});
+}
+
+// 行内膨胀：游程向两边各扩 radius_，越出图像的部分不算（图外按 0），相接的游程合并
+void BlobExtractor::dilateRow(const RunList& runs, int width, RunList& out) const {
+    out.clear();
+    for (const Run& r : runs) {
+        Run d{max(r.begin - radius_, 0), min(r.end + radius_, width)};
+        if (!out.empty() && d.begin <= out.back().end) out.back().end = max(out.back().end, d.end);
+        else out.push_back(d);
+    }
+}
+
+// 行内腐蚀：游程两端各缩 radius_；图外按前景处理（同 OpenCV 腐蚀的默认边界），贴边的一端不缩
+void BlobExtractor::erodeRow(const RunList& runs, int width, RunList& out) const {
+    out.clear();
+    for (const Run& r : runs) {
+        Run e{r.begin == 0 ? 0 : r.begin + radius_, r.end == width ? width : r.end - radius_};
+        if (e.begin < e.end) out.push_back(e);
+    }
+}
+
+// 跨行膨胀：dilated_ 中第 first..last 行的并集
+void BlobExtractor::unionRows(int first, int last, RunList& out) {
+    const int k = int(dilated_.size());
+    scratch_.clear();
+    for (int y = first; y <= last; ++y) {
+        const RunList& rows = dilated_[y % k];
+        scratch_.insert(scratch_.end(), rows.begin(), rows.end());
+    }
+    sort(scratch_.begin(), scratch_.end(), [](const Run& a, const Run& b) { return a.begin < b.begin; });
+
+    out.clear();
+    for (const Run& r : scratch_) {
+        if (!out.empty() && r.begin <= out.back().end) out.back().end = max(out.back().end, r.end);
+        else out.push_back(r);
+    }
+}
+
+// 跨行腐蚀：eroded_ 中第 first..last 行的交集；窗口伸出图像的行按整行前景处理，直接不参与
+void BlobExtractor::intersectRows(int first, int last, RunList& out) {
+    const int k = int(eroded_.size());
+    out = eroded_[first % k];
+    for (int y = first + 1; y <= last && !out.empty(); ++y) {
+        const RunList& other = eroded_[y % k];
+        scratch_.clear();
+        size_t i = 0, j = 0;
+        while (i < out.size() && j < other.size()) {
+            int b = max(out[i].begin, other[j].begin);
+            int e = min(out[i].end, other[j].end);
+            if (b < e) scratch_.push_back({b, e});
+            if (out[i].end < other[j].end) ++i;
+            else ++j;
+        }
+        out.swap(scratch_);
+    }
+}
+
+int BlobExtractor::find(int label) {
+    while (parent_[label] != label) {
+        parent_[label] = parent_[parent_[label]];
+        label = parent_[label];
+    }
+    return label;
+}
+
+void BlobExtractor::unite(int a, int b) {
+    a = find(a);
+    b = find(b);
+    if (a == b) return;
+    if (b < a) swap(a, b);
+    parent_[b] = a;
+    Component& ca = components_[a];
+    const Component& cb = components_[b];
+    ca.x0 = min(ca.x0, cb.x0);
+    ca.y0 = min(ca.y0, cb.y0);
+    ca.x1 = max(ca.x1, cb.x1);
+    ca.y1 = max(ca.y1, cb.y1);
+}
+
+int BlobExtractor::findBackground(int label) {
+    while (bgParent_[label] != label) {
+        bgParent_[label] = bgParent_[bgParent_[label]];
+        label = bgParent_[label];
+    }
+    return label;
+}
+
+void BlobExtractor::uniteBackground(int a, int b) {
+    a = findBackground(a);
+    b = findBackground(b);
+    if (a == b) return;
+    bgParent_[b] = a;
+    bgOuter_[a] = bgOuter_[a] || bgOuter_[b];
+}
+
+// 前景游程先拿一个新标号，再与上一行 8 邻接（含对角）的游程合并；
+// 两段前景之间的背景游程与上一行 4 邻接（有公共列）的背景游程合并
+void BlobExtractor::labelRow(const RunList& runs, int y, int width, int height) {
+    bgRuns_.clear();
+    int x = 0;
+    for (const Run& r : runs) {
+        if (x < r.begin) bgRuns_.push_back({x, r.begin});
+        x = r.end;
+    }
+    if (x < width) bgRuns_.push_back({x, width});
+
+    curBgLabels_.clear();
+    size_t j = 0;
+    const bool borderRow = y == 0 || y == height - 1;
+    for (const Run& r : bgRuns_) {
+        int label = int(bgParent_.size());
+        bgParent_.push_back(label);
+        bgOuter_.push_back(borderRow || r.begin == 0 || r.end == width);
+
+        while (j < prevBgRuns_.size() && prevBgRuns_[j].end <= r.begin) ++j;
+        for (size_t k = j; k < prevBgRuns_.size() && prevBgRuns_[k].begin < r.end; ++k) {
+            uniteBackground(label, prevBgLabels_[k]);
+        }
+        curBgLabels_.push_back(label);
+    }
+
+    curLabels_.clear();
+    j = 0;
+    size_t bg = 0;
+    for (const Run& r : runs) {
+        int label = int(parent_.size());
+        parent_.push_back(label);
+        components_.push_back({r.begin, y, r.end - 1, y});
+
+        // 连通域光栅顺序的第一个像素左边的背景必定在包围它的区域里，不可能是它自己的洞
+        while (bg < bgRuns_.size() && bgRuns_[bg].end < r.begin) ++bg;
+        enclosing_.push_back(r.begin == 0 ? -1 : curBgLabels_[bg]);
+
+        while (j < prevRuns_.size() && prevRuns_[j].end < r.begin) ++j;
+        for (size_t k = j; k < prevRuns_.size() && prevRuns_[k].begin <= r.end; ++k) {
+            unite(label, prevLabels_[k]);
+        }
+        curLabels_.push_back(label);
+    }
+
+    prevRuns_ = runs;
+    prevLabels_.swap(curLabels_);
+    prevBgRuns_.swap(bgRuns_);
+    prevBgLabels_.swap(curBgLabels_);
+}
+
+// 游程实现要对上的原流程：面积相同时保持 findContours 的输出顺序
+const vector<Rect>& BlobExtractor::extractOpenCV(const Mat& gray) {
+    threshold(gray, binary_, options_.threshold, 255, THRESH_BINARY);
+    if (options_.closeSize > 1) morphologyEx(binary_, binary_, MORPH_CLOSE, closeKernel_);
+    findContours(binary_, contours_, RETR_EXTERNAL, CHAIN_APPROX_SIMPLE);
+    HAAR_TRACE_ARG("components", contours_.size());
+
+    blobs_.clear();
+    for (const auto& c : contours_) blobs_.push_back(boundingRect(c));
+    stable_sort(blobs_.begin(), blobs_.end(), [](const Rect& a, const Rect& b) { return a.area() > b.area(); });
+    if (blobs_.size() > options_.maxBlobs) blobs_.resize(options_.maxBlobs);
+    return blobs_;
+}
+
+// 第 t 步读入源行 t 并做行内膨胀；跨行膨胀和腐蚀各需要上下 radius_ 行，
+// 所以闭运算结果比读入晚 2 * radius_ 行，环形缓冲只保留窗口内的行
+const vector<Rect>& BlobExtractor::extract(const Mat& gray) {
+    HAAR_TRACE_SCOPE("blobs.extract");
+    CV_Assert(gray.type() == CV_8UC1);
+    if (!options_.runLength) return extractOpenCV(gray);
+    const int width = gray.cols, height = gray.rows;
+    const int r = radius_, k = 2 * r + 1;
+
+    parent_.clear();
+    components_.clear();
+    enclosing_.clear();
+    prevRuns_.clear();
+    prevLabels_.clear();
+    bgParent_.clear();
+    bgOuter_.clear();
+    prevBgRuns_.clear();
+    prevBgLabels_.clear();
+
+    for (int t = 0; t < height + 2 * r; ++t) {
+        if (t < height) {
+            binarize(gray.ptr<uchar>(t), width, runs_);
+            dilateRow(runs_, width, dilated_[t % k]);
+        }
+        int yd = t - r;
+        if (yd >= 0 && yd < height) {
+            unionRows(max(yd - r, 0), min(yd + r, height - 1), merged_);
+            erodeRow(merged_, width, eroded_[yd % k]);
+        }
+        int yc = t - 2 * r;
+        if (yc >= 0 && yc < height) {
+            intersectRows(max(yc - r, 0), min(yc + r, height - 1), merged_);
+            labelRow(merged_, yc, width, height);
+        }
+    }
+
+    // 只留外层连通域：包围它的背景碰到图像边界（或它自己贴着左边界）。
+    // 面积相同时根标号大（起点靠后）的在前，与 findContours 的输出顺序一致
+    roots_.clear();
+    for (int i = 0; i < int(parent_.size()); ++i) {
+        if (parent_[i] != i) continue;
+        if (enclosing_[i] < 0 || bgOuter_[findBackground(enclosing_[i])]) roots_.push_back(i);
+    }
+    auto area = [&](int i) {
+        const Component& c = components_[i];
+        return (c.x1 - c.x0 + 1) * (c.y1 - c.y0 + 1);
+    };
+    size_t n = min(options_.maxBlobs, roots_.size());
+    HAAR_TRACE_ARG("components", roots_.size());
+    partial_sort(roots_.begin(), roots_.begin() + n, roots_.end(), [&](int a, int b) {
+        int aa = area(a), ab = area(b);
+        return aa != ab ? aa > ab : a > b;
+    });
+
+    blobs_.clear();
+    for (size_t i = 0; i < n; ++i) {
+        const Component& c = components_[roots_[i]];
+        blobs_.emplace_back(c.x0, c.y0, c.x1 - c.x0 + 1, c.y1 - c.y0 + 1);
+    }
+    return blobs_;
+}
+
+}  // namespace haar
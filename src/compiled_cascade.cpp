@@ -0,0 +1,74 @@
+#include "compiled_cascade.h"
+#include "compiled_cascade_kernel.h"
+#include "compiled_cascades.gen.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace fs = std::filesystem;
+using namespace cv;
+using namespace std;
+
+namespace haar {
+
+static uint64_t compiledHash(const string& fileName) {
+#define HAAR_CASCADE_HASH(Model) \
+    if (fileName == generated::Model::kFileName) return generated::Model::kSourceHash;
+    HAAR_FOR_EACH_COMPILED_CASCADE(HAAR_CASCADE_HASH)
+#undef HAAR_CASCADE_HASH
+    return 0;
+}
+
+// XML 改过但还没重新生成时，宁可退回 OpenCV 也不能用旧模型
+static bool matchesCompiled(const string& path, const string& fileName) {
+    const uint64_t expected = compiledHash(fileName);
+    if (expected == 0) return false;
+
+    ifstream in(path, ios::binary);
+    if (!in) return false;
+    string bytes((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    return fnv1a64(bytes.data(), bytes.size()) == expected;
+}
+
+shared_ptr<const CompiledCascade> loadCompiledCascade(const string& path) {
+    const string fileName = fs::path(path).filename().string();
+    if (!matchesCompiled(path, fileName)) return nullptr;
+
+#if defined(HAAR_HAVE_AVX2)
+    if (checkHardwareSupport(CV_CPU_AVX2)) return makeAvx2CompiledCascade(fileName);
+#endif
+#if defined(HAAR_HAVE_NEON)
+    return makeNeonCompiledCascade(fileName);
+#else
+    return makeScalarCompiledCascade(fileName);
+#endif
+}
+
+shared_ptr<const CompiledEnsemble> loadCompiledEnsemble() {
+    shared_ptr<const CompiledEnsemble> ensemble;
+#if defined(HAAR_HAVE_AVX2)
+    if (checkHardwareSupport(CV_CPU_AVX2)) ensemble = makeAvx2CompiledEnsemble();
+#endif
+#if defined(HAAR_HAVE_NEON)
+    if (!ensemble) ensemble = makeNeonCompiledEnsemble();
+#else
+    if (!ensemble) ensemble = makeScalarCompiledEnsemble();
+#endif
+    return ensemble->size() > 0 ? ensemble : nullptr;
+}
+
+int compiledEnsembleIndex(const string& path) {
+    const string fileName = fs::path(path).filename().string();
+    if (!matchesCompiled(path, fileName)) return -1;
+
+    int index = 0;
+#define HAAR_CASCADE_INDEX(Model) \
+    if (fileName == generated::Model::kFileName) return index; \
+    ++index;
+    HAAR_FOR_EACH_COMPILED_CASCADE(HAAR_CASCADE_INDEX)
+#undef HAAR_CASCADE_INDEX
+    return -1;
+}
+
+}  // namespace haar
@@ -0,0 +1,123 @@
+// 需以 -mavx2 编译（不开 FMA），由 CMake 仅在 x86 上加入
+#include "compiled_cascade_kernel.h"
+#include "compiled_cascades.gen.h"
+
+#include <immintrin.h>
+#include <climits>
+#include <cstring>
+
+using namespace std;
+
+namespace haar {
+
+namespace {
+
+// 8 个窗口一组；double 部分拆成高低两个 __m256d
+struct Avx2Lanes {
+    static constexpr int kLanes = 8;
+    static constexpr const char* kName = "avx2";
+
+    using I = __m256i;
+    using F = __m256;
+    using M = __m256;
+    struct Acc {
+        __m256d lo, hi;
+    };
+
+    template <int Stride>
+    static I load(const int* p) {
+        if constexpr (Stride == 1) {
+            return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        } else {
+            // 步长 2：读 16 个取偶数位
+            static_assert(Stride == 2, "stride must be 1 or 2");
+            const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 8));
+            const __m256i lo = _mm256_permutevar8x32_epi32(a, _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7));
+            const __m256i hi = _mm256_permutevar8x32_epi32(b, _mm256_setr_epi32(1, 3, 5, 7, 0, 2, 4, 6));
+            return _mm256_blend_epi32(lo, hi, 0xF0);
+        }
+    }
+
+    static I add(I a, I b) { return _mm256_add_epi32(a, b); }
+    static I sub(I a, I b) { return _mm256_sub_epi32(a, b); }
+    static F toFloat(I a) { return _mm256_cvtepi32_ps(a); }
+    static F set(float v) { return _mm256_set1_ps(v); }
+    static F add(F a, F b) { return _mm256_add_ps(a, b); }
+    static F mul(F a, F b) { return _mm256_mul_ps(a, b); }
+    static M lt(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+
+    static M zero() { return _mm256_setzero_ps(); }
+    static M and_(M a, M b) { return _mm256_and_ps(a, b); }
+    static M andNot(M a, M b) { return _mm256_andnot_ps(b, a); }
+    static bool any(M m) { return _mm256_movemask_ps(m) != 0; }
+    static int bits(M m) { return _mm256_movemask_ps(m); }
+
+    static M fromBits(int bits) {
+        const __m256i lane = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+        const __m256i set = _mm256_and_si256(_mm256_set1_epi32(bits), lane);
+        return _mm256_castsi256_ps(_mm256_cmpeq_epi32(set, lane));
+    }
+
+    static __m256d unsignedToDouble(__m128i v) {
+        const __m128i flipped = _mm_xor_si128(v, _mm_set1_epi32(INT_MIN));
+        return _mm256_add_pd(_mm256_cvtepi32_pd(flipped), _mm256_set1_pd(2147483648.0));
+    }
+
+    static M normalize(I sum, I sqsum, double area, F& factor) {
+        const __m256d a = _mm256_set1_pd(area);
+        __m128 f[2];
+        int positive = 0, ok = 0;
+        for (int h = 0; h < 2; ++h) {
+            const __m128i s = h ? _mm256_extracti128_si256(sum, 1) : _mm256_castsi256_si128(sum);
+            const __m128i q = h ? _mm256_extracti128_si256(sqsum, 1) : _mm256_castsi256_si128(sqsum);
+            const __m256d sd = _mm256_cvtepi32_pd(s);
+            const __m256d nf = _mm256_sub_pd(_mm256_mul_pd(a, unsignedToDouble(q)), _mm256_mul_pd(sd, sd));
+            const __m256d pos = _mm256_cmp_pd(nf, _mm256_setzero_pd(), _CMP_GT_OQ);
+            f[h] = _mm256_cvtpd_ps(_mm256_div_pd(_mm256_set1_pd(1.), _mm256_sqrt_pd(nf)));
+            const __m256d small = _mm256_cmp_pd(_mm256_mul_pd(a, _mm256_cvtps_pd(f[h])),
+                                                _mm256_set1_pd(1e-1), _CMP_LT_OQ);
+            positive |= _mm256_movemask_pd(pos) << (4 * h);
+            ok |= _mm256_movemask_pd(_mm256_and_pd(pos, small)) << (4 * h);
+        }
+        const __m256 all = _mm256_insertf128_ps(_mm256_castps128_ps256(f[0]), f[1], 1);
+        factor = _mm256_blendv_ps(_mm256_set1_ps(1.f), all, fromBits(positive));
+        return fromBits(ok);
+    }
+
+    static Acc accZero() { return {_mm256_setzero_pd(), _mm256_setzero_pd()}; }
+
+    static Acc accAdd(const Acc& acc, M lt, float left, float right) {
+        const __m256 v = _mm256_blendv_ps(_mm256_set1_ps(right), _mm256_set1_ps(left), lt);
+        return {_mm256_add_pd(acc.lo, _mm256_cvtps_pd(_mm256_castps256_ps128(v))),
+                _mm256_add_pd(acc.hi, _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)))};
+    }
+
+    static M accNotLess(const Acc& acc, float threshold) {
+        const __m256d t = _mm256_set1_pd(threshold);
+        const int lo = _mm256_movemask_pd(_mm256_cmp_pd(acc.lo, t, _CMP_NLT_UQ));
+        const int hi = _mm256_movemask_pd(_mm256_cmp_pd(acc.hi, t, _CMP_NLT_UQ));
+        return fromBits(lo | (hi << 4));
+    }
+};
+
+}  // namespace
+
+shared_ptr<const CompiledCascade> makeAvx2CompiledCascade(const string& fileName) {
+#define HAAR_MAKE_CASCADE(Model)                                                \
+    if (strcmp(fileName.c_str(), generated::Model::kFileName) == 0) {           \
+        return make_shared<CompiledHaarCascade<generated::Model, Avx2Lanes>>(); \
+    }
+    HAAR_FOR_EACH_COMPILED_CASCADE(HAAR_MAKE_CASCADE)
+#undef HAAR_MAKE_CASCADE
+    return nullptr;
+}
+
+#define HAAR_ENSEMBLE_MODEL(Model) , generated::Model
+shared_ptr<const CompiledEnsemble> makeAvx2CompiledEnsemble() {
+    return make_shared<CompiledHaarEnsemble<Avx2Lanes, generated::kNumSharedFeatures
+                                            HAAR_FOR_EACH_COMPILED_CASCADE(HAAR_ENSEMBLE_MODEL)>>();
+}
+#undef HAAR_ENSEMBLE_MODEL
+
+}  // namespace haar
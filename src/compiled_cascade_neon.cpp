@@ -0,0 +1,107 @@
+// AArch64 上 NEON 总是可用，无需额外编译选项；由 CMake 仅在 ARM64 上加入
+#include "compiled_cascade_kernel.h"
+#include "compiled_cascades.gen.h"
+
+#include <arm_neon.h>
+#include <cstring>
+
+using namespace std;
+
+namespace haar {
+
+namespace {
+
+// 4 个窗口一组；double 部分拆成高低两个 float64x2_t
+struct NeonLanes {
+    static constexpr int kLanes = 4;
+    static constexpr const char* kName = "neon";
+
+    using I = int32x4_t;
+    using F = float32x4_t;
+    using M = uint32x4_t;
+    struct Acc {
+        float64x2_t lo, hi;
+    };
+
+    template <int Stride>
+    static I load(const int* p) {
+        if constexpr (Stride == 1) {
+            return vld1q_s32(p);
+        } else {
+            static_assert(Stride == 2, "stride must be 1 or 2");
+            return vld2q_s32(p).val[0];
+        }
+    }
+
+    static I add(I a, I b) { return vaddq_s32(a, b); }
+    static I sub(I a, I b) { return vsubq_s32(a, b); }
+    static F toFloat(I a) { return vcvtq_f32_s32(a); }
+    static F set(float v) { return vdupq_n_f32(v); }
+    static F add(F a, F b) { return vaddq_f32(a, b); }
+    static F mul(F a, F b) { return vmulq_f32(a, b); }
+    static M lt(F a, F b) { return vcltq_f32(a, b); }
+
+    static M zero() { return vdupq_n_u32(0); }
+    static M and_(M a, M b) { return vandq_u32(a, b); }
+    static M andNot(M a, M b) { return vbicq_u32(a, b); }
+    static bool any(M m) { return vmaxvq_u32(m) != 0; }
+    static int bits(M m) {
+        const uint32x4_t lane = {1, 2, 4, 8};
+        return static_cast<int>(vaddvq_u32(vandq_u32(m, lane)));
+    }
+
+    static M narrow(uint64x2_t lo, uint64x2_t hi) { return vcombine_u32(vmovn_u64(lo), vmovn_u64(hi)); }
+
+    static M normalize(I sum, I sqsum, double area, F& factor) {
+        const float64x2_t a = vdupq_n_f64(area);
+        const uint32x4_t q = vreinterpretq_u32_s32(sqsum);
+        const float64x2_t sd[2] = {vcvtq_f64_s64(vmovl_s32(vget_low_s32(sum))),
+                                   vcvtq_f64_s64(vmovl_high_s32(sum))};
+        const float64x2_t qd[2] = {vcvtq_f64_u64(vmovl_u32(vget_low_u32(q))),
+                                   vcvtq_f64_u64(vmovl_high_u32(q))};
+        uint64x2_t pos[2], ok[2];
+        float32x2_t f[2];
+        for (int h = 0; h < 2; ++h) {
+            const float64x2_t nf = vsubq_f64(vmulq_f64(a, qd[h]), vmulq_f64(sd[h], sd[h]));
+            pos[h] = vcgtq_f64(nf, vdupq_n_f64(0.));
+            f[h] = vcvt_f32_f64(vdivq_f64(vdupq_n_f64(1.), vsqrtq_f64(nf)));
+            ok[h] = vandq_u64(pos[h], vcltq_f64(vmulq_f64(a, vcvt_f64_f32(f[h])), vdupq_n_f64(1e-1)));
+        }
+        factor = vbslq_f32(narrow(pos[0], pos[1]), vcombine_f32(f[0], f[1]), vdupq_n_f32(1.f));
+        return narrow(ok[0], ok[1]);
+    }
+
+    static Acc accZero() { return {vdupq_n_f64(0.), vdupq_n_f64(0.)}; }
+
+    static Acc accAdd(const Acc& acc, M lt, float left, float right) {
+        const float32x4_t v = vbslq_f32(lt, vdupq_n_f32(left), vdupq_n_f32(right));
+        return {vaddq_f64(acc.lo, vcvt_f64_f32(vget_low_f32(v))),
+                vaddq_f64(acc.hi, vcvt_high_f64_f32(v))};
+    }
+
+    static M accNotLess(const Acc& acc, float threshold) {
+        const float64x2_t t = vdupq_n_f64(threshold);
+        return vmvnq_u32(narrow(vcltq_f64(acc.lo, t), vcltq_f64(acc.hi, t)));
+    }
+};
+
+}  // namespace
+
+shared_ptr<const CompiledCascade> makeNeonCompiledCascade(const string& fileName) {
+#define HAAR_MAKE_CASCADE(Model)                                                \
+    if (strcmp(fileName.c_str(), generated::Model::kFileName) == 0) {           \
+        return make_shared<CompiledHaarCascade<generated::Model, NeonLanes>>(); \
+    }
+    HAAR_FOR_EACH_COMPILED_CASCADE(HAAR_MAKE_CASCADE)
+#undef HAAR_MAKE_CASCADE
+    return nullptr;
+}
+
+#define HAAR_ENSEMBLE_MODEL(Model) , generated::Model
+shared_ptr<const CompiledEnsemble> makeNeonCompiledEnsemble() {
+    return make_shared<CompiledHaarEnsemble<NeonLanes, generated::kNumSharedFeatures
+                                            HAAR_FOR_EACH_COMPILED_CASCADE(HAAR_ENSEMBLE_MODEL)>>();
+}
+#undef HAAR_ENSEMBLE_MODEL
+
+}  // namespace haar
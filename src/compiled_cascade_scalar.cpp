@@ -0,0 +1,76 @@
+#include "compiled_cascade_kernel.h"
+#include "compiled_cascades.gen.h"
+
+#include <cmath>
+#include <cstring>
+
+using namespace std;
+
+namespace haar {
+
+namespace {
+
+// 每次一个窗口的后端，也是其余后端的参照实现；整数运算按无符号回绕，与 OpenCV 的 int 积分图一致
+struct ScalarLanes {
+    static constexpr int kLanes = 1;
+    static constexpr const char* kName = "scalar";
+
+    using I = int;
+    using F = float;
+    using M = bool;
+    using Acc = double;
+
+    template <int Stride>
+    static I load(const int* p) { return *p; }
+
+    static I add(I a, I b) { return static_cast<int>(static_cast<unsigned>(a) + static_cast<unsigned>(b)); }
+    static I sub(I a, I b) { return static_cast<int>(static_cast<unsigned>(a) - static_cast<unsigned>(b)); }
+    static F toFloat(I a) { return static_cast<float>(a); }
+    static F set(float v) { return v; }
+    static F add(F a, F b) { return a + b; }
+    static F mul(F a, F b) { return a * b; }
+    static M lt(F a, F b) { return a < b; }
+
+    static M zero() { return false; }
+    static M and_(M a, M b) { return a && b; }
+    static M andNot(M a, M b) { return a && !b; }
+    static bool any(M m) { return m; }
+    static int bits(M m) { return m ? 1 : 0; }
+
+    // HaarEvaluator::setWindow
+    static M normalize(I sum, I sqsum, double area, F& factor) {
+        double nf = area * static_cast<unsigned>(sqsum) - static_cast<double>(sum) * sum;
+        if (nf > 0.) {
+            nf = std::sqrt(nf);
+            factor = static_cast<float>(1. / nf);
+            return area * factor < 1e-1;
+        }
+        factor = 1.f;
+        return false;
+    }
+
+    static Acc accZero() { return 0.; }
+    static Acc accAdd(Acc acc, M lt, float left, float right) { return acc + (lt ? left : right); }
+    static M accNotLess(Acc acc, float threshold) { return !(acc < threshold); }
+};
+
+}  // namespace
+
+shared_ptr<const CompiledCascade> makeScalarCompiledCascade(const string& fileName) {
+#define HAAR_MAKE_CASCADE(Model)                                                  \
+    if (strcmp(fileName.c_str(), generated::Model::kFileName) == 0) {             \
+        return make_shared<CompiledHaarCascade<generated::Model, ScalarLanes>>(); \
+    }
+    HAAR_FOR_EACH_COMPILED_CASCADE(HAAR_MAKE_CASCADE)
+#undef HAAR_MAKE_CASCADE
+    return nullptr;
+}
+
+#define HAAR_ENSEMBLE_MODEL(Model) , generated::Model
+shared_ptr<const CompiledEnsemble> makeScalarCompiledEnsemble() {
+    return make_shared<CompiledHaarEnsemble<ScalarLanes, generated::kNumSharedFeatures
+                                            HAAR_FOR_EACH_COMPILED_CASCADE(HAAR_ENSEMBLE_MODEL)>>();
+}
+#undef HAAR_ENSEMBLE_MODEL
+
+}  // namespace haar
@@ -1,112 +1,121 @@
 #include <opencv2/opencv.hpp>
-#include <filesystem>
 #include <iostream>
 #include <iomanip>
 
-namespace fs = std::filesystem;
+#include "detector_registry.h"
+#include "latency_stats.h"
+#include "search_window.h"
+#include "trace.h"
+#include "square_detector.h"
+
 using namespace cv;
 using namespace std;
 
-const string IMAGE_FOLDER = "../img/video_01";
-const string OUTPUT_FOLDER = "../output_contour";
+namespace haar {
 
-vector<string> getSortedImagePaths(const string& folder_path) {
-    vector<string> files;
-    for (const auto& entry : fs::directory_iterator(folder_path)) {
-        files.push_back(entry.path().string());
-    }
-    sort(files.begin(), files.end());
-    return files;
-}
+namespace {
 
-int main() {
-    fs::create_directories(OUTPUT_FOLDER);
-    vector<string> image_paths = getSortedImagePaths(IMAGE_FOLDER);
-
-    Point lastDetected(-1, -1);
-    KalmanFilter KF(4, 2, 0);
-    KF.transitionMatrix = (Mat_<float>(4, 4) <<
-        1, 0, 1, 0,
-        0, 1, 0, 1,
-        0, 0, 1, 0,
-        0, 0, 0, 1);
-    KF.measurementMatrix = Mat::eye(2, 4, CV_32F);
-    setIdentity(KF.processNoiseCov, Scalar::all(1e-4));
-    setIdentity(KF.measurementNoiseCov, Scalar::all(1e-2));
-    setIdentity(KF.errorCovPost, Scalar::all(1));
-
-    for (size_t i = 0; i < image_paths.size(); ++i) {
-        string img_path = image_paths[i];
-        Mat frame = imread(img_path, IMREAD_GRAYSCALE);
-        if (frame.empty()) continue;
+const string IMAGE_FOLDER = "img/video_01";     // 相对 assetRoot
+const string OUTPUT_FOLDER = "output_contour";
+// 可调参数的默认值，运行时可用 --set canny_low= / canny_high= 覆盖（见 tunables.h）
+const double CANNY_LOW = 50;
+const double CANNY_HIGH = 150;
 
-        int64 start = getTickCount();
+// 一路视频的跟踪状态与逐帧复用的缓冲，稳态下 process() 不做堆分配
+class ContourSession : public DetectorSession {
+public:
+    ContourSession(const SessionContext& context, const SquareDetectorOptions& squareOptions)
+        : context_(context), squares_(squareOptions) {}
 
-        Mat blurred, edges;
-        GaussianBlur(frame, blurred, Size(5, 5), 1.5);
+    FrameResult process(const Frame& f) override {
+        const Mat& frame = f.image;
+        size_t i = f.index;
+        const bool logFrames = context_.logFrames;
 
-        Rect roiRect(0, 0, frame.cols, frame.rows);
-        if (lastDetected.x >= 0) {
-            int r = 40;
-            roiRect = Rect(max(lastDetected.x - r, 0), max(lastDetected.y - r, 0),
-                          min(2 * r, frame.cols - max(lastDetected.x - r, 0)),
-                          min(2 * r, frame.rows - max(lastDetected.y - r, 0)));
-        }
+        int64 start = getTickCount();
 
-        Mat roi = blurred(roiRect);
-        Canny(roi, edges, 50, 150);
+        StageTimer stages(context_.latency, STAGE_ROI);
 
-        vector<vector<Point>> contours;
-        findContours(edges, contours, RETR_EXTERNAL, CHAIN_APPROX_SIMPLE);
+        const SearchWindow window = planner_.begin(frame.size());
+        const Rect& roiRect = window.roi;
+        HAAR_TRACE_ARG("roi_width", roiRect.width);
+        HAAR_TRACE_ARG("roi_height", roiRect.height);
+        HAAR_TRACE_ARG("search_stage", window.stage);
+        HAAR_TRACE_ARG("full_frame", window.fullFrame ? 1 : 0);
 
-        Mat display;
-        cvtColor(frame, display, COLOR_GRAY2BGR);
+        // 模糊与边缘检测只在 ROI 上做（结果与整帧模糊后裁剪相同），合在检测阶段计时
+        stages.next(STAGE_DETECT);
+        FrameResult result;
+        result.searchRegion = roiRect;
         Rect bestBox;
         double bestScore = 0;
+        squares_.detect(frame, roiRect, bestBox, bestScore);
 
-        for (const auto& cnt : contours) {
-            vector<Point> approx;
-            approxPolyDP(cnt, approx, arcLength(cnt, true)*0.02, true);
-            if (approx.size() == 4 && isContourConvex(approx)) {
-                Rect box = boundingRect(approx);
-                box.x += roiRect.x;
-                box.y += roiRect.y;
-                float aspectRatio = (float)box.width / box.height;
-                float area = box.area();
-                if (aspectRatio > 0.8 && aspectRatio < 1.2 && area > 3000 && area < 10000) {
-                    if (area > bestScore) {
-                        bestScore = area;
-                        bestBox = box;
-                    }
-                }
-            }
-        }
-
-        Point detectedCenter(-1, -1);
+        stages.next(STAGE_TRACK);
         if (bestScore > 0) {
-            rectangle(display, bestBox, Scalar(0, 255, 0), 2);
-            detectedCenter = Point(bestBox.x + bestBox.width / 2, bestBox.y + bestBox.height / 2);
-            Mat meas = (Mat_<float>(2,1) << detectedCenter.x, detectedCenter.y);
-            KF.correct(meas);
-            lastDetected = detectedCenter;
-            cout << "✅ Frame " << i << " | Box at (" << bestBox.x << ", " << bestBox.y << ")"
-                 << " | Score: " << bestScore;
-        } else {
-            Mat prediction = KF.predict();
-            lastDetected = Point(prediction.at<float>(0), prediction.at<float>(1));
-            rectangle(display, Rect(lastDetected.x - 40, lastDetected.y - 40, 80, 80), Scalar(0, 255, 255), 2);
-            cout << "❌ Frame " << i << " | Prediction used at (" << lastDetected.x << ", " << lastDetected.y << ")";
+            result.boxes.push_back({bestBox, Scalar(0, 255, 0), 2, bestScore, "target"});
+            planner_.update(bestBox);
+            ++detected_;
+            if (logFrames) {
+                cout << "✅ Frame " << i << " | Box at (" << bestBox.x << ", " << bestBox.y << ")"
+                     << " | Score: " << bestScore;
+            }
+        } else if (planner_.tracking()) {
+            const Rect predicted = planner_.predicted();
+            result.boxes.push_back({predicted, Scalar(0, 255, 255), 2, 0, "prediction"});
+            if (logFrames) {
+                cout << "❌ Frame " << i << " | Prediction used at (" << predicted.x + predicted.width / 2 << ", "
+                     << predicted.y + predicted.height / 2 << ") | stage " << window.stage;
+            }
+            planner_.miss();
+        } else if (logFrames) {
+            cout << "❌ Frame " << i << " | No detection";
         }
 
+        stages.stop();
         int64 end = getTickCount();
         double elapsed_ms = 1000.0 * (end - start) / getTickFrequency();
-        cout << fixed << setprecision(2) << " | Time: " << elapsed_ms << " ms" << endl;
+        if (logFrames) cout << fixed << setprecision(2) << " | Time: " << elapsed_ms << " ms" << endl;
+
+        return result;
+    }
+
+private:
+    SessionContext context_;
+    // 搜索窗口按跟踪预测定大小，未命中时逐帧放大，几帧都找不到才整帧检测。
+    // SquareDetector 的面积范围是固定的，不按上次尺寸收窄
+    SearchWindowPlanner planner_;
+    SquareDetector squares_;
+};
+
+// 方形目标检测没有要加载的文件，模型只保存读好的可调参数
+class ContourModel : public DetectorModel {
+public:
+    explicit ContourModel(const SquareDetectorOptions& squareOptions) : squareOptions_(squareOptions) {}
+
+    unique_ptr<DetectorSession> createSession(const SessionContext& context) const override {
+        return make_unique<ContourSession>(context, squareOptions_);
+    }
 
-        string out_path = OUTPUT_FOLDER + "/" + fs::path(img_path).stem().string() + "_contour.jpg";
-        imwrite(out_path, display);
-        imshow("Contour Detection with Kalman", display);
-        waitKey(1);
+private:
+    SquareDetectorOptions squareOptions_;
+};
+
+unique_ptr<DetectorModel> loadContourModel(const string&, const Tunables& tunables, string& error) {
+    SquareDetectorOptions squareOptions;
+    squareOptions.cannyLow = tunables.get("canny_low", CANNY_LOW);
+    squareOptions.cannyHigh = tunables.get("canny_high", CANNY_HIGH);
+    if (!checkMin("canny_low", squareOptions.cannyLow, 0, error) ||
+        !checkMin("canny_high", squareOptions.cannyHigh, 0, error)) {
+        return nullptr;
     }
+    return make_unique<ContourModel>(squareOptions);
+}
+
+}  // namespace
+
+RegisteredDetector contourDetector() {
+    return {"detect", loadContourModel, "_contour.jpg", IMAGE_FOLDER, OUTPUT_FOLDER, "Contour Detection + Search Window"};
+}
 
-    return 0;
-}
\ No newline at end of file
+}  // namespace haar
@@ -5,94 +5,144 @@
 #include <fstream>
 #include <chrono>
 
+#include "detector_registry.h"
+#include "latency_stats.h"
+#include "trace.h"
+#include "template_bank.h"
+
 namespace fs = std::filesystem;
 using namespace cv;
 using namespace std;
 
-// === 参数设置 ===
-const string TEMPLATE_PATH = "../img/template_001.jpg";
-const string FRAME_FOLDER  = "../img/video_01";  // 替换为 video_02 等
-const string OUTPUT_FOLDER = "../output";
-const string TIME_LOG_FILE = "../output/timelog.txt";
-const double MATCH_THRESHOLD = 0.25;
-const int SEARCH_RADIUS = 60;
-
-int main() {
-    // 加载模板
-    Mat templ = imread(TEMPLATE_PATH, IMREAD_GRAYSCALE);
-    if (templ.empty()) {
-        cerr << "❌ 无法读取模板图像：" << TEMPLATE_PATH << endl;
-        return -1;
-    }
+namespace haar {
 
-    fs::create_directories(OUTPUT_FOLDER);
-    ofstream timeLog(TIME_LOG_FILE);
-    if (!timeLog.is_open()) {
-        cerr << "❌ 无法打开时间日志文件" << endl;
-        return -1;
-    }
+namespace {
 
-    vector<string> files;
-    for (const auto& entry : fs::directory_iterator(FRAME_FOLDER)) {
-        files.push_back(entry.path().string());
+// === 参数设置 ===（路径相对 assetRoot）
+const string TEMPLATE_PATH = "img/template_001.jpg";
+const string FRAME_FOLDER  = "img/video_01";  // 替换为 video_02 等
+const string OUTPUT_FOLDER = "output";
+const double MATCH_THRESHOLD = 0.25;
+const int SEARCH_RADIUS = 60;
+// 以上两项可用 --set match_threshold= / search_radius= 覆盖（见 tunables.h）；模板库的参数见 readTemplateBankOptions
+
+// 一路视频：逐帧用时写入输出目录下的 timelog.txt；批处理时关掉逐帧日志和汇总
+class TemplateSession : public DetectorSession {
+public:
+    TemplateSession(const SessionContext& context, const TemplateBank& bank, double matchThreshold,
+                    int searchRadius)
+        : context_(context), bank_(bank), matchThreshold_(matchThreshold), searchRadius_(searchRadius) {
+        if (context_.outputFolder.empty()) return;
+        fs::create_directories(context_.outputFolder);
+        const string timeLogPath = context_.outputFolder + "/timelog.txt";
+        timeLog_.open(timeLogPath);
+        if (!timeLog_.is_open()) cerr << "❌ 无法打开时间日志文件：" << timeLogPath << endl;
     }
-    sort(files.begin(), files.end());
 
-    Point prevCenter(-1, -1);
-    int successCount = 0;
-    int totalCount = 0;
-
-    for (const auto& file : files) {
-        Mat frame = imread(file, IMREAD_GRAYSCALE);
-        if (frame.empty()) continue;
+    FrameResult process(const Frame& f) override {
+        const Mat& frame = f.image;
+        const string& file = f.path;
+        FrameResult out;
+        out.colorOutput = false;
 
         auto start = chrono::high_resolution_clock::now();
 
-        Rect searchRect(0, 0, frame.cols, frame.rows);
-        if (prevCenter.x > 0 && prevCenter.y > 0) {
-            int x = max(prevCenter.x - SEARCH_RADIUS, 0);
-            int y = max(prevCenter.y - SEARCH_RADIUS, 0);
-            int w = min(templ.cols + 2 * SEARCH_RADIUS, frame.cols - x);
-            int h = min(templ.rows + 2 * SEARCH_RADIUS, frame.rows - y);
-            searchRect = Rect(x, y, w, h);
-        }
-
-        Mat searchROI = frame(searchRect);
-        Mat result;
-        matchTemplate(searchROI, templ, result, TM_CCOEFF_NORMED);
+        StageTimer stages(context_.latency, STAGE_ROI);
+        const Rect searchRect = bank_.searchWindow(frame.size(), prevCenter_, searchRadius_);
+        HAAR_TRACE_ARG("roi_width", searchRect.width);
+        HAAR_TRACE_ARG("roi_height", searchRect.height);
 
-        double maxVal;
-        Point maxLoc;
-        minMaxLoc(result, nullptr, &maxVal, nullptr, &maxLoc);
+        // 各尺度 / 角度的变体并行匹配；跟踪窗口内直接原分辨率匹配，整帧重捕获时走金字塔粗搜 + 精修
+        stages.next(STAGE_DETECT);
+        out.searchRegion = searchRect;
+        BankMatch best = bank_.match(frame, searchRect, context_.pool);
+        double maxVal = best.score;
 
-        Point matchCenter = Point(maxLoc.x + templ.cols / 2 + searchRect.x,
-                                  maxLoc.y + templ.rows / 2 + searchRect.y);
+        Point matchCenter = best.center();
 
-        bool matched = maxVal >= MATCH_THRESHOLD;
+        stages.next(STAGE_TRACK);
+        bool matched = maxVal >= matchThreshold_;
         if (matched) {
-            Rect box(matchCenter.x - templ.cols / 2, matchCenter.y - templ.rows / 2,
-                     templ.cols, templ.rows);
-            rectangle(frame, box, Scalar(255), 2);
-            prevCenter = matchCenter;
-            successCount++;
+            Rect box(best.location, best.size);
+            out.boxes.push_back({box, Scalar(255), 2, maxVal, "drone"});
+            prevCenter_ = matchCenter;
+            ++detected_;
         }
 
-        totalCount++;
+        stages.stop();
+        totalCount_++;
         auto end = chrono::high_resolution_clock::now();
         double elapsed_ms = chrono::duration<double, std::milli>(end - start).count();
 
-        string out_name = OUTPUT_FOLDER + "/" + fs::path(file).filename().string();
-        imwrite(out_name, frame);
+        if (context_.logFrames) {
+            cout << fs::path(file).filename() << " - 匹配: " << (matched ? "✔️" : "❌")
+                 << " - 得分: " << maxVal << " - 尺度: " << best.scale << " - 角度: " << best.angle
+                 << " - 用时: " << elapsed_ms << " ms" << endl;
+        }
+
+        if (timeLog_.is_open()) timeLog_ << fs::path(file).filename() << ", " << elapsed_ms << "\n";
+        return out;
+    }
+
+    void finish() override {
+        timeLog_.close();
+        if (context_.logFrames) {
+            cout << "✅ 总帧数: " << totalCount_ << ", 检测成功: " << detected_
+                 << ", 成功率: " << (100.0 * detected_ / totalCount_) << "%" << endl;
+        }
+    }
 
-        cout << fs::path(file).filename() << " - 匹配: " << (matched ? "✔️" : "❌")
-             << " - 得分: " << maxVal << " - 用时: " << elapsed_ms << " ms" << endl;
+private:
+    SessionContext context_;
+    const TemplateBank& bank_;  // 模型里的模板库，match() 可多线程同时调用
+    double matchThreshold_;
+    int searchRadius_;
+
+    ofstream timeLog_;
+    Point prevCenter_{-1, -1};
+    int totalCount_ = 0;
+};
+
+// 模板库在加载时生成一次，各变体的均值、范数、金字塔和频谱由各会话共用
+class TemplateModel : public DetectorModel {
+public:
+    TemplateModel(const Mat& templ, const TemplateBankOptions& bankOptions, double matchThreshold,
+                  int searchRadius)
+        : bank_(templ, bankOptions), matchThreshold_(matchThreshold), searchRadius_(searchRadius) {}
+
+    unique_ptr<DetectorSession> createSession(const SessionContext& context) const override {
+        return make_unique<TemplateSession>(context, bank_, matchThreshold_, searchRadius_);
+    }
+
+private:
+    TemplateBank bank_;
+    double matchThreshold_;
+    int searchRadius_;
+};
 
-        timeLog << fs::path(file).filename() << ", " << elapsed_ms << "\n";
+unique_ptr<DetectorModel> loadTemplateModel(const string& assetRoot, const Tunables& tune, string& error) {
+    const string templatePath = assetPath(assetRoot, TEMPLATE_PATH);
+    Mat templ = imread(templatePath, IMREAD_GRAYSCALE);
+    if (templ.empty()) {
+        error = "无法读取模板图像：" + templatePath;
+        return nullptr;
     }
+    const double matchThreshold = tune.get("match_threshold", MATCH_THRESHOLD);
+    int searchRadius = 0;
+    TemplateBankOptions bankOptions;
+    if (!tune.getInt("search_radius", SEARCH_RADIUS, searchRadius, error) ||
+        !readTemplateBankOptions(tune, bankOptions, error) ||
+        !checkRange("match_threshold", matchThreshold, -1, 1, error) ||
+        !checkMin("search_radius", searchRadius, 0, error)) {
+        return nullptr;
+    }
+    return make_unique<TemplateModel>(templ, bankOptions, matchThreshold, searchRadius);
+}
 
-    timeLog.close();
-    cout << "✅ 总帧数: " << totalCount << ", 检测成功: " << successCount
-         << ", 成功率: " << (100.0 * successCount / totalCount) << "%" << endl;
+}  // namespace
 
-    return 0;
+RegisteredDetector templateDetector() {
+    return {"detect_drone_template", loadTemplateModel, "", FRAME_FOLDER, OUTPUT_FOLDER, ""};
 }
+
+}  // namespace haar
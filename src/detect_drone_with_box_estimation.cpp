@@ -4,17 +4,26 @@
 #include <fstream>
 #include <chrono>
 
+#include "detector_registry.h"
+#include "latency_stats.h"
+#include "trace.h"
+#include "template_bank.h"
+
 namespace fs = std::filesystem;
 using namespace cv;
 using namespace std;
 
-// === 参数设置 ===
-const string TEMPLATE_PATH = "../img/template_001.jpg";
-const string FRAME_FOLDER  = "../img/video_01";
-const string OUTPUT_FOLDER = "../output/6_2";
-const string TIME_LOG_FILE = "../output/timelog.txt";
+namespace haar {
+
+namespace {
+
+// === 参数设置 ===（路径相对 assetRoot）
+const string TEMPLATE_PATH = "img/template_001.jpg";
+const string FRAME_FOLDER  = "img/video_01";
+const string OUTPUT_FOLDER = "output/6_2";
 const double MATCH_THRESHOLD = 0.25;
 const int SEARCH_RADIUS = 100;
+// 以上两项可用 --set match_threshold= / search_radius= 覆盖（见 tunables.h）；模板库的参数见 readTemplateBankOptions
 
 // 木箱估计参数（你统计的平均值）
 const double BOX_DX = 0.86;
@@ -22,104 +31,143 @@ const double BOX_DY = 187.57;
 const double SCALE_W = 0.17;
 const double SCALE_H = 0.53;
 
-int main() {
-    // 加载模板
-    Mat templ = imread(TEMPLATE_PATH, IMREAD_GRAYSCALE);
-    if (templ.empty()) {
-        cerr << "❌ 无法读取模板图像：" << TEMPLATE_PATH << endl;
-        return -1;
+// 一路视频：逐帧用时写入输出目录下的 timelog.txt；批处理时关掉逐帧日志和汇总
+class BoxEstimationSession : public DetectorSession {
+public:
+    BoxEstimationSession(const SessionContext& context, const TemplateBank& bank, double matchThreshold,
+                         int searchRadius)
+        : context_(context), bank_(bank), matchThreshold_(matchThreshold), searchRadius_(searchRadius) {
+        if (context_.outputFolder.empty()) return;
+        fs::create_directories(context_.outputFolder);
+        const string timeLogPath = context_.outputFolder + "/timelog.txt";
+        timeLog_.open(timeLogPath);
+        if (!timeLog_.is_open()) cerr << "❌ 无法打开时间日志文件：" << timeLogPath << endl;
     }
 
-    fs::create_directories(OUTPUT_FOLDER);
-    ofstream timeLog(TIME_LOG_FILE);
-    if (!timeLog.is_open()) {
-        cerr << "❌ 无法打开时间日志文件" << endl;
-        return -1;
-    }
-
-    // 收集帧
-    vector<string> files;
-    for (const auto& entry : fs::directory_iterator(FRAME_FOLDER)) {
-        files.push_back(entry.path().string());
-    }
-    sort(files.begin(), files.end());
-
-    Point prevCenter(-1, -1);
-    int successCount = 0;
-    int totalCount = 0;
-
-    for (const auto& file : files) {
-        Mat frame = imread(file, IMREAD_GRAYSCALE);
-        if (frame.empty()) continue;
+    FrameResult process(const Frame& f) override {
+        const Mat& frame = f.image;
+        const string& file = f.path;
+        FrameResult out;
+        out.colorOutput = false;
 
         auto start = chrono::high_resolution_clock::now();
 
-        Rect searchRect(0, 0, frame.cols, frame.rows);
-        if (prevCenter.x > 0 && prevCenter.y > 0) {
-            int x = max(prevCenter.x - SEARCH_RADIUS, 0);
-            int y = max(prevCenter.y - SEARCH_RADIUS, 0);
-            int w = min(templ.cols + 2 * SEARCH_RADIUS, frame.cols - x);
-            int h = min(templ.rows + 2 * SEARCH_RADIUS, frame.rows - y);
-            searchRect = Rect(x, y, w, h);
-        }
-
-        Mat searchROI = frame(searchRect);
-        Mat result;
-        matchTemplate(searchROI, templ, result, TM_CCOEFF_NORMED);
+        StageTimer stages(context_.latency, STAGE_ROI);
+        const Rect searchRect = bank_.searchWindow(frame.size(), prevCenter_, searchRadius_);
+        HAAR_TRACE_ARG("roi_width", searchRect.width);
+        HAAR_TRACE_ARG("roi_height", searchRect.height);
 
-        double maxVal;
-        Point maxLoc;
-        minMaxLoc(result, nullptr, &maxVal, nullptr, &maxLoc);
+        // 各尺度 / 角度的变体并行匹配；跟踪窗口内直接原分辨率匹配，整帧重捕获时走金字塔粗搜 + 精修
+        stages.next(STAGE_DETECT);
+        out.searchRegion = searchRect;
+        BankMatch best = bank_.match(frame, searchRect, context_.pool);
+        double maxVal = best.score;
 
-        Point matchCenter = Point(maxLoc.x + templ.cols / 2 + searchRect.x,
-                                  maxLoc.y + templ.rows / 2 + searchRect.y);
+        Point matchCenter = best.center();
 
-        bool matched = maxVal >= MATCH_THRESHOLD;
+        stages.next(STAGE_TRACK);
+        bool matched = maxVal >= matchThreshold_;
         if (matched) {
             // 画无人机框
-            Rect droneBox(matchCenter.x - templ.cols / 2, matchCenter.y - templ.rows / 2,
-                          templ.cols, templ.rows);
-            rectangle(frame, droneBox, Scalar(255), 2);
-
-            // 木箱位置估计
-            int box_cx = static_cast<int>(matchCenter.x + BOX_DX);
-            int box_cy = static_cast<int>(matchCenter.y + BOX_DY);
-            int box_w = static_cast<int>(templ.cols * SCALE_W);
-            int box_h = static_cast<int>(templ.rows * SCALE_H);
+            Rect droneBox(best.location, best.size);
+            out.boxes.push_back({droneBox, Scalar(255), 2, maxVal, "drone"});
+
+            // 木箱位置估计：偏移与尺寸按原模板统计，随匹配到的变体一起缩放
+            int box_cx = static_cast<int>(matchCenter.x + BOX_DX * best.scale);
+            int box_cy = static_cast<int>(matchCenter.y + BOX_DY * best.scale);
+            int box_w = static_cast<int>(best.size.width * SCALE_W);
+            int box_h = static_cast<int>(best.size.height * SCALE_H);
             Rect boxROI(box_cx - box_w / 2, box_cy - box_h / 2, box_w, box_h);
 
             // 画木箱框（加边界保护）
             if (boxROI.x >= 0 && boxROI.y >= 0 &&
                 boxROI.x + boxROI.width <= frame.cols &&
                 boxROI.y + boxROI.height <= frame.rows) {
-                rectangle(frame, boxROI, Scalar(128), 2);
+                out.boxes.push_back({boxROI, Scalar(128), 2, maxVal, "box_estimate"});
             }
 
             // 更新前一帧中心
-            prevCenter = matchCenter;
-            successCount++;
+            prevCenter_ = matchCenter;
+            ++detected_;
         }
 
-        totalCount++;
+        stages.stop();
+        totalCount_++;
         auto end = chrono::high_resolution_clock::now();
         double elapsed_ms = chrono::duration<double, std::milli>(end - start).count();
 
-        // 输出帧图像
-        string out_name = OUTPUT_FOLDER + "/" + fs::path(file).filename().string();
-        imwrite(out_name, frame);
-
         // 控制台输出
-        cout << fs::path(file).filename() << " - 匹配: " << (matched ? "✔️" : "❌")
-             << " - 得分: " << maxVal << " - 用时: " << elapsed_ms << " ms" << endl;
+        if (context_.logFrames) {
+            cout << fs::path(file).filename() << " - 匹配: " << (matched ? "✔️" : "❌")
+                 << " - 得分: " << maxVal << " - 尺度: " << best.scale << " - 角度: " << best.angle
+                 << " - 用时: " << elapsed_ms << " ms" << endl;
+        }
 
         // 写日志
-        timeLog << fs::path(file).filename() << ", " << elapsed_ms << "\n";
+        if (timeLog_.is_open()) timeLog_ << fs::path(file).filename() << ", " << elapsed_ms << "\n";
+        return out;
     }
 
-    timeLog.close();
-    cout << "✅ 总帧数: " << totalCount
-         << ", 检测成功: " << successCount
-         << ", 成功率: " << (100.0 * successCount / totalCount) << "%" << endl;
+    void finish() override {
+        timeLog_.close();
+        if (context_.logFrames) {
+            cout << "✅ 总帧数: " << totalCount_
+                 << ", 检测成功: " << detected_
+                 << ", 成功率: " << (100.0 * detected_ / totalCount_) << "%" << endl;
+        }
+    }
+
+private:
+    SessionContext context_;
+    const TemplateBank& bank_;  // 模型里的模板库，match() 可多线程同时调用
+    double matchThreshold_;
+    int searchRadius_;
+
+    ofstream timeLog_;
+    Point prevCenter_{-1, -1};
+    int totalCount_ = 0;
+};
+
+// 模板库在加载时生成一次，各变体的均值、范数、金字塔和频谱由各会话共用
+class BoxEstimationModel : public DetectorModel {
+public:
+    BoxEstimationModel(const Mat& templ, const TemplateBankOptions& bankOptions, double matchThreshold,
+                       int searchRadius)
+        : bank_(templ, bankOptions), matchThreshold_(matchThreshold), searchRadius_(searchRadius) {}
+
+    unique_ptr<DetectorSession> createSession(const SessionContext& context) const override {
+        return make_unique<BoxEstimationSession>(context, bank_, matchThreshold_, searchRadius_);
+    }
+
+private:
+    TemplateBank bank_;
+    double matchThreshold_;
+    int searchRadius_;
+};
+
+unique_ptr<DetectorModel> loadBoxEstimationModel(const string& assetRoot, const Tunables& tune, string& error) {
+    const string templatePath = assetPath(assetRoot, TEMPLATE_PATH);
+    Mat templ = imread(templatePath, IMREAD_GRAYSCALE);
+    if (templ.empty()) {
+        error = "无法读取模板图像：" + templatePath;
+        return nullptr;
+    }
+    const double matchThreshold = tune.get("match_threshold", MATCH_THRESHOLD);
+    int searchRadius = 0;
+    TemplateBankOptions bankOptions;
+    if (!tune.getInt("search_radius", SEARCH_RADIUS, searchRadius, error) ||
+        !readTemplateBankOptions(tune, bankOptions, error) ||
+        !checkRange("match_threshold", matchThreshold, -1, 1, error) ||
+        !checkMin("search_radius", searchRadius, 0, error)) {
+        return nullptr;
+    }
+    return make_unique<BoxEstimationModel>(templ, bankOptions, matchThreshold, searchRadius);
+}
+
+}  // namespace
 
-    return 0;
+RegisteredDetector boxEstimationDetector() {
+    return {"detect_drone_with_box_estimation", loadBoxEstimationModel, "", FRAME_FOLDER, OUTPUT_FOLDER, ""};
 }
+
+}  // namespace haar
@@ -0,0 +1,162 @@
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+#include "detector_registry.h"
+#include "haar_model.h"
+#include "latency_stats.h"
+#include "search_window.h"
+#include "trace.h"
+
+using namespace cv;
+using namespace std;
+
+namespace haar {
+
+namespace {
+
+// === 配置参数 ===（路径相对 assetRoot）
+const vector<string> CASCADE_PATHS = {
+    "haarcascade_drone.xml", "haarcascade_drone2.xml",
+    "haarcascade_drone3.xml", "haarcascade_drone4.xml",
+};
+const string IMAGE_FOLDER  = "img/video_01";
+const string OUTPUT_FOLDER = "output_haar_ensemble";
+const Size MIN_OBJECT(40, 40);
+const EnsembleFusion FUSION = EnsembleFusion::Union;  // Vote 时至少 MIN_VOTES 个级联都检出才算
+const int MIN_VOTES = 2;
+const double SCALE_FACTOR = 1.1;
+const int MIN_NEIGHBORS = 3;
+// 运行时可覆盖（见 tunables.h）：min_width / min_height、fusion（0 = Union，1 = Vote）、scale_factor、
+// min_neighbors；min_votes 只在 Vote 时读，Union 下设置它会被当作没有检测器认的名字报错
+
+struct EnsembleSettings {
+    HaarScanSettings scan;
+    HaarEnsembleOptions ensemble;
+};
+
+// 一路视频：检测器的缓冲区和跟踪状态只属于这个会话
+class EnsembleSession : public DetectorSession {
+public:
+    EnsembleSession(const SessionContext& context, const HaarEnsemble& cascades, const EnsembleSettings& settings)
+        : context_(context), settings_(settings), ensemble_(settings.ensemble) {
+        ensemble_.loadFrom(cascades);
+    }
+
+    FrameResult process(const Frame& f) override {
+        const Mat& frame = f.image;
+        size_t i = f.index;
+
+        int64 start = getTickCount();
+
+        FrameResult result;
+
+        StageTimer stages(context_.latency, STAGE_ROI);
+        const SearchWindow window = planner_.begin(frame.size());
+        Size minSize = settings_.scan.minObject, maxSize;
+        window.narrow(minSize, maxSize);
+        HAAR_TRACE_ARG("roi_width", window.roi.width);
+        HAAR_TRACE_ARG("roi_height", window.roi.height);
+        HAAR_TRACE_ARG("search_stage", window.stage);
+        HAAR_TRACE_ARG("full_frame", window.fullFrame ? 1 : 0);
+
+        stages.next(STAGE_DETECT);
+        ensemble_.detectMultiScale(frame(window.roi), detections_, settings_.scan.scaleFactor,
+                                   settings_.scan.minNeighbors, minSize, maxSize);
+        for (auto& d : detections_) d += window.roi.tl();
+        if (!window.fullFrame) result.searchRegion = window.roi;
+
+        stages.next(STAGE_TRACK);
+        int64 end = getTickCount();
+        double elapsed_ms = 1000.0 * (end - start) / getTickFrequency();
+
+        if (!detections_.empty()) {
+            for (const auto& box : detections_) {
+                result.boxes.push_back({box, Scalar(0, 255, 0), 2, 0, "drone"});
+            }
+            // 融合结果按支持的原始框数排序，第一个最可信
+            planner_.update(detections_[0]);
+            ++detected_;
+            if (context_.logFrames) {
+                cout << "✅ Frame " << i << " | Detections: " << detections_.size();
+                if (window.fullFrame) {
+                    cout << " | Full Img";
+                } else {
+                    cout << " | ROI ✅ stage " << window.stage;
+                }
+                cout << " | Time: " << fixed << setprecision(2) << elapsed_ms << " ms" << endl;
+            }
+        } else {
+            planner_.miss();
+            if (context_.logFrames) {
+                cout << "❌ Frame " << i << " | No detection | Time: " << fixed << setprecision(2) << elapsed_ms << " ms" << endl;
+            }
+        }
+
+        return result;
+    }
+
+private:
+    SessionContext context_;
+    EnsembleSettings settings_;
+    HaarEnsemble ensemble_;
+
+    // 搜索窗口按跟踪预测定大小，未命中时逐帧放大，几帧都找不到才整帧检测
+    SearchWindowPlanner planner_;
+    vector<Rect> detections_;  // 逐帧复用
+};
+
+class EnsembleModel : public DetectorModel {
+public:
+    explicit EnsembleModel(const EnsembleSettings& settings) : settings_(settings), cascades_(settings.ensemble) {}
+
+    bool load(const string& assetRoot, string& error) {
+        return loadCascades(assetRoot, CASCADE_PATHS, cascades_, error);
+    }
+
+    unique_ptr<DetectorSession> createSession(const SessionContext& context) const override {
+        return make_unique<EnsembleSession>(context, cascades_, settings_);
+    }
+
+    string describe() const override {
+        ostringstream out;
+        out << "🧩 " << cascades_.size() << " cascades, " << cascades_.compiledCount() << " compiled ["
+            << cascades_.backend() << "]";
+        return out.str();
+    }
+
+private:
+    EnsembleSettings settings_;
+    HaarEnsemble cascades_;
+};
+
+unique_ptr<DetectorModel> loadEnsembleModel(const string& assetRoot, const Tunables& tune, string& error) {
+    EnsembleSettings settings;
+    int fusion = 0;
+    if (!tune.getInt("fusion", FUSION == EnsembleFusion::Vote ? 1 : 0, fusion, error) ||
+        !checkRange("fusion", fusion, 0, 1, error)) {
+        return nullptr;
+    }
+    settings.ensemble.fusion = fusion == 1 ? EnsembleFusion::Vote : EnsembleFusion::Union;
+    if (settings.ensemble.fusion == EnsembleFusion::Vote &&
+        (!tune.getInt("min_votes", MIN_VOTES, settings.ensemble.minVotes, error) ||
+         !checkMin("min_votes", settings.ensemble.minVotes, 1, error))) {
+        return nullptr;
+    }
+    settings.scan = {MIN_OBJECT, SCALE_FACTOR, MIN_NEIGHBORS};
+    if (!readHaarScanSettings(tune, settings.scan, error)) return nullptr;
+
+    auto model = make_unique<EnsembleModel>(settings);
+    if (!model->load(assetRoot, error)) return nullptr;
+    return model;
+}
+
+}  // namespace
+
+RegisteredDetector haarEnsembleDetector() {
+    return {"detect_haar_ensemble", loadEnsembleModel, "_haar_ensemble.jpg", IMAGE_FOLDER, OUTPUT_FOLDER,
+            "Haar Ensemble Detection"};
+}
+
+}  // namespace haar
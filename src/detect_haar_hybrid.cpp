@@ -0,0 +1,194 @@
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <iomanip>
+
+#include "detector_registry.h"
+#include "haar_model.h"
+#include "keyframe_scheduler.h"
+#include "latency_stats.h"
+#include "trace.h"
+
+using namespace cv;
+using namespace std;
+
+namespace haar {
+
+namespace {
+
+// === 配置参数 ===（路径相对 assetRoot）
+const string CASCADE_PATH = "haarcascade_drone4.xml";
+const string IMAGE_FOLDER  = "img/video_01";
+const string OUTPUT_FOLDER = "output_haar_hybrid";
+const Size MIN_OBJECT(40, 40);
+const int KEYFRAME_INTERVAL = 10;  // 跟踪稳定时每隔几帧跑一次 Haar
+const double FRAME_BUDGET_MS = 0;  // 每帧平均用时预算，超出时拉长关键帧间隔；0 不限
+const double SCALE_FACTOR = 1.1;
+const int MIN_NEIGHBORS = 3;
+const bool TILED_FULL_SCAN = true;  // 跟丢后整帧检测分块并行（见 HaarDetector::detectMultiScaleTiled），结果不变
+// 运行时可覆盖（见 tunables.h）：min_width / min_height、keyframe_interval、frame_budget_ms、scale_factor、min_neighbors、
+// tiled_full_scan（0 / 1）
+
+struct HybridSettings {
+    HaarScanSettings scan;
+    KeyframeSchedulerOptions schedule;
+    bool tiledFullScan;
+};
+
+// 一路视频：检测器、模板和跟踪状态只属于这个会话
+class HybridSession : public DetectorSession {
+public:
+    HybridSession(const SessionContext& context, const HaarDetector& cascade, const HybridSettings& settings)
+        : context_(context), settings_(settings), scheduler_(settings.schedule) {
+        droneCascade_.loadFrom(cascade);
+    }
+
+    FrameResult process(const Frame& f) override {
+        const Mat& frame = f.image;
+        size_t i = f.index;
+        ++frames_;
+
+        int64 start = getTickCount();
+
+        FrameResult result;
+
+        StageTimer stages(context_.latency, STAGE_ROI);
+        bool keyframe = scheduler_.path(frame.size()) == FramePath::Detect;
+
+        stages.next(STAGE_DETECT);
+        Rect box;
+        double score = 0;
+        bool found = false;
+        if (!keyframe) {
+            found = scheduler_.track(frame, box, score);
+            result.searchRegion = scheduler_.trackWindow();
+            keyframe = !found;  // 模板跟丢，本帧改跑 Haar
+        }
+        if (keyframe) {
+            const SearchWindow& window = scheduler_.detectWindow();
+            Size minSize = settings_.scan.minObject, maxSize;
+            window.narrow(minSize, maxSize);
+            HAAR_TRACE_ARG("roi_width", window.roi.width);
+            HAAR_TRACE_ARG("roi_height", window.roi.height);
+            if (window.fullFrame && settings_.tiledFullScan) {
+                droneCascade_.detectMultiScaleTiled(frame(window.roi), detections_, context_.pool,
+                                                    settings_.scan.scaleFactor, settings_.scan.minNeighbors, minSize,
+                                                    maxSize);
+            } else {
+                droneCascade_.detectMultiScale(frame(window.roi), detections_, settings_.scan.scaleFactor,
+                                               settings_.scan.minNeighbors, 0, minSize, maxSize);
+            }
+            for (auto& d : detections_) d += window.roi.tl();
+            result.searchRegion = window.fullFrame ? Rect() : window.roi;
+            found = !detections_.empty();
+            if (found) box = pickDetection();
+        }
+
+        stages.next(STAGE_TRACK);
+        if (keyframe) {
+            if (found) {
+                scheduler_.detected(frame, box);
+            } else {
+                scheduler_.missed();
+            }
+        }
+        if (found) {
+            result.boxes.push_back({box, keyframe ? Scalar(0, 255, 0) : Scalar(255, 255, 0), 2, score,
+                                    keyframe ? "drone" : "tracked"});
+            ++detected_;
+        }
+
+        stages.stop();
+        int64 end = getTickCount();
+        double elapsed_ms = 1000.0 * (end - start) / getTickFrequency();
+        scheduler_.finish(elapsed_ms);
+
+        if (context_.logFrames) {
+            cout << (found ? "✅ Frame " : "❌ Frame ") << i << (keyframe ? " | Haar" : " | Template");
+            if (!keyframe) cout << " | Score: " << fixed << setprecision(2) << score;
+            cout << " | Time: " << fixed << setprecision(2) << elapsed_ms << " ms" << endl;
+        }
+
+        return result;
+    }
+
+    void finish() override {
+        if (!context_.logFrames) return;
+        cout << "🔑 Keyframes: " << scheduler_.keyframes() << "/" << frames_
+             << " (escalated " << scheduler_.escalations() << ") | Avg: " << fixed << setprecision(2)
+             << scheduler_.averageMs() << " ms | Interval: " << scheduler_.keyframeInterval() << endl;
+    }
+
+private:
+    // 之后各帧的模板从这个框重切：跟踪中取中心离预测位置最近的，否则取面积最大的
+    Rect pickDetection() const {
+        const bool tracking = scheduler_.tracking();
+        const Rect predicted = scheduler_.predicted();
+        const Point2f center(predicted.x + predicted.width / 2.f, predicted.y + predicted.height / 2.f);
+        Rect best = detections_[0];
+        double bestCost = 0;
+        for (size_t k = 0; k < detections_.size(); ++k) {
+            const Rect& d = detections_[k];
+            const double dx = d.x + d.width / 2.f - center.x, dy = d.y + d.height / 2.f - center.y;
+            const double cost = tracking ? dx * dx + dy * dy : -double(d.area());
+            if (k == 0 || cost < bestCost) {
+                best = d;
+                bestCost = cost;
+            }
+        }
+        return best;
+    }
+
+    SessionContext context_;
+    HybridSettings settings_;
+    HaarDetector droneCascade_;
+
+    // Haar 只在关键帧上跑，中间帧用从最近一次检测框切出的模板跟踪
+    KeyframeScheduler scheduler_;
+    vector<Rect> detections_;  // 逐帧复用
+    size_t frames_ = 0;
+};
+
+class HybridModel : public DetectorModel {
+public:
+    explicit HybridModel(const HybridSettings& settings) : settings_(settings) {}
+
+    bool load(const string& assetRoot, string& error) {
+        return loadCascade(assetRoot, CASCADE_PATH, cascade_, error);
+    }
+
+    unique_ptr<DetectorSession> createSession(const SessionContext& context) const override {
+        return make_unique<HybridSession>(context, cascade_, settings_);
+    }
+
+private:
+    HaarDetector cascade_;
+    HybridSettings settings_;
+};
+
+unique_ptr<DetectorModel> loadHybridModel(const string& assetRoot, const Tunables& tune, string& error) {
+    HybridSettings settings;
+    settings.schedule.budgetMs = tune.get("frame_budget_ms", FRAME_BUDGET_MS);
+    settings.scan = {MIN_OBJECT, SCALE_FACTOR, MIN_NEIGHBORS};
+    int tiledFullScan = 0;
+    if (!readHaarScanSettings(tune, settings.scan, error) ||
+        !tune.getInt("keyframe_interval", KEYFRAME_INTERVAL, settings.schedule.keyframeInterval, error) ||
+        !tune.getInt("tiled_full_scan", TILED_FULL_SCAN, tiledFullScan, error) ||
+        !checkMin("keyframe_interval", settings.schedule.keyframeInterval, 1, error) ||
+        !checkMin("frame_budget_ms", settings.schedule.budgetMs, 0, error)) {
+        return nullptr;
+    }
+    settings.tiledFullScan = tiledFullScan != 0;
+
+    auto model = make_unique<HybridModel>(settings);
+    if (!model->load(assetRoot, error)) return nullptr;
+    return model;
+}
+
+}  // namespace
+
+RegisteredDetector haarHybridDetector() {
+    return {"detect_haar_hybrid", loadHybridModel, "_haar_hybrid.jpg", IMAGE_FOLDER, OUTPUT_FOLDER,
+            "Haar + Template Hybrid"};
+}
+
+}  // namespace haar
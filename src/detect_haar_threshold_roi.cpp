@@ -1,85 +1,87 @@
 #include <opencv2/opencv.hpp>
-#include <filesystem>
 #include <iostream>
 #include <iomanip>
+#include <sstream>
+
+#include "blob_extractor.h"
+#include "detector_registry.h"
+#include "haar_model.h"
+#include "latency_stats.h"
+#include "reduced_detection.h"
+#include "trace.h"
 
-namespace fs = std::filesystem;
 using namespace cv;
 using namespace std;
 
-// === 配置参数 ===
-const string CASCADE_PATH = "../haarcascade_drone3.xml";
-const string IMAGE_FOLDER  = "../img/video_01";
-const string OUTPUT_FOLDER = "../output_haar_roi80*80";
-
-vector<string> getSortedImagePaths(const string& folder_path) {
-    vector<string> files;
-    for (const auto& entry : fs::directory_iterator(folder_path)) {
-        files.push_back(entry.path().string());
-    }
-    sort(files.begin(), files.end());
-    return files;
-}
-
-Rect getThresholdROI(const Mat& gray) {
-    Mat thresh;
-    threshold(gray, thresh, 80, 255, THRESH_BINARY);
-    morphologyEx(thresh, thresh, MORPH_CLOSE, getStructuringElement(MORPH_RECT, Size(5, 5)));
-
-    vector<vector<Point>> contours;
-    findContours(thresh, contours, RETR_EXTERNAL, CHAIN_APPROX_SIMPLE);
-
-    Rect roi;
-    int maxArea = 0;
-    for (const auto& c : contours) {
-        Rect r = boundingRect(c);
-        int area = r.area();
-        if (area > maxArea) {
-            roi = r;
-            maxArea = area;
-        }
+namespace haar {
+
+namespace {
+
+// === 配置参数 ===（路径相对 assetRoot）
+const string CASCADE_PATH = "haarcascade_drone3.xml";
+const string IMAGE_FOLDER  = "img/video_01";
+const string OUTPUT_FOLDER = "output_haar_roi80*80";
+const size_t CANDIDATE_BLOBS = 1;  // 送进 Haar 的候选区域数：阈值分割后外接框最大的前 N 个连通域
+const Size MIN_TARGET(80, 60);     // 最小目标尺寸，同时决定能缩小几倍检测（见 chooseReduction）
+const Size MAX_TARGET(160, 120);
+const int BINARY_THRESHOLD = 80;   // 灰度 > 该值为前景
+const double SCALE_FACTOR = 1.1;
+const int MIN_NEIGHBORS = 5;
+const bool TILED_FULL_SCAN = true;  // 没有前景、兜底查全图时分块并行（见 HaarDetector::detectMultiScaleTiled）
+// 以上除 CANDIDATE_BLOBS 外都可在运行时覆盖（见 tunables.h）：min_width / min_height、max_width / max_height、
+// threshold、scale_factor、min_neighbors、tiled_full_scan（0 / 1）
+
+struct ThresholdRoiSettings {
+    HaarScanSettings scan;  // scan.minObject 即最小目标尺寸
+    Size maxTarget;
+    int threshold;
+    bool tiledFullScan;
+};
+
+// 一路视频：检测器的缓冲区只属于这个会话，稳态下 process() 不做堆分配
+class ThresholdRoiSession : public DetectorSession {
+public:
+    ThresholdRoiSession(const SessionContext& context, const HaarDetector& cascade,
+                        const ThresholdRoiSettings& settings)
+        : context_(context), settings_(settings), blobs_(blobOptions(settings)) {
+        // 目标足够大时在缩小图上检测、原分辨率精修；缩小图由解码线程生成
+        droneCascade_.load(cascade);
+        droneCascade_.configure(settings_.scan.minObject);
     }
-    return roi;
-}
 
-int main() {
-    CascadeClassifier droneCascade;
-    if (!droneCascade.load(CASCADE_PATH)) {
-        cerr << "❌ Failed to load Haar classifier: " << CASCADE_PATH << endl;
-        return -1;
-    }
+    int reduceBy() const override { return droneCascade_.reduceBy(); }
 
-    fs::create_directories(OUTPUT_FOLDER);
-    vector<string> image_paths = getSortedImagePaths(IMAGE_FOLDER);
-
-    for (size_t i = 0; i < image_paths.size(); ++i) {
-        string img_path = image_paths[i];
-        Mat gray = imread(img_path, IMREAD_GRAYSCALE);
-        if (gray.empty()) continue;
+    FrameResult process(const Frame& f) override {
+        const Mat& gray = f.image;
+        size_t i = f.index;
 
         int64 start = getTickCount();
 
         // Step 1: 提取目标候选区域
-        Rect roi = getThresholdROI(gray);
-        if (roi.area() == 0) roi = Rect(0, 0, gray.cols, gray.rows);  // 兜底：全图
-
-        Mat roiImg = gray(roi);
-        vector<Rect> detections;
-        droneCascade.detectMultiScale(roiImg, detections, 1.1, 5, 0, Size(80, 60), Size(160, 120));
-
-        // 坐标修正到全图
-        for (auto& d : detections) {
-            d.x += roi.x;
-            d.y += roi.y;
+        StageTimer stages(context_.latency, STAGE_ROI);
+        const vector<Rect>& candidates = blobs_.extract(gray);
+        const Rect fullFrame(0, 0, gray.cols, gray.rows);  // 兜底：没有前景时查全图
+        HAAR_TRACE_ARG("candidates", candidates.size());
+
+        stages.next(STAGE_DETECT);
+        detections_.clear();
+        HAAR_TRACE_ARG("full_frame_fallback", candidates.empty() ? 1 : 0);
+        for (size_t c = 0; c < max<size_t>(candidates.size(), 1); ++c) {
+            Rect roi = candidates.empty() ? fullFrame : candidates[c];
+            droneCascade_.detectMultiScale(gray, f.reduced, roi, found_, settings_.scan.scaleFactor,
+                                           settings_.scan.minNeighbors, settings_.scan.minObject, settings_.maxTarget,
+                                           settings_.tiledFullScan && candidates.empty(), context_.pool);
+            detections_.insert(detections_.end(), found_.begin(), found_.end());
         }
 
-        // Step 2: 可视化结果
-        Mat display;
-        cvtColor(gray, display, COLOR_GRAY2BGR);
+        // Step 2: 选出面积最大的框
+        stages.next(STAGE_TRACK);
+        FrameResult result;
+        if (!candidates.empty()) result.searchRegion = candidates[0];
         Rect bestBox;
         int maxArea = 0;
 
-        for (const auto& box : detections) {
+        for (const auto& box : detections_) {
             int area = box.area();
             if (area > maxArea) {
                 bestBox = box;
@@ -87,23 +89,93 @@ int main() {
             }
         }
 
+        stages.stop();
         int64 end = getTickCount();
         double elapsed_ms = 1000.0 * (end - start) / getTickFrequency();
 
         if (maxArea > 0) {
-            rectangle(display, bestBox, Scalar(0, 255, 0), 2);
-            cout << "✅ Frame " << i << " | 1 Target | Time: "
-                 << fixed << setprecision(2) << elapsed_ms << " ms" << endl;
-        } else {
+            result.boxes.push_back({bestBox, Scalar(0, 255, 0), 2, 0, "drone"});
+            ++detected_;
+            if (context_.logFrames) {
+                cout << "✅ Frame " << i << " | 1 Target | Time: "
+                     << fixed << setprecision(2) << elapsed_ms << " ms" << endl;
+            }
+        } else if (context_.logFrames) {
             cout << "❌ Frame " << i << " | No detection | Time: "
                  << fixed << setprecision(2) << elapsed_ms << " ms" << endl;
         }
 
-        string out_path = OUTPUT_FOLDER + "/" + fs::path(img_path).stem().string() + "_haar_thresh.jpg";
-        imwrite(out_path, display);
-        imshow("Haar + Threshold Detection", display);
-        waitKey(1);
+        return result;
+    }
+
+private:
+    static BlobExtractorOptions blobOptions(const ThresholdRoiSettings& settings) {
+        BlobExtractorOptions options;
+        options.maxBlobs = CANDIDATE_BLOBS;
+        options.threshold = settings.threshold;
+        return options;
     }
 
-    return 0;
+    SessionContext context_;
+    ThresholdRoiSettings settings_;
+    ReducedResolutionDetector droneCascade_;
+
+    // 逐帧复用的缓冲
+    BlobExtractor blobs_;
+    vector<Rect> found_, detections_;
+};
+
+class ThresholdRoiModel : public DetectorModel {
+public:
+    explicit ThresholdRoiModel(const ThresholdRoiSettings& settings) : settings_(settings) {}
+
+    bool load(const string& assetRoot, string& error) {
+        return loadCascade(assetRoot, CASCADE_PATH, cascade_, error);
+    }
+
+    unique_ptr<DetectorSession> createSession(const SessionContext& context) const override {
+        return make_unique<ThresholdRoiSession>(context, cascade_, settings_);
+    }
+
+    string describe() const override {
+        const Size window = cascade_.windowSize();
+        ostringstream out;
+        out << "🔍 Detection scale 1/"
+            << chooseReduction(window, settings_.scan.minObject, ReducedDetectionOptions().factors) << " (window "
+            << window.width << "x" << window.height << ")";
+        return out.str();
+    }
+
+private:
+    HaarDetector cascade_;
+    ThresholdRoiSettings settings_;
+};
+
+unique_ptr<DetectorModel> loadThresholdRoiModel(const string& assetRoot, const Tunables& tune, string& error) {
+    ThresholdRoiSettings settings;
+    settings.scan = {MIN_TARGET, SCALE_FACTOR, MIN_NEIGHBORS};
+    int tiledFullScan = 0;
+    if (!readHaarScanSettings(tune, settings.scan, error) ||
+        !tune.getSize("max", MAX_TARGET, settings.maxTarget, error) ||
+        !tune.getInt("threshold", BINARY_THRESHOLD, settings.threshold, error) ||
+        !tune.getInt("tiled_full_scan", TILED_FULL_SCAN, tiledFullScan, error) ||
+        !checkMin("max_width", settings.maxTarget.width, 0, error) ||
+        !checkMin("max_height", settings.maxTarget.height, 0, error) ||
+        !checkRange("threshold", settings.threshold, 0, 255, error)) {
+        return nullptr;
+    }
+    settings.tiledFullScan = tiledFullScan != 0;
+
+    auto model = make_unique<ThresholdRoiModel>(settings);
+    if (!model->load(assetRoot, error)) return nullptr;
+    return model;
 }
+
+}  // namespace
+
+RegisteredDetector haarThresholdRoiDetector() {
+    return {"detect_haar_threshold_roi", loadThresholdRoiModel, "_haar_thresh.jpg", IMAGE_FOLDER, OUTPUT_FOLDER,
+            "Haar + Threshold Detection"};
+}
+
+}  // namespace haar
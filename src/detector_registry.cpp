@@ -0,0 +1,156 @@
+#include "detector_registry.h"
+#include "frame_store.h"
+#include "result_sinks.h"
+#include "work_stealing_pool.h"
+
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+
+namespace fs = std::filesystem;
+using namespace std;
+
+namespace haar {
+
+// 定义在各检测器源文件里
+RegisteredDetector contourDetector();
+RegisteredDetector haarRoiDetector();
+RegisteredDetector haarThresholdRoiDetector();
+RegisteredDetector haarEnsembleDetector();
+RegisteredDetector haarHybridDetector();
+RegisteredDetector templateDetector();
+RegisteredDetector boxEstimationDetector();
+
+const vector<RegisteredDetector>& registeredDetectors() {
+    static const vector<RegisteredDetector> detectors = {
+        contourDetector(),      haarRoiDetector(),    haarThresholdRoiDetector(), haarEnsembleDetector(),
+        haarHybridDetector(),   templateDetector(),   boxEstimationDetector(),
+    };
+    return detectors;
+}
+
+const RegisteredDetector* findDetector(const string& name) {
+    for (const auto& d : registeredDetectors()) {
+        if (d.name == name) return &d;
+    }
+    return nullptr;
+}
+
+string defaultAssetRoot() {
+    const char* root = getenv("HAAR_ASSETS");
+    return root && *root ? root : "..";
+}
+
+string assetPath(const string& assetRoot, const string& relative) {
+    return (fs::path(assetRoot) / relative).string();
+}
+
+SequenceReport runSequence(const DetectorModel& model, const RegisteredDetector& detector, const string& folder,
+                           const string& outputFolder, const PipelineOptions& options, bool logFrames) {
+    SessionContext context;
+    context.latency = options.latency;
+    context.pool = options.pool;
+    context.logFrames = logFrames;
+    context.outputFolder = outputFolder;
+    unique_ptr<DetectorSession> session = model.createSession(context);
+
+    // 会话要缩小图时由解码线程生成
+    PipelineOptions pipelineOptions = options;
+    pipelineOptions.reduceBy = session->reduceBy();
+
+    unique_ptr<FrameSource> source = openFrameSource(folder, pipelineOptions);  // 图片目录、.frames 打包文件，或 --live 时的视频 / 设备
+    unique_ptr<FrameSink> sink = makeSink(options, outputFolder, detector.imageSuffix);
+
+    SequenceReport report;
+    FramePipeline pipeline(*source, *sink, pipelineOptions);
+    report.frames = pipeline.run([&](const Frame& f) {
+        FrameResult result = session->process(f);
+        report.droppedBoxes += result.boxes.dropped();  // 检测回调只在检测线程上调用
+        return result;
+    });
+    session->finish();
+    report.detected = session->detected();
+    if (report.droppedBoxes > 0) {
+        cerr << "⚠️ " << sequenceName(folder) << ": " << report.droppedBoxes << " boxes beyond the per-frame limit of "
+             << BoxList::kCapacity << " were dropped from the output" << endl;
+    }
+    return report;
+}
+
+int detectorMain(const string& name, int argc, char** argv) {
+    const RegisteredDetector* detector = findDetector(name);
+    if (!detector) {
+        cerr << "❌ Unknown detector: " << name << endl;
+        return 2;
+    }
+
+    PipelineOptions base;  // 输出与调参参数（--sink / --preview-every / --video-fps / --trace / --set / --config，见 result_sinks.h）
+    string assetRoot = defaultAssetRoot();
+    vector<string> folders;
+    for (int i = 1; i < argc; ++i) {
+        const string arg = argv[i];
+        if (arg == "--assets") {
+            if (i + 1 >= argc) {
+                cerr << "❌ Missing value for " << arg << endl;
+                return 2;
+            }
+            assetRoot = argv[++i];
+        } else if (!parseOutputFlag(argc, argv, i, base)) {
+            folders.push_back(arg);
+        }
+    }
+
+    string error;
+    unique_ptr<DetectorModel> model = detector->load(assetRoot, base.tunables, error);
+    if (!model) {
+        cerr << "❌ " << error << endl;
+        return -1;
+    }
+    // 拼错的名字或本检测器不认的参数：不报错就会悄悄按默认值跑
+    const vector<string> unknown = base.tunables.unread();
+    if (!unknown.empty()) {
+        cerr << "❌ Unknown tunable for " << name << ": " << joinNames(unknown) << endl;
+        return 2;
+    }
+    const string summary = model->describe();
+    if (!summary.empty()) cout << summary << endl;
+
+    const string outputFolder = assetPath(assetRoot, detector->outputFolder);
+    // 打不开的输入（目录不存在、设备打不开）不一定抛异常，只是一帧也读不到：两种都算失败，脚本靠返回值发现
+    if (folders.empty()) {
+        PipelineOptions options = base;
+        options.previewWindow = detector->previewWindow;
+        const string folder = assetPath(assetRoot, detector->defaultSequence);
+        try {
+            const SequenceReport report = runSequence(*model, *detector, folder, outputFolder, options, true);
+            if (report.frames == 0) {
+                cerr << "❌ No frames processed from " << folder << endl;
+                return 1;
+            }
+        } catch (const exception& e) {
+            cerr << "❌ " << folder << ": " << e.what() << endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    BatchReport report = runBatch(folders, [&](const string& folder, WorkStealingPool& pool) {
+        PipelineOptions options = base;
+        options.pool = &pool;
+        return runSequence(*model, *detector, folder, outputFolder + "/" + sequenceName(folder), options, false);
+    });
+    printBatchReport(report);
+    int failed = 0;
+    for (const auto& s : report.sequences) {
+        if (!s.error.empty()) {
+            ++failed;
+        } else if (s.frames == 0) {
+            cerr << "❌ No frames processed from " << s.name << endl;
+            ++failed;
+        }
+    }
+    return failed > 0 ? 1 : 0;
+}
+
+}  // namespace haar
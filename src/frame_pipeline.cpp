@@ -0,0 +1,371 @@
+#include "frame_pipeline.h"
+#include "alloc_counter.h"
+#include "bounded_queue.h"
+#include "latency_stats.h"
+#include "trace.h"
+#include "work_stealing_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace fs = std::filesystem;
+using namespace cv;
+using namespace std;
+
+namespace haar {
+
+namespace {
+
+// 池上任务结束时（包括抛异常）递减计数
+struct CountdownGuard {
+    atomic<size_t>& count;
+    ~CountdownGuard() { --count; }
+};
+
+double elapsedMs(chrono::steady_clock::time_point start) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// 检测回调记为一条 "frame" span，回调内各阶段的 span 嵌套在它下面
+FrameResult detectTraced(const FramePipeline::DetectFn& detect, const Frame& frame) {
+    HAAR_TRACE_SCOPE("frame");
+    HAAR_TRACE_ARG("frame", frame.index);
+    FrameResult result = detect(frame);
+    HAAR_TRACE_ARG("boxes", result.boxes.size());
+    return result;
+}
+
+}  // namespace
+
+vector<string> getSortedImagePaths(const string& folder_path) {
+    vector<string> files;
+    for (const auto& entry : fs::directory_iterator(folder_path)) {
+        files.push_back(entry.path().string());
+    }
+    sort(files.begin(), files.end());
+    return files;
+}
+
+void renderAnnotations(const Frame& frame, const FrameResult& result, Mat& display) {
+    if (result.colorOutput) {
+        cvtColor(frame.image, display, COLOR_GRAY2BGR);
+    } else {
+        frame.image.copyTo(display);
+    }
+    for (const auto& a : result.boxes) {
+        rectangle(display, a.box, a.color, a.thickness);
+    }
+}
+
+Mat renderAnnotations(const Frame& frame, const FrameResult& result) {
+    Mat display;
+    renderAnnotations(frame, result, display);
+    return display;
+}
+
+ImageFolderSource::ImageFolderSource(const string& folder)
+    : paths_(getSortedImagePaths(folder)) {}
+
+bool ImageFolderSource::load(size_t index, Frame& frame) const {
+    frame.index = index;
+    frame.path = paths_[index];
+    frame.image = imread(frame.path, IMREAD_GRAYSCALE);
+    return !frame.image.empty();
+}
+
+ImageWriterSink::ImageWriterSink(const string& outputFolder, const string& suffix)
+    : outputFolder_(outputFolder), suffix_(suffix) {
+    fs::create_directories(outputFolder_);
+}
+
+void ImageWriterSink::consume(const Frame& frame, const FrameResult& result) {
+    fs::path src(frame.path);
+    string name = suffix_.empty() ? src.filename().string() : src.stem().string() + suffix_;
+    thread_local Mat display;  // 每个编码线程复用一块绘制缓冲
+    renderAnnotations(frame, result, display);
+    imwrite(outputFolder_ + "/" + name, display);
+}
+
+FramePipeline::FramePipeline(const FrameSource& source, FrameSink& sink, PipelineOptions options)
+    : source_(source), sink_(sink), options_(std::move(options)) {}
+
+size_t FramePipeline::run(const DetectFn& detect) {
+    if (source_.live()) return runLive(detect);
+    return options_.pool ? runOnPool(detect) : runThreaded(detect);
+}
+
+// 只预览每 previewEvery 帧中的一帧，其余帧不付 imshow + waitKey 的代价
+void FramePipeline::present(const Frame& frame, const FrameResult& result) {
+    if (options_.previewWindow.empty() || options_.previewEvery <= 0) return;
+    if (frame.index % options_.previewEvery != 0) return;
+    renderAnnotations(frame, result, preview_);
+    imshow(options_.previewWindow, preview_);
+    waitKey(1);
+}
+
+size_t FramePipeline::runThreaded(const DetectFn& detect) {
+    const size_t total = source_.size();
+    OrderedQueue<Frame> decoded(options_.queueDepth);
+    BoundedQueue<pair<Frame, FrameResult>> pending(options_.queueDepth);
+    atomic<size_t> nextIndex{0};
+
+    vector<thread> workers;
+    auto shutdown = [&] {
+        decoded.close();
+        pending.close();
+        for (auto& t : workers) {
+            if (t.joinable()) t.join();
+        }
+    };
+
+    // 解码 / 编码线程上的异常：记下第一个并关掉两个队列让各线程停下，由检测线程重新抛出
+    mutex errorMutex;
+    exception_ptr workerError;
+    auto fail = [&] {
+        {
+            lock_guard<mutex> lock(errorMutex);
+            if (!workerError) workerError = current_exception();
+        }
+        decoded.close();
+        pending.close();
+    };
+    auto rethrowWorkerError = [&] {
+        lock_guard<mutex> lock(errorMutex);
+        if (workerError) rethrow_exception(workerError);
+    };
+
+    // 解码线程：领取帧号并解码，读取失败的帧以空图占位，保证检测端帧序连续
+    for (int t = 0; t < max(options_.decodeThreads, 1); ++t) {
+        workers.emplace_back([&, t] {
+            trace::setThreadName("decode " + to_string(t));
+            try {
+                for (size_t i = nextIndex++; i < total; i = nextIndex++) {
+                    Frame frame;
+                    auto start = chrono::steady_clock::now();
+                    {
+                        StageTimer timer(options_.latency, STAGE_DECODE);
+                        loadFrame(i, frame);
+                    }
+                    frame.index = i;
+                    frame.decodeMs = elapsedMs(start);
+                    if (!decoded.push(i, std::move(frame))) break;
+                }
+            } catch (...) {
+                fail();
+            }
+        });
+    }
+
+    // 编码线程：绘制 + imwrite，输出顺序不作保证
+    for (int t = 0; t < max(options_.encodeThreads, 1); ++t) {
+        workers.emplace_back([&, t] {
+            trace::setThreadName("encode " + to_string(t));
+            try {
+                pair<Frame, FrameResult> item;
+                while (pending.pop(item)) {
+                    StageTimer timer(options_.latency, STAGE_ENCODE);
+                    sink_.consume(item.first, item.second);
+                }
+            } catch (...) {
+                fail();
+            }
+        });
+    }
+
+    size_t processed = 0;
+    AllocationStats allocationStats;  // 只在 HAAR_COUNT_ALLOCATIONS 构建中有数
+    try {
+        Frame frame;
+        for (size_t i = 0; i < total && decoded.pop(frame); ++i) {
+            if (frame.image.empty()) continue;
+
+            auto start = chrono::steady_clock::now();
+            AllocationScope allocations;
+            FrameResult result = detectTraced(detect, frame);
+            allocationStats.add(allocations.count());
+            result.detectMs = elapsedMs(start);
+            result.sequence = processed++;
+
+            present(frame, result);
+            if (!pending.push({std::move(frame), std::move(result)})) break;
+        }
+        rethrowWorkerError();  // 队列被关掉而提前结束时
+    } catch (...) {
+        shutdown();
+        throw;
+    }
+
+    // 正常结束：先让编码线程把剩余帧写完
+    pending.close();
+    shutdown();
+    rethrowWorkerError();
+    if (allocationCountingEnabled()) allocationStats.print("detect");
+    return processed;
+}
+
+// 实时输入：帧由来源的采集线程解码并只保留最新的几帧，检测线程每次取最新的一帧，跟不上时旧帧被丢掉；
+// 编码总在自己的编码线程上做（实时输入不走批处理的池）。帧号是采集序号，丢帧数由帧号的空缺得出
+size_t FramePipeline::runLive(const DetectFn& detect) {
+    BoundedQueue<pair<Frame, FrameResult>> pending(options_.queueDepth);
+    vector<thread> workers;
+    auto shutdown = [&] {
+        pending.close();
+        for (auto& t : workers) {
+            if (t.joinable()) t.join();
+        }
+    };
+
+    for (int t = 0; t < max(options_.encodeThreads, 1); ++t) {
+        workers.emplace_back([&, t] {
+            trace::setThreadName("encode " + to_string(t));
+            pair<Frame, FrameResult> item;
+            while (pending.pop(item)) {
+                StageTimer timer(options_.latency, STAGE_ENCODE);
+                sink_.consume(item.first, item.second);
+            }
+        });
+    }
+
+    size_t processed = 0, received = 0, captured = 0;
+    LatencyRecorder endToEnd;  // 结束时的汇总；options_.latency 也记一份
+    AllocationStats allocationStats;
+    try {
+        Frame frame;
+        while (source_.next(frame)) {
+            ++received;
+            captured = max(captured, frame.index + 1);
+            if (frame.image.empty()) continue;
+            if (options_.latency) options_.latency->record(STAGE_DECODE, frame.decodeMs);
+
+            auto start = chrono::steady_clock::now();
+            AllocationScope allocations;
+            FrameResult result = detectTraced(detect, frame);
+            allocationStats.add(allocations.count());
+            result.detectMs = elapsedMs(start);
+            result.sequence = processed++;
+
+            const double latencyMs = elapsedMs(frame.captured);
+            endToEnd.record(STAGE_CAPTURE_TO_RESULT, latencyMs);
+            if (options_.latency) options_.latency->record(STAGE_CAPTURE_TO_RESULT, latencyMs);
+
+            present(frame, result);
+            pending.push({std::move(frame), std::move(result)});
+        }
+    } catch (...) {
+        shutdown();
+        throw;
+    }
+    shutdown();
+
+    const LatencySummary l = endToEnd.summary(STAGE_CAPTURE_TO_RESULT);
+    const size_t dropped = captured - received;
+    cout << "📡 Live | Captured: " << captured << " | Processed: " << processed << " | Dropped: " << dropped
+         << fixed << setprecision(1) << " (" << (captured ? 100.0 * dropped / captured : 0.0) << "%)"
+         << setprecision(2) << " | Capture→result p50 " << l.p50 << " | p95 " << l.p95 << " | p99 " << l.p99
+         << " | max " << l.max << " ms" << endl;
+    if (allocationCountingEnabled()) allocationStats.print("detect");
+    return processed;
+}
+
+// 原分辨率之外还要缩小图时在解码线程上一并做掉：检测仍要原图（精修、输出），JPEG 的缩小解码用不上
+void FramePipeline::loadFrame(size_t index, Frame& frame) const {
+    source_.load(index, frame);
+    if (options_.reduceBy > 1 && !frame.image.empty()) {
+        const double f = 1.0 / options_.reduceBy;
+        resize(frame.image, frame.reduced, Size(), f, f, INTER_AREA);
+    }
+}
+
+size_t FramePipeline::runOnPool(const DetectFn& detect) {
+    WorkStealingPool& pool = *options_.pool;
+    const size_t total = source_.size();
+    const size_t depth = max<size_t>(options_.queueDepth, 1);
+
+    // 每帧一个槽位：预取任务和检测线程谁先领到谁解码，检测线程从不空等一个没人做的解码
+    enum : int { kIdle = 0, kDecoding = 1, kReady = 2 };
+    struct Slot {
+        atomic<int> state{kIdle};
+        Frame frame;
+    };
+    unique_ptr<Slot[]> slots(new Slot[total]);
+    atomic<size_t> inflight{0};  // 已提交未完成的任务，引用了本函数的局部变量
+    atomic<size_t> encoding{0};
+
+    auto decode = [&](size_t i) {
+        int expected = kIdle;
+        if (!slots[i].state.compare_exchange_strong(expected, kDecoding)) return;
+        Frame frame;
+        auto start = chrono::steady_clock::now();
+        try {
+            StageTimer timer(options_.latency, STAGE_DECODE);
+            loadFrame(i, frame);
+        } catch (...) {
+            slots[i].state.store(kReady, memory_order_release);  // 空图占位，检测端跳过
+            throw;
+        }
+        frame.index = i;
+        frame.decodeMs = elapsedMs(start);
+        slots[i].frame = std::move(frame);
+        slots[i].state.store(kReady, memory_order_release);
+    };
+    auto prefetch = [&](size_t i) {
+        ++inflight;
+        pool.submit([&, i] {
+            CountdownGuard guard{inflight};
+            decode(i);
+        });
+    };
+
+    size_t processed = 0;
+    AllocationStats allocationStats;
+    try {
+        for (size_t i = 0; i < min(depth, total); ++i) prefetch(i);
+
+        for (size_t i = 0; i < total; ++i) {
+            if (i + depth < total) prefetch(i + depth);
+            decode(i);
+            pool.helpUntil([&] { return slots[i].state.load(memory_order_acquire) == kReady; });
+
+            Frame frame = std::move(slots[i].frame);
+            if (frame.image.empty()) continue;
+
+            auto start = chrono::steady_clock::now();
+            AllocationScope allocations;
+            FrameResult result = detectTraced(detect, frame);
+            allocationStats.add(allocations.count());
+            result.detectMs = elapsedMs(start);
+            result.sequence = processed++;
+            present(frame, result);
+
+            // 待编码帧数受 queueDepth 限制，超出时先帮忙编码
+            pool.helpUntil([&] { return encoding.load() < depth; });
+            auto item = make_shared<pair<Frame, FrameResult>>(std::move(frame), std::move(result));
+            ++encoding;
+            ++inflight;
+            pool.submit([this, item, &encoding, &inflight] {
+                CountdownGuard encoded{encoding};
+                CountdownGuard finished{inflight};
+                StageTimer timer(options_.latency, STAGE_ENCODE);
+                sink_.consume(item->first, item->second);
+            });
+        }
+    } catch (...) {
+        pool.helpUntil([&] { return inflight.load() == 0; });
+        throw;
+    }
+
+    pool.helpUntil([&] { return inflight.load() == 0; });
+    if (allocationCountingEnabled()) allocationStats.print("detect");
+    return processed;
+}
+
+}  // namespace haar
@@ -0,0 +1,213 @@
+#include "frame_store.h"
+#include "live_source.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+using namespace cv;
+using namespace std;
+
+namespace haar {
+
+namespace {
+
+const char kMagic[8] = {'H', 'A', 'A', 'R', 'F', 'R', 'M', '\0'};
+const uint32_t kVersion = 1;
+const uint32_t kPageSize = 4096;
+
+uint64_t alignUp(uint64_t v, uint64_t a) {
+    return (v + a - 1) / a * a;
+}
+
+bool seekTo(FILE* f, uint64_t pos) {
+#ifdef _WIN32
+    return _fseeki64(f, static_cast<__int64>(pos), SEEK_SET) == 0;
+#else
+    return fseeko(f, static_cast<off_t>(pos), SEEK_SET) == 0;
+#endif
+}
+
+}  // namespace
+
+FrameStoreWriter::FrameStoreWriter(const string& path, size_t frameCount)
+    : frameCount_(frameCount) {
+    file_ = fopen(path.c_str(), "wb");
+    end_ = alignUp(sizeof(FrameStoreHeader) + frameCount * sizeof(FrameStoreEntry), kPageSize);
+    entries_.reserve(frameCount);
+}
+
+FrameStoreWriter::~FrameStoreWriter() {
+    if (file_) fclose(file_);
+}
+
+bool FrameStoreWriter::add(const string& name, const Mat& gray) {
+    if (!file_ || entries_.size() >= frameCount_) return false;
+    CV_Assert(gray.empty() || gray.type() == CV_8UC1);
+
+    FrameStoreEntry e{};
+    strncpy(e.name, name.c_str(), sizeof(e.name) - 1);
+    // 读取失败的帧也占一个索引（宽高为 0），与 ImageFolderSource 的帧号保持一致
+    if (!gray.empty()) {
+        e.offset = end_;
+        e.width = static_cast<uint32_t>(gray.cols);
+        e.height = static_cast<uint32_t>(gray.rows);
+        e.step = e.width;
+        if (!seekTo(file_, e.offset)) return false;
+        for (int y = 0; y < gray.rows; ++y) {
+            if (fwrite(gray.ptr(y), 1, gray.cols, file_) != static_cast<size_t>(gray.cols)) return false;
+        }
+        end_ = alignUp(e.offset + uint64_t(e.step) * e.height, kPageSize);
+    }
+    entries_.push_back(e);
+    return true;
+}
+
+bool FrameStoreWriter::finish() {
+    if (!file_) return false;
+
+    FrameStoreHeader h{};
+    memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.version = kVersion;
+    h.frameCount = static_cast<uint32_t>(entries_.size());
+    h.pageSize = kPageSize;
+    h.dataOffset = alignUp(sizeof(FrameStoreHeader) + frameCount_ * sizeof(FrameStoreEntry), kPageSize);
+
+    bool ok = seekTo(file_, 0) &&
+              fwrite(&h, sizeof(h), 1, file_) == 1 &&
+              (entries_.empty() || fwrite(entries_.data(), sizeof(FrameStoreEntry), entries_.size(), file_) == entries_.size());
+    // 最后一帧按页补齐，映射时整页都在文件内
+    if (ok && end_ > h.dataOffset) {
+        ok = seekTo(file_, end_ - 1) && fputc(0, file_) != EOF;
+    }
+    ok = (fclose(file_) == 0) && ok;
+    file_ = nullptr;
+    return ok;
+}
+
+MappedFrameStore::~MappedFrameStore() {
+    close();
+}
+
+void MappedFrameStore::close() {
+    if (!data_) return;
+#ifdef _WIN32
+    UnmapViewOfFile(data_);
+    CloseHandle(mapping_);
+    mapping_ = nullptr;
+#else
+    munmap(const_cast<unsigned char*>(data_), length_);
+#endif
+    data_ = nullptr;
+    entries_ = nullptr;
+    length_ = 0;
+}
+
+bool MappedFrameStore::open(const string& path) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    mapping_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping_) return false;
+    data_ = static_cast<const unsigned char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    if (!data_) {
+        CloseHandle(mapping_);
+        mapping_ = nullptr;
+        return false;
+    }
+    length_ = static_cast<size_t>(size.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) return false;
+    madvise(p, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+    data_ = static_cast<const unsigned char*>(p);
+    length_ = static_cast<size_t>(st.st_size);
+#endif
+
+    // 校验头和索引，保证后面取帧不会越界
+    const FrameStoreHeader& h = header();
+    bool valid = length_ >= sizeof(FrameStoreHeader) && memcmp(h.magic, kMagic, sizeof(kMagic)) == 0 &&
+                 h.version == kVersion &&
+                 h.dataOffset >= sizeof(FrameStoreHeader) + uint64_t(h.frameCount) * sizeof(FrameStoreEntry) &&
+                 h.dataOffset <= length_;
+    if (valid) {
+        entries_ = reinterpret_cast<const FrameStoreEntry*>(data_ + sizeof(FrameStoreHeader));
+        for (uint32_t i = 0; i < h.frameCount && valid; ++i) {
+            const FrameStoreEntry& e = entries_[i];
+            valid = e.height == 0 ||
+                    (e.step >= e.width && e.offset >= h.dataOffset &&
+                     e.offset + uint64_t(e.step) * e.height <= length_);
+        }
+    }
+    if (!valid) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+Mat MappedFrameStore::frame(size_t index) const {
+    const FrameStoreEntry& e = entries_[index];
+    if (e.width == 0 || e.height == 0) return Mat();
+    return Mat(static_cast<int>(e.height), static_cast<int>(e.width), CV_8UC1,
+               const_cast<unsigned char*>(data_ + e.offset), e.step);
+}
+
+string MappedFrameStore::name(size_t index) const {
+    const FrameStoreEntry& e = entries_[index];
+    return string(e.name, strnlen(e.name, sizeof(e.name)));
+}
+
+FrameStoreSource::FrameStoreSource(const string& path) {
+    if (!store_.open(path)) {
+        cerr << "❌ Failed to open frame store: " << path << endl;
+    }
+}
+
+bool FrameStoreSource::load(size_t index, Frame& frame) const {
+    frame.index = index;
+    frame.path = store_.name(index);
+    frame.image = store_.frame(index);
+    return !frame.image.empty();
+}
+
+unique_ptr<FrameSource> openFrameSource(const string& path) {
+    if (fs::is_regular_file(path)) return make_unique<FrameStoreSource>(path);
+    return make_unique<ImageFolderSource>(path);
+}
+
+unique_ptr<FrameSource> openFrameSource(const string& path, const PipelineOptions& options) {
+    if (options.live.enabled) return make_unique<LiveSource>(path, options.live, options.reduceBy);
+    return openFrameSource(path);
+}
+
+}  // namespace haar
@@ -0,0 +1,144 @@
+#include "haar.h"
+#include "detector_registry.h"
+#include "detector_session.h"
+#include "work_stealing_pool.h"
+
+#include <cstdio>
+
+using namespace cv;
+using namespace std;
+
+namespace haar {
+
+shared_ptr<const Model> Model::load(const ModelConfig& config, string* error) {
+    string message;
+    const RegisteredDetector* detector = findDetector(config.detector);
+    if (!detector) {
+        message = "Unknown detector: " + config.detector;
+    } else {
+        const string assetRoot = config.assetRoot.empty() ? defaultAssetRoot() : config.assetRoot;
+        const Tunables tunables = config.tunables;  // 拷贝一份记录读过的名字，config 可能被别的线程同时用来加载
+        unique_ptr<DetectorModel> model = detector->load(assetRoot, tunables, message);
+        const vector<string> unknown = tunables.unread();
+        if (model && !unknown.empty()) {
+            message = "Unknown tunable for " + detector->name + ": " + joinNames(unknown);
+        } else if (model) {
+            return shared_ptr<const Model>(new Model(detector->name, std::move(model)));
+        }
+    }
+    if (error) *error = message;
+    return nullptr;
+}
+
+Model::Model(string detector, unique_ptr<DetectorModel> model)
+    : detector_(std::move(detector)), model_(std::move(model)) {}
+
+Model::~Model() = default;
+
+unique_ptr<Session> Model::createSession() const {
+    return unique_ptr<Session>(new Session(shared_from_this()));
+}
+
+string Model::describe() const {
+    return model_->describe();
+}
+
+struct Session::Impl {
+    unique_ptr<DetectorSession> session;
+    int reduceBy = 1;
+    vector<Frame> batch;  // processBatch 逐次复用
+
+    void prepare(const Mat& image, size_t index, Frame& frame) const;
+    vector<Detection> detect(const Frame& frame);
+};
+
+namespace {
+
+// 检测器只认 8 位图；别的深度、空图直接送进去会在某个 OpenCV 调用深处才出错
+void checkInput(const Mat& image) {
+    if (image.empty()) CV_Error(Error::StsBadArg, "haar::Session: empty image");
+    const int channels = image.channels();
+    if (image.depth() != CV_8U || (channels != 1 && channels != 3 && channels != 4)) {
+        CV_Error(Error::StsBadArg, "haar::Session: expected an 8-bit grayscale, BGR or BGRA image");
+    }
+}
+
+}  // namespace
+
+Session::Session(shared_ptr<const Model> model) : model_(std::move(model)), impl_(new Impl) {
+    reset();
+}
+
+Session::~Session() = default;
+
+void Session::reset() {
+    // 嵌入时不打印逐帧日志，也不写附带输出
+    impl_->session = model_->model_->createSession(SessionContext());
+    impl_->reduceBy = impl_->session->reduceBy();
+    frames_ = 0;
+}
+
+void Session::Impl::prepare(const Mat& image, size_t index, Frame& frame) const {
+    char name[32];
+    snprintf(name, sizeof(name), "frame_%06zu.jpg", index);
+    frame.index = index;
+    frame.path = name;
+    if (image.channels() == 3) {
+        cvtColor(image, frame.image, COLOR_BGR2GRAY);
+    } else if (image.channels() == 4) {
+        cvtColor(image, frame.image, COLOR_BGRA2GRAY);
+    } else {
+        frame.image = image;  // 灰度图直接引用调用方的数据，只在本次调用内使用
+    }
+    if (reduceBy > 1) {
+        const double f = 1.0 / reduceBy;
+        resize(frame.image, frame.reduced, Size(), f, f, INTER_AREA);
+    } else {
+        frame.reduced.release();
+    }
+}
+
+vector<Detection> Session::Impl::detect(const Frame& frame) {
+    const FrameResult result = session->process(frame);
+    vector<Detection> detections;
+    detections.reserve(result.boxes.size());
+    for (const BoxAnnotation& b : result.boxes) {
+        detections.push_back({b.box, b.score, b.label});
+    }
+    return detections;
+}
+
+vector<Detection> Session::process(const Mat& image) {
+    checkInput(image);
+    Frame frame;
+    impl_->prepare(image, frames_, frame);
+    vector<Detection> detections = impl_->detect(frame);
+    ++frames_;
+    return detections;
+}
+
+vector<vector<Detection>> Session::processBatch(const vector<Mat>& images) {
+    for (const Mat& image : images) checkInput(image);
+    vector<Frame>& batch = impl_->batch;
+    batch.resize(images.size());
+    const size_t first = frames_;
+    parallelFor(nullptr, images.size(), [&](size_t i) { impl_->prepare(images[i], first + i, batch[i]); });
+
+    vector<vector<Detection>> results;
+    results.reserve(images.size());
+    for (const Frame& frame : batch) {
+        results.push_back(impl_->detect(frame));
+        ++frames_;
+    }
+    // 灰度输入引用的是调用方的图像，不留到下一次
+    for (Frame& frame : batch) frame.image.release();
+    return results;
+}
+
+vector<string> detectorNames() {
+    vector<string> names;
+    for (const auto& d : registeredDetectors()) names.push_back(d.name);
+    return names;
+}
+
+}  // namespace haar
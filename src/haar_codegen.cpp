@@ -0,0 +1,232 @@
+// 把 Haar 级联 XML 转成编译期常量模型（供 compiled_cascade_kernel.h 实例化）
+// 用法：haar_codegen <输出头文件> <cascade.xml>...
+#include <opencv2/opencv.hpp>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <sstream>
+
+#include "compiled_cascade_model.h"
+
+namespace fs = std::filesystem;
+using namespace cv;
+using namespace std;
+using namespace haar;
+
+struct CascadeModel {
+    string name;      // C++ 标识符
+    string fileName;  // 运行时按文件名匹配
+    uint64_t hash = 0;
+    int width = 0, height = 0;
+    vector<HaarFeatureDef> features;
+    vector<HaarStageDef> stages;
+    vector<HaarStumpDef> stumps;
+    vector<int> featureSlots;  // 共享特征在集成评估器缓存中的槽位，只出现一次的为 -1
+};
+
+static string identifierFor(const string& stem) {
+    string id;
+    for (char c : stem) id += isalnum(static_cast<unsigned char>(c)) ? c : '_';
+    if (id.empty() || isdigit(static_cast<unsigned char>(id[0]))) id = "_" + id;
+    return id;
+}
+
+// 十六进制浮点字面量，保证与 OpenCV 读入的 float 逐位相同
+static string floatLiteral(float v) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%af", static_cast<double>(v));
+    return buf;
+}
+
+// 只接受新格式的 BOOST + HAAR 级联、深度 1 的弱分类器、无倾斜特征；其余交给 OpenCV 解释执行
+static bool parseCascade(const string& path, CascadeModel& model, string& why) {
+    FileStorage storage(path, FileStorage::READ);
+    if (!storage.isOpened()) { why = "cannot open"; return false; }
+
+    FileNode root = storage.getFirstTopLevelNode();
+    if ((string)root["stageType"] != "BOOST" || (string)root["featureType"] != "HAAR") {
+        why = "not a BOOST/HAAR cascade in the new format";
+        return false;
+    }
+    model.width = (int)root["width"];
+    model.height = (int)root["height"];
+
+    for (const FileNode& stageNode : root["stages"]) {
+        HaarStageDef stage;
+        stage.firstStump = static_cast<int>(model.stumps.size());
+        stage.numStumps = 0;
+        // CascadeClassifierImpl::Data::read 中的 THRESHOLD_EPS
+        stage.threshold = (float)stageNode["stageThreshold"] - 1e-5f;
+
+        for (const FileNode& weak : stageNode["weakClassifiers"]) {
+            vector<double> nodes, leaves;
+            weak["internalNodes"] >> nodes;
+            weak["leafValues"] >> leaves;
+            if (nodes.size() != 4 || leaves.size() != 2) {
+                why = "weak classifiers deeper than a stump";
+                return false;
+            }
+            HaarStumpDef stump;
+            stump.feature = static_cast<int>(nodes[2]);
+            stump.threshold = static_cast<float>(nodes[3]);
+            stump.left = static_cast<float>(leaves[0]);
+            stump.right = static_cast<float>(leaves[1]);
+            model.stumps.push_back(stump);
+            ++stage.numStumps;
+        }
+        model.stages.push_back(stage);
+    }
+
+    for (const FileNode& featureNode : root["features"]) {
+        if ((int)featureNode["tilted"] != 0) {
+            why = "tilted features";
+            return false;
+        }
+        HaarFeatureDef feature{};
+        for (const FileNode& rectNode : featureNode["rects"]) {
+            if (feature.numRects == 3) {
+                why = "more than 3 rects in a feature";
+                return false;
+            }
+            HaarRectDef& r = feature.rects[feature.numRects++];
+            FileNodeIterator it = rectNode.begin();
+            it >> r.x >> r.y >> r.width >> r.height >> r.weight;
+        }
+        model.features.push_back(feature);
+    }
+
+    for (const auto& s : model.stumps) {
+        if (s.feature < 0 || s.feature >= static_cast<int>(model.features.size())) {
+            why = "feature index out of range";
+            return false;
+        }
+    }
+    return !model.stages.empty();
+}
+
+// 矩形与权重逐位相同的特征在同一窗口上的值相同，不论属于哪个级联；出现不止一次的分配一个槽位
+static int assignSharedFeatures(vector<CascadeModel>& models) {
+    auto key = [](const HaarFeatureDef& f) {
+        ostringstream k;
+        for (int r = 0; r < f.numRects; ++r) {
+            const HaarRectDef& rc = f.rects[r];
+            k << rc.x << ',' << rc.y << ',' << rc.width << ',' << rc.height << ',' << floatLiteral(rc.weight) << ';';
+        }
+        return k.str();
+    };
+    map<string, int> uses;
+    for (const auto& m : models) {
+        for (const auto& f : m.features) ++uses[key(f)];
+    }
+    map<string, int> slots;
+    for (auto& m : models) {
+        m.featureSlots.clear();
+        for (const auto& f : m.features) {
+            const string k = key(f);
+            if (uses[k] < 2) {
+                m.featureSlots.push_back(-1);
+                continue;
+            }
+            auto it = slots.emplace(k, static_cast<int>(slots.size())).first;
+            m.featureSlots.push_back(it->second);
+        }
+    }
+    return static_cast<int>(slots.size());
+}
+
+static void emitModel(ostream& out, const CascadeModel& m) {
+    out << "struct " << m.name << " {\n"
+        << "    static constexpr const char* kFileName = \"" << m.fileName << "\";\n"
+        << "    static constexpr uint64_t kSourceHash = 0x" << hex << m.hash << dec << "ull;\n"
+        << "    static constexpr int kWidth = " << m.width << ";\n"
+        << "    static constexpr int kHeight = " << m.height << ";\n"
+        << "    static constexpr int kNumFeatures = " << m.features.size() << ";\n"
+        << "    static constexpr int kNumStages = " << m.stages.size() << ";\n"
+        << "    static constexpr int kNumStumps = " << m.stumps.size() << ";\n";
+
+    out << "    static constexpr HaarFeatureDef kFeatures[kNumFeatures] = {\n";
+    for (const auto& f : m.features) {
+        out << "        {" << f.numRects << ", {";
+        for (int r = 0; r < 3; ++r) {
+            const HaarRectDef& rc = f.rects[r];
+            out << (r ? ", " : "") << "{" << rc.x << ", " << rc.y << ", " << rc.width << ", " << rc.height
+                << ", " << floatLiteral(rc.weight) << "}";
+        }
+        out << "}},\n";
+    }
+    out << "    };\n";
+
+    out << "    static constexpr int kFeatureSlots[kNumFeatures] = {";
+    for (size_t f = 0; f < m.featureSlots.size(); ++f) out << (f ? ", " : "") << m.featureSlots[f];
+    out << "};\n";
+
+    out << "    static constexpr HaarStageDef kStages[kNumStages] = {\n";
+    for (const auto& s : m.stages) {
+        out << "        {" << s.firstStump << ", " << s.numStumps << ", " << floatLiteral(s.threshold) << "},\n";
+    }
+    out << "    };\n";
+
+    out << "    static constexpr HaarStumpDef kStumps[kNumStumps] = {\n";
+    for (const auto& s : m.stumps) {
+        out << "        {" << s.feature << ", " << floatLiteral(s.threshold) << ", " << floatLiteral(s.left)
+            << ", " << floatLiteral(s.right) << "},\n";
+    }
+    out << "    };\n};\n\n";
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        cerr << "usage: haar_codegen <output.h> <cascade.xml>..." << endl;
+        return 1;
+    }
+
+    vector<CascadeModel> models;
+    for (int i = 2; i < argc; ++i) {
+        string path = argv[i];
+        ifstream in(path, ios::binary);
+        string bytes((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+
+        CascadeModel model;
+        model.fileName = fs::path(path).filename().string();
+        model.name = identifierFor(fs::path(path).stem().string());
+        model.hash = fnv1a64(bytes.data(), bytes.size());
+
+        string why;
+        if (!parseCascade(path, model, why)) {
+            cerr << "⚠️ " << model.fileName << " not compiled (" << why << "), OpenCV will evaluate it" << endl;
+            continue;
+        }
+        models.push_back(model);
+    }
+
+    const int sharedFeatures = assignSharedFeatures(models);
+    size_t totalFeatures = 0;
+    for (const auto& m : models) totalFeatures += m.features.size();
+
+    ostringstream out;
+    out << "// 由 haar_codegen 根据级联 XML 生成，请勿手工修改\n"
+        << "#pragma once\n\n"
+        << "#include \"compiled_cascade_model.h\"\n\n"
+        << "namespace haar {\nnamespace generated {\n\n"
+        << "// 在多个级联中出现的特征数，即 kFeatureSlots 的槽位数\n"
+        << "constexpr int kNumSharedFeatures = " << sharedFeatures << ";\n\n";
+    for (const auto& m : models) emitModel(out, m);
+    out << "}  // namespace generated\n}  // namespace haar\n\n"
+        << "#define HAAR_FOR_EACH_COMPILED_CASCADE(X)";
+    for (const auto& m : models) out << " \\\n    X(" << m.name << ")";
+    out << "\n";
+
+    ofstream file(argv[1]);
+    file << out.str();
+    if (!file) {
+        cerr << "❌ cannot write " << argv[1] << endl;
+        return 1;
+    }
+    cout << "✅ compiled " << models.size() << " cascade(s) into " << argv[1] << " (" << totalFeatures
+         << " features, " << sharedFeatures << " shared)" << endl;
+    return 0;
+}
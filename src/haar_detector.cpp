@@ -0,0 +1,324 @@
+#include "haar_detector.h"
+#include "trace.h"
+#include "work_stealing_pool.h"
+
+#include <algorithm>
+
+using namespace cv;
+using namespace std;
+
+namespace haar {
+
+// 与 HaarEvaluator::computeChannels 相同的 32 位积分图（平方和按无符号回绕），
+// 末尾多留一行零给 SIMD 越界读
+static void computeIntegral(const Mat& img, vector<int>& sum, vector<int>& sqsum, IntegralLayer& layer) {
+    const int w = img.cols, h = img.rows, step = w + 1;
+    const size_t total = static_cast<size_t>(h + 2) * step;
+    sum.resize(total);
+    sqsum.resize(total);
+    fill(sum.begin(), sum.begin() + step, 0);
+    fill(sqsum.begin(), sqsum.begin() + step, 0);
+    fill(sum.end() - step, sum.end(), 0);
+    fill(sqsum.end() - step, sqsum.end(), 0);
+
+    for (int y = 0; y < h; ++y) {
+        const uchar* src = img.ptr<uchar>(y);
+        const int* sPrev = &sum[static_cast<size_t>(y) * step];
+        const int* qPrev = &sqsum[static_cast<size_t>(y) * step];
+        int* s = &sum[static_cast<size_t>(y + 1) * step];
+        int* q = &sqsum[static_cast<size_t>(y + 1) * step];
+        unsigned rowSum = 0, rowSq = 0;
+        s[0] = q[0] = 0;
+        for (int x = 0; x < w; ++x) {
+            const unsigned v = src[x];
+            rowSum += v;
+            rowSq += v * v;
+            s[x + 1] = static_cast<int>(static_cast<unsigned>(sPrev[x + 1]) + rowSum);
+            q[x + 1] = static_cast<int>(static_cast<unsigned>(qPrev[x + 1]) + rowSq);
+        }
+    }
+
+    layer.sum = sum.data();
+    layer.sqsum = sqsum.data();
+    layer.step = step;
+    layer.size = Size(w + 1, h + 1);
+}
+
+bool ScalePlan::plan(Size imgsz, Size originalWindowSize, double scaleFactor, Size minObjectSize,
+                     Size maxObjectSize) {
+    // 与 OpenCV 相同：scaleFactor <= 1 时尺度数列不会增长，下面的循环停不下来
+    CV_Assert(scaleFactor > 1);
+    imageSize_ = imgsz;
+    windowSize_ = originalWindowSize;
+    nstripes_ = 0;
+    allScales_.clear();
+    scales_.clear();
+
+    if (maxObjectSize.height == 0 || maxObjectSize.width == 0) maxObjectSize = imgsz;
+    if (imgsz.height < originalWindowSize.height || imgsz.width < originalWindowSize.width) return false;
+
+    for (double factor = 1; ; factor *= scaleFactor) {
+        Size windowSize(cvRound(originalWindowSize.width * factor), cvRound(originalWindowSize.height * factor));
+        if (windowSize.width > imgsz.width || windowSize.height > imgsz.height) break;
+        allScales_.push_back(static_cast<float>(factor));
+    }
+    for (float scale : allScales_) {
+        Size windowSize = objectSize(scale);
+        if (windowSize.width > maxObjectSize.width || windowSize.height > maxObjectSize.height) break;
+        if (windowSize.width < minObjectSize.width || windowSize.height < minObjectSize.height) continue;
+        scales_.push_back(scale);
+    }
+    if (scales_.empty()) return false;
+
+    nstripes_ = cvCeil(max(layerSize(scales_[0]).width + 1 - originalWindowSize.width, 0) / 32.);
+    if (nstripes_ == 0) scales_.clear();
+    return !scales_.empty();
+}
+
+int ScalePlan::yEnd(float scale) const {
+    const int step = yStep(scale);
+    const int workingHeight = max(layerSize(scale).height + 1 - windowSize_.height, 0);
+    const int stripeSize = max((workingHeight / step + nstripes_ - 1) / nstripes_, 1) * step;
+    return min(nstripes_ * stripeSize, workingHeight);
+}
+
+const IntegralLayer& IntegralLayerBuffer::build(const Mat& image, Size size) {
+    // 缩放倍数 >= 1，各层都不大于原图
+    if (resized_.rows < image.rows || resized_.cols < image.cols) {
+        resized_.create(max(resized_.rows, image.rows), max(resized_.cols, image.cols), CV_8UC1);
+    }
+    Mat layerImage = resized_(Rect(Point(0, 0), size));
+    resize(image, layerImage, size, 0, 0, INTER_LINEAR_EXACT);
+    computeIntegral(layerImage, sum_, sqsum_, layer_);
+    return layer_;
+}
+
+void clipObjects(Size imageSize, vector<Rect>& objects, vector<int>* weights) {
+    const Rect win0(Point(0, 0), imageSize);
+    size_t j = 0;
+    for (size_t i = 0; i < objects.size(); ++i) {
+        Rect r = win0 & objects[i];
+        if (r.area() <= 0) continue;
+        if (weights) (*weights)[j] = (*weights)[i];
+        objects[j++] = r;
+    }
+    objects.resize(j);
+    if (weights) weights->resize(j);
+}
+
+bool HaarDetector::load(const string& path, bool compiled) {
+    path_ = path;
+    compiled_ = compiled ? loadCompiledCascade(path) : nullptr;
+    if (compiled_) return true;
+    return fallback_.load(path);
+}
+
+bool HaarDetector::loadFrom(const HaarDetector& loaded) {
+    path_ = loaded.path_;
+    compiled_ = loaded.compiled_;
+    if (compiled_) return true;
+    return !loaded.fallback_.empty() && fallback_.load(path_);
+}
+
+void HaarDetector::detectMultiScale(const Mat& image, vector<Rect>& objects, double scaleFactor,
+                                    int minNeighbors, int flags, Size minSize, Size maxSize) {
+    HAAR_TRACE_SCOPE("haar.detectMultiScale");
+    HAAR_TRACE_ARG("image_width", image.cols);
+    HAAR_TRACE_ARG("image_height", image.rows);
+    if (!compiled_) {
+        fallback_.detectMultiScale(image, objects, scaleFactor, minNeighbors, flags, minSize, maxSize);
+        HAAR_TRACE_ARG("opencv_fallback", 1);
+        HAAR_TRACE_ARG("detections", objects.size());
+        return;
+    }
+
+    Mat gray = image;
+    if (image.channels() > 1) cvtColor(image, gray, COLOR_BGR2GRAY);
+    detectCompiled(gray, objects, scaleFactor, minNeighbors, minSize, maxSize);
+    clipObjects(image.size(), objects);
+    HAAR_TRACE_ARG("detections", objects.size());
+}
+
+void HaarDetector::detectCompiled(const Mat& image, vector<Rect>& objects, double scaleFactor,
+                                  int minNeighbors, Size minObjectSize, Size maxObjectSize) {
+    objects.clear();
+    const bool any = plan_.plan(image.size(), compiled_->windowSize(), scaleFactor, minObjectSize, maxObjectSize);
+    HAAR_TRACE_ARG("scales", plan_.scales().size());
+    if (!any) return;
+
+    for (float scale : plan_.scales()) {
+        const IntegralLayer& layer = layer_.build(image, plan_.layerSize(scale));
+        hits_.clear();
+        compiled_->scanLayer(layer, ScalePlan::yStep(scale), 0, plan_.yEnd(scale), hits_);
+
+        const Size winSize = plan_.objectSize(scale);
+        for (const Point& p : hits_) {
+            objects.emplace_back(cvRound(p.x * scale), cvRound(p.y * scale), winSize.width, winSize.height);
+        }
+    }
+
+    HAAR_TRACE_ARG("raw_hits", objects.size());
+    grouper_.group(objects, minNeighbors, 0.2);
+}
+
+// 分块扫描的条带高度（窗口起点的行数）：窗口高的两倍、至少 32 行，取偶数与步长 2 对齐。
+// 各层里目标都是窗口大小，条带连同它往下读的一个窗口高就盖住了最大的目标；高度只取决于级联，
+// 划分固定，拼接顺序才与线程数无关
+static int tileRows(Size windowSize) {
+    return (max(2 * windowSize.height, 32) + 1) & ~1;
+}
+
+void HaarDetector::detectMultiScaleTiled(const Mat& image, vector<Rect>& objects, WorkStealingPool* pool,
+                                         double scaleFactor, int minNeighbors, Size minSize, Size maxSize) {
+    if (!compiled_) {
+        detectMultiScale(image, objects, scaleFactor, minNeighbors, 0, minSize, maxSize);
+        return;
+    }
+
+    HAAR_TRACE_SCOPE("haar.detectMultiScaleTiled");
+    HAAR_TRACE_ARG("image_width", image.cols);
+    HAAR_TRACE_ARG("image_height", image.rows);
+    Mat gray = image;
+    if (image.channels() > 1) cvtColor(image, gray, COLOR_BGR2GRAY);
+
+    objects.clear();
+    const bool any = plan_.plan(gray.size(), compiled_->windowSize(), scaleFactor, minSize, maxSize);
+    const vector<float>& scales = plan_.scales();
+    HAAR_TRACE_ARG("scales", scales.size());
+    if (!any) return;
+
+    // 各层互不依赖，先并行把积分图都建好，扫描时各条带只读共享的积分图
+    if (layers_.size() < scales.size()) layers_.resize(scales.size());
+    built_.resize(scales.size());
+    parallelFor(pool, scales.size(), [&](size_t l) {
+        built_[l] = &layers_[l].build(gray, plan_.layerSize(scales[l]));
+    });
+
+    // 每层窗口起点的行切成条带；条带往下读到的行与下一条带重叠，相当于块与块重叠一个窗口高
+    const int rows = tileRows(compiled_->windowSize());
+    tiles_.clear();
+    for (size_t l = 0; l < scales.size(); ++l) {
+        const int yEnd = plan_.yEnd(scales[l]);
+        for (int y = 0; y < yEnd; y += rows) tiles_.push_back({static_cast<int>(l), y, min(y + rows, yEnd)});
+    }
+    if (tileHits_.size() < tiles_.size()) tileHits_.resize(tiles_.size());
+    HAAR_TRACE_ARG("tiles", tiles_.size());
+
+    parallelFor(pool, tiles_.size(), [&](size_t t) {
+        const ScanTile& tile = tiles_[t];
+        tileHits_[t].clear();
+        compiled_->scanLayer(*built_[tile.layer], ScalePlan::yStep(scales[tile.layer]), tile.yBegin, tile.yEnd,
+                             tileHits_[t]);
+    });
+
+    // 按 (层, 条带) 顺序拼接即串行扫描的命中顺序，分组结果随之相同
+    for (size_t t = 0; t < tiles_.size(); ++t) {
+        const float scale = scales[tiles_[t].layer];
+        const Size winSize = plan_.objectSize(scale);
+        for (const Point& p : tileHits_[t]) {
+            objects.emplace_back(cvRound(p.x * scale), cvRound(p.y * scale), winSize.width, winSize.height);
+        }
+    }
+
+    HAAR_TRACE_ARG("raw_hits", objects.size());
+    grouper_.group(objects, minNeighbors, 0.2);
+    clipObjects(image.size(), objects);
+    HAAR_TRACE_ARG("detections", objects.size());
+}
+
+void RectangleGrouper::group(vector<Rect>& rects, int groupThreshold, double eps, vector<int>* weights) {
+    if (weights) weights->clear();
+    if (groupThreshold <= 0 || rects.empty()) {
+        if (weights) weights->assign(rects.size(), 1);
+        return;
+    }
+
+    // cv::partition：O(N^2) 合并相似矩形所在的树，再按首次出现的顺序给根编号
+    const int n = static_cast<int>(rects.size());
+    auto similar = [eps](const Rect& r1, const Rect& r2) {
+        double delta = eps * (min(r1.width, r2.width) + min(r1.height, r2.height)) * 0.5;
+        return abs(r1.x - r2.x) <= delta && abs(r1.y - r2.y) <= delta &&
+               abs(r1.x + r1.width - r2.x - r2.width) <= delta &&
+               abs(r1.y + r1.height - r2.y - r2.height) <= delta;
+    };
+    nodes_.assign(static_cast<size_t>(n) * 2, 0);
+    int* parent = nodes_.data();
+    int* rank = nodes_.data() + n;
+    for (int i = 0; i < n; ++i) parent[i] = -1;
+
+    for (int i = 0; i < n; ++i) {
+        int root = i;
+        while (parent[root] >= 0) root = parent[root];
+        for (int j = 0; j < n; ++j) {
+            if (i == j || !similar(rects[i], rects[j])) continue;
+            int root2 = j;
+            while (parent[root2] >= 0) root2 = parent[root2];
+            if (root2 != root) {
+                if (rank[root] > rank[root2]) {
+                    parent[root2] = root;
+                } else {
+                    parent[root] = root2;
+                    rank[root2] += rank[root] == rank[root2];
+                    root = root2;
+                }
+                for (int k = j, p; (p = parent[k]) >= 0; k = p) parent[k] = root;
+                for (int k = i, p; (p = parent[k]) >= 0; k = p) parent[k] = root;
+            }
+        }
+    }
+
+    labels_.resize(n);
+    int nclasses = 0;
+    for (int i = 0; i < n; ++i) {
+        int root = i;
+        while (parent[root] >= 0) root = parent[root];
+        if (rank[root] >= 0) rank[root] = ~nclasses++;
+        labels_[i] = ~rank[root];
+    }
+
+    // 每类取平均框（float 倒数相乘后 saturate_cast，与 OpenCV 相同）
+    groupSums_.assign(nclasses, Rect());
+    groupWeights_.assign(nclasses, 0);
+    for (int i = 0; i < n; ++i) {
+        Rect& r = groupSums_[labels_[i]];
+        r.x += rects[i].x;
+        r.y += rects[i].y;
+        r.width += rects[i].width;
+        r.height += rects[i].height;
+        groupWeights_[labels_[i]]++;
+    }
+    for (int c = 0; c < nclasses; ++c) {
+        const Rect r = groupSums_[c];
+        const float s = 1.f / groupWeights_[c];
+        groupSums_[c] = Rect(saturate_cast<int>(r.x * s), saturate_cast<int>(r.y * s),
+                             saturate_cast<int>(r.width * s), saturate_cast<int>(r.height * s));
+    }
+
+    // 票数不超过阈值的类丢弃；被票数更多的大框包含的小框丢弃
+    rects.clear();
+    for (int i = 0; i < nclasses; ++i) {
+        const Rect r1 = groupSums_[i];
+        const int n1 = groupWeights_[i];
+        if (n1 <= groupThreshold) continue;
+        int j = 0;
+        for (; j < nclasses; ++j) {
+            const int n2 = groupWeights_[j];
+            if (j == i || n2 <= groupThreshold) continue;
+            const Rect r2 = groupSums_[j];
+            const int dx = saturate_cast<int>(r2.width * eps);
+            const int dy = saturate_cast<int>(r2.height * eps);
+            if (r1.x >= r2.x - dx && r1.y >= r2.y - dy &&
+                r1.x + r1.width <= r2.x + r2.width + dx &&
+                r1.y + r1.height <= r2.y + r2.height + dy &&
+                (n2 > max(3, n1) || n1 < 3)) {
+                break;
+            }
+        }
+        if (j == nclasses) {
+            rects.push_back(r1);
+            if (weights) weights->push_back(n1);
+        }
+    }
+}
+
+}  // namespace haar
@@ -0,0 +1,172 @@
+#include "haar_ensemble.h"
+#include "trace.h"
+
+#include <algorithm>
+
+using namespace cv;
+using namespace std;
+
+namespace haar {
+
+HaarEnsemble::HaarEnsemble(HaarEnsembleOptions options) : options_(options) {}
+
+bool HaarEnsemble::load(const vector<string>& paths, bool compiled) {
+    members_.clear();
+    compiled_ = compiled ? loadCompiledEnsemble() : nullptr;
+    bool ok = true;
+    for (const string& path : paths) {
+        if (any_of(members_.begin(), members_.end(), [&](const Member& m) { return m.path == path; })) continue;
+        Member m;
+        m.path = path;
+        m.index = compiled_ ? compiledEnsembleIndex(path) : -1;
+        if (m.index < 0) {
+            m.fallback = make_unique<CascadeClassifier>();
+            if (!m.fallback->load(path)) {
+                ok = false;
+                continue;
+            }
+        }
+        members_.push_back(std::move(m));
+    }
+    if (compiled_) {
+        yEnds_.assign(compiled_->size(), 0);
+        hits_.resize(compiled_->size());
+    }
+    return ok && !members_.empty();
+}
+
+bool HaarEnsemble::loadFrom(const HaarEnsemble& loaded) {
+    members_.clear();
+    compiled_ = loaded.compiled_;
+    bool ok = true;
+    for (const Member& source : loaded.members_) {
+        Member m;
+        m.path = source.path;
+        m.index = source.index;
+        if (m.index < 0) {
+            m.fallback = make_unique<CascadeClassifier>();
+            if (!m.fallback->load(m.path)) {
+                ok = false;
+                continue;
+            }
+        }
+        members_.push_back(std::move(m));
+    }
+    if (compiled_) {
+        yEnds_.assign(compiled_->size(), 0);
+        hits_.resize(compiled_->size());
+    }
+    return ok && !members_.empty();
+}
+
+size_t HaarEnsemble::compiledCount() const {
+    return count_if(members_.begin(), members_.end(), [](const Member& m) { return m.index >= 0; });
+}
+
+void HaarEnsemble::detectMultiScale(const Mat& image, vector<Rect>& objects, double scaleFactor,
+                                    int minNeighbors, Size minSize, Size maxSize) {
+    HAAR_TRACE_SCOPE("haar.ensemble");
+    HAAR_TRACE_ARG("image_width", image.cols);
+    HAAR_TRACE_ARG("image_height", image.rows);
+    HAAR_TRACE_ARG("cascades", members_.size());
+
+    Mat gray = image;
+    if (image.channels() > 1) cvtColor(image, gray, COLOR_BGR2GRAY);
+    if (compiledCount() > 0) detectCompiled(gray, scaleFactor, minNeighbors, minSize, maxSize);
+
+    for (Member& m : members_) {
+        if (m.index >= 0) continue;
+        m.fallback->detectMultiScale(image, m.objects, m.weights, scaleFactor, minNeighbors, 0, minSize, maxSize);
+    }
+
+    fuse(objects);
+    HAAR_TRACE_ARG("detections", objects.size());
+}
+
+// 各级联的尺度都是 scaleFactor 幂次数列的片段，取并集后逐层只缩放、积分一次，
+// 本层在自己尺度表里的级联一起扫描
+void HaarEnsemble::detectCompiled(const Mat& gray, double scaleFactor, int minNeighbors, Size minSize,
+                                  Size maxSize) {
+    layerScales_.clear();
+    const ScalePlan* sizing = nullptr;
+    for (Member& m : members_) {
+        if (m.index < 0) continue;
+        m.objects.clear();
+        m.next = 0;
+        const Size window = compiled_->windowSize(m.index);
+        if (!m.plan.plan(gray.size(), window, scaleFactor, minSize, maxSize)) continue;
+        layerScales_.insert(layerScales_.end(), m.plan.scales().begin(), m.plan.scales().end());
+        sizing = &m.plan;
+    }
+    sort(layerScales_.begin(), layerScales_.end());
+    layerScales_.erase(unique(layerScales_.begin(), layerScales_.end()), layerScales_.end());
+    HAAR_TRACE_ARG("layers", layerScales_.size());
+    HAAR_TRACE_ARG("shared_features", compiled_->sharedFeatures());
+
+    for (float scale : layerScales_) {
+        fill(yEnds_.begin(), yEnds_.end(), 0);
+        for (auto& h : hits_) h.clear();
+        for (Member& m : members_) {
+            if (m.index < 0 || m.next >= m.plan.scales().size() || m.plan.scales()[m.next] != scale) continue;
+            yEnds_[m.index] = m.plan.yEnd(scale);
+            ++m.next;
+        }
+
+        // 层尺寸只取决于图像尺寸和尺度，用哪个级联的 plan 算都一样
+        const IntegralLayer& layer = layer_.build(gray, sizing->layerSize(scale));
+        compiled_->scanLayer(layer, ScalePlan::yStep(scale), yEnds_.data(), hits_.data());
+
+        for (Member& m : members_) {
+            if (m.index < 0 || m.next == 0 || m.plan.scales()[m.next - 1] != scale) continue;
+            const Size winSize = m.plan.objectSize(scale);
+            for (const Point& p : hits_[m.index]) {
+                m.objects.emplace_back(cvRound(p.x * scale), cvRound(p.y * scale), winSize.width, winSize.height);
+            }
+        }
+    }
+
+    for (Member& m : members_) {
+        if (m.index < 0) continue;
+        grouper_.group(m.objects, minNeighbors, 0.2, &m.weights);
+        clipObjects(gray.size(), m.objects, &m.weights);
+    }
+}
+
+// 按合并的原始框数从多到少贪心聚类：与当前框 IoU 够大的后续框并入同一目标，
+// 目标由几个不同的级联检出就算几票
+void HaarEnsemble::fuse(vector<Rect>& objects) {
+    candidates_.clear();
+    for (size_t i = 0; i < members_.size(); ++i) {
+        const Member& m = members_[i];
+        for (size_t k = 0; k < m.objects.size(); ++k) candidates_.push_back({m.objects[k], m.weights[k], i});
+    }
+    stable_sort(candidates_.begin(), candidates_.end(), [](const Candidate& a, const Candidate& b) {
+        return a.weight != b.weight ? a.weight > b.weight : a.box.area() > b.box.area();
+    });
+
+    auto iou = [](const Rect& a, const Rect& b) {
+        const double inter = (a & b).area();
+        return inter / (a.area() + b.area() - inter);
+    };
+    const int minVotes = options_.fusion == EnsembleFusion::Vote ? max(options_.minVotes, 1) : 1;
+
+    objects.clear();
+    suppressed_.assign(candidates_.size(), 0);
+    for (size_t i = 0; i < candidates_.size(); ++i) {
+        if (suppressed_[i]) continue;
+        voters_.assign(members_.size(), 0);
+        voters_[candidates_[i].member] = 1;
+        int votes = 1;
+        for (size_t j = i + 1; j < candidates_.size(); ++j) {
+            if (suppressed_[j] || iou(candidates_[i].box, candidates_[j].box) < options_.nmsIou) continue;
+            suppressed_[j] = 1;
+            if (!voters_[candidates_[j].member]) {
+                voters_[candidates_[j].member] = 1;
+                ++votes;
+            }
+        }
+        if (votes >= minVotes) objects.push_back(candidates_[i].box);
+    }
+}
+
+}  // namespace haar
@@ -0,0 +1,34 @@
+#include "haar_model.h"
+#include "detector_registry.h"
+
+using namespace cv;
+using namespace std;
+
+namespace haar {
+
+bool readHaarScanSettings(const Tunables& tune, HaarScanSettings& settings, string& error) {
+    settings.scaleFactor = tune.get("scale_factor", settings.scaleFactor);
+    return tune.getSize("min", settings.minObject, settings.minObject, error) &&
+           tune.getInt("min_neighbors", settings.minNeighbors, settings.minNeighbors, error) &&
+           checkMin("min_width", settings.minObject.width, 0, error) &&
+           checkMin("min_height", settings.minObject.height, 0, error) &&
+           checkAbove("scale_factor", settings.scaleFactor, 1, error) &&
+           checkMin("min_neighbors", settings.minNeighbors, 0, error);
+}
+
+bool loadCascade(const string& assetRoot, const string& relative, HaarDetector& cascade, string& error) {
+    const string path = assetPath(assetRoot, relative);
+    if (cascade.load(path)) return true;
+    error = "Failed to load Haar classifier: " + path;
+    return false;
+}
+
+bool loadCascades(const string& assetRoot, const vector<string>& relative, HaarEnsemble& cascades, string& error) {
+    vector<string> paths;
+    for (const auto& p : relative) paths.push_back(assetPath(assetRoot, p));
+    if (cascades.load(paths)) return true;
+    error = "Failed to load Haar classifiers: " + joinNames(paths);
+    return false;
+}
+
+}  // namespace haar
@@ -0,0 +1,434 @@
+// 参数扫描：按网格生成多组可调参数（见 tunables.h），每个检测器 × 每组参数作为一个任务在工作窃取池上
+// 并行跑过自带序列，统计逐帧检测耗时与检出，列出速度 / 检出的帕累托前沿，结果写成 JSON
+//
+// 用法：haar_sweep [--detector 名称]... [--grid 名称=取值,取值...]... [--truth 真值文件] [--iou 0.5]
+//                  [--jobs N] [--out 文件] [--assets 目录] [--set 名称=取值]... [--config 文件] [--sink 输出...]
+//                  [序列目录...]
+//
+// 模型、自带序列与默认的结果 / 输出目录都在 --assets 目录下（默认 defaultAssetRoot()，即 HAAR_ASSETS 或 ".."）。
+// 真值文件每行一个目标框：序列名 帧文件名 x y width height（空白或逗号分隔，# 之后为注释）。
+// 出现在真值文件里的序列逐帧评分，其中没有列出的帧视为没有目标；有真值时检出指标为 F1，否则为有检出的帧的比例。
+// 参数名没有任何检测器认时报错；某个检测器不认的 --grid 维度对它只是默认值，只在这些维度上不同的组合只跑一次。
+// 速度指标为检测回调耗时的 p95。各任务并行时互相争抢 CPU，耗时偏高但组与组之间可比；要绝对延迟用 --jobs 1
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+
+#include "batch_runner.h"
+#include "detector_registry.h"
+#include "frame_pipeline.h"
+#include "latency_stats.h"
+#include "result_sinks.h"
+#include "tunables.h"
+#include "work_stealing_pool.h"
+
+namespace fs = std::filesystem;
+using namespace cv;
+using namespace std;
+using namespace haar;
+
+// 路径相对 assetRoot
+const string RESULT_FILE   = "output/haar_sweep.json";
+const string OUTPUT_FOLDER = "output/sweep";
+const vector<string> DEFAULT_SEQUENCES = {"img/video_01", "img/video_02", "img/video_03", "img/video_04"};
+// 预测框、未确认的候选和木箱估计不算检出
+const set<string> IGNORED_LABELS = {"prediction", "candidate", "box_estimate"};
+
+// 序列名 → 帧文件名 → 目标框
+using GroundTruth = map<string, map<string, vector<Rect>>>;
+
+static bool loadGroundTruth(const string& path, GroundTruth& truth) {
+    ifstream in(path);
+    if (!in.is_open()) {
+        cerr << "❌ Cannot open ground truth: " << path << endl;
+        return false;
+    }
+    string line;
+    for (int number = 1; getline(in, line); ++number) {
+        line = line.substr(0, line.find('#'));
+        replace(line.begin(), line.end(), ',', ' ');
+        istringstream fields(line);
+        string sequence, file;
+        Rect box;
+        if (!(fields >> sequence)) continue;
+        if (!(fields >> file >> box.x >> box.y >> box.width >> box.height) || box.empty()) {
+            cerr << "❌ Invalid ground truth line " << path << ":" << number << endl;
+            return false;
+        }
+        truth[sequence][file].push_back(box);
+    }
+    return true;
+}
+
+static double iou(const Rect& a, const Rect& b) {
+    const double inter = (a & b).area();
+    return inter > 0 ? inter / (a.area() + b.area() - inter) : 0.0;
+}
+
+// 一个检测器 × 一组参数跑过全部序列的结果
+struct SweepResult {
+    string detector;
+    Tunables config;
+    size_t frames = 0;
+    size_t detected = 0;        // 有检出的帧
+    size_t scoredFrames = 0;    // 有真值的帧
+    size_t truePositives = 0, falsePositives = 0, falseNegatives = 0;
+    double fps = 0.0;
+    LatencySummary latency;     // 检测回调耗时
+    bool pareto = false;
+
+    bool scored() const { return scoredFrames > 0; }
+    double detectionRate() const { return frames ? double(detected) / frames : 0.0; }
+    double precision() const {
+        return truePositives + falsePositives ? double(truePositives) / (truePositives + falsePositives) : 0.0;
+    }
+    double recall() const {
+        return truePositives + falseNegatives ? double(truePositives) / (truePositives + falseNegatives) : 0.0;
+    }
+    double f1() const {
+        const size_t d = 2 * truePositives + falsePositives + falseNegatives;
+        return d ? 2.0 * truePositives / d : 0.0;
+    }
+    double accuracy() const { return scored() ? f1() : detectionRate(); }
+};
+
+// 接在每条序列的输出上（PipelineOptions::observer）：记录检测回调耗时，按真值给每帧评分。
+// 同一任务的各条序列依次跑，换序列时 begin()；consume() 由编码线程并发调用
+class ScoringSink : public FrameSink {
+public:
+    explicit ScoringSink(double minIou) : minIou_(minIou) {}
+
+    // truth 为本序列各帧的真值，为空时只统计检出帧
+    void begin(const map<string, vector<Rect>>* truth) { truth_ = truth; }
+
+    void consume(const Frame& frame, const FrameResult& result) override {
+        latency_.record(STAGE_DETECT, result.detectMs);
+
+        vector<Rect> boxes;
+        for (const BoxAnnotation& a : result.boxes) {
+            if (!a.label || !IGNORED_LABELS.count(a.label)) boxes.push_back(a.box);
+        }
+
+        size_t tp = 0, fp = 0, fn = 0;
+        if (truth_) {
+            static const vector<Rect> none;
+            auto it = truth_->find(fs::path(frame.path).filename().string());
+            const vector<Rect>& targets = it == truth_->end() ? none : it->second;
+            // 每个真值框贪心地配上 IoU 最大、还没用过的检出框
+            vector<char> used(boxes.size(), 0);
+            for (const Rect& t : targets) {
+                int best = -1;
+                double bestIou = minIou_;
+                for (size_t b = 0; b < boxes.size(); ++b) {
+                    const double v = used[b] ? 0.0 : iou(t, boxes[b]);
+                    if (v >= bestIou) {
+                        bestIou = v;
+                        best = static_cast<int>(b);
+                    }
+                }
+                if (best >= 0) {
+                    used[best] = 1;
+                    ++tp;
+                } else {
+                    ++fn;
+                }
+            }
+            fp = boxes.size() - tp;
+        }
+
+        lock_guard<mutex> lock(mutex_);
+        ++result_.frames;
+        if (!boxes.empty()) ++result_.detected;
+        if (truth_) {
+            ++result_.scoredFrames;
+            result_.truePositives += tp;
+            result_.falsePositives += fp;
+            result_.falseNegatives += fn;
+        }
+    }
+
+    // 填好计数和耗时分位数的结果（detector / config / fps 由调用方填写）
+    SweepResult result() const {
+        SweepResult r = result_;
+        r.latency = latency_.summary(STAGE_DETECT);
+        return r;
+    }
+
+private:
+    double minIou_;
+    const map<string, vector<Rect>>* truth_ = nullptr;
+    LatencyRecorder latency_;
+    mutex mutex_;
+    SweepResult result_;
+};
+
+// --grid 的各维依次展开成笛卡尔积，每组都以 base 为底
+static vector<Tunables> expandGrid(const Tunables& base, const vector<pair<string, vector<double>>>& grid) {
+    vector<Tunables> configs = {base};
+    for (const auto& [name, values] : grid) {
+        vector<Tunables> next;
+        for (const Tunables& c : configs) {
+            for (double v : values) {
+                next.push_back(c);
+                next.back().set(name, v);
+            }
+        }
+        configs = std::move(next);
+    }
+    return configs;
+}
+
+static bool parseGrid(const string& spec, pair<string, vector<double>>& axis) {
+    const size_t eq = spec.find('=');
+    if (eq == string::npos || eq == 0) return false;
+    axis.first = spec.substr(0, eq);
+    axis.second.clear();
+    stringstream list(spec.substr(eq + 1));
+    string value;
+    while (getline(list, value, ',')) {
+        Tunables probe;
+        if (!probe.parse(axis.first + "=" + value)) return false;
+        axis.second.push_back(probe.get(axis.first, 0.0));
+    }
+    return !axis.second.empty();
+}
+
+// 耗时不高于、检出不低于、且至少一项严格更好的结果存在时，该结果不在前沿上
+static void markParetoFront(vector<SweepResult>& results) {
+    for (SweepResult& r : results) {
+        r.pareto = r.frames > 0;
+        for (const SweepResult& o : results) {
+            if (&o == &r || o.frames == 0) continue;
+            const bool noWorse = o.latency.p95 <= r.latency.p95 && o.accuracy() >= r.accuracy();
+            const bool better = o.latency.p95 < r.latency.p95 || o.accuracy() > r.accuracy();
+            if (noWorse && better) {
+                r.pareto = false;
+                break;
+            }
+        }
+    }
+}
+
+static void writeResults(const string& path, const vector<SweepResult>& results) {
+    fs::create_directories(fs::path(path).parent_path());
+    FileStorage out(path, FileStorage::WRITE | FileStorage::FORMAT_JSON);
+    out << "results" << "[";
+    for (const SweepResult& r : results) {
+        out << "{";
+        out << "detector" << r.detector;
+        out << "config" << r.config.describe();
+        out << "params" << "{";
+        for (const auto& [name, value] : r.config.values()) out << name << value;
+        out << "}";
+        out << "frames" << static_cast<int>(r.frames);
+        out << "detected" << static_cast<int>(r.detected);
+        out << "detection_rate" << r.detectionRate();
+        if (r.scored()) {
+            out << "precision" << r.precision() << "recall" << r.recall() << "f1" << r.f1();
+        }
+        out << "fps" << r.fps;
+        out << "p50_ms" << r.latency.p50 << "p95_ms" << r.latency.p95 << "p99_ms" << r.latency.p99
+            << "max_ms" << r.latency.max;
+        out << "pareto" << (r.pareto ? 1 : 0);
+        out << "}";
+    }
+    out << "]";
+}
+
+static void printResult(const SweepResult& r) {
+    cout << "   " << (r.pareto ? "✅ " : "   ") << left << setw(34) << r.detector << right << " p50 " << setw(7)
+         << r.latency.p50 << " | p95 " << setw(7) << r.latency.p95 << " ms | " << setw(7) << r.fps << " FPS | ";
+    if (r.scored()) {
+        cout << "F1 " << r.f1() << " (P " << r.precision() << ", R " << r.recall() << ")";
+    } else {
+        cout << "Detected " << 100.0 * r.detectionRate() << "%";
+    }
+    cout << " | " << r.config.describe() << endl;
+}
+
+int main(int argc, char** argv) {
+    string assetRoot = defaultAssetRoot();
+    string resultPath;  // 为空时为 assetRoot 下的 RESULT_FILE
+    string truthPath;
+    double minIou = 0.5;
+    int jobs = 0;
+    vector<string> onlyDetectors;
+    vector<pair<string, vector<double>>> grid;
+    vector<string> sequences;
+    PipelineOptions base;  // --set / --config 为各组共同的底，--sink 等输出参数同各检测器
+    base.output.images = false;  // 默认不出图，几十组参数的输出只会拖慢扫描
+
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        auto value = [&]() -> string {
+            if (i + 1 >= argc) {
+                cerr << "❌ Missing value for " << arg << endl;
+                exit(2);
+            }
+            return argv[++i];
+        };
+        if (arg == "--out") resultPath = value();
+        else if (arg == "--assets") assetRoot = value();
+        else if (arg == "--truth") truthPath = value();
+        else if (arg == "--iou") minIou = stod(value());
+        else if (arg == "--jobs") jobs = stoi(value());
+        else if (arg == "--detector") onlyDetectors.push_back(value());
+        else if (arg == "--grid") {
+            pair<string, vector<double>> axis;
+            const string spec = value();
+            if (!parseGrid(spec, axis)) {
+                cerr << "❌ Invalid --grid: " << spec << " (expected name=value,value...)" << endl;
+                return 2;
+            }
+            grid.push_back(axis);
+        }
+        else if (parseOutputFlag(argc, argv, i, base)) continue;
+        else sequences.push_back(arg);
+    }
+    if (resultPath.empty()) resultPath = assetPath(assetRoot, RESULT_FILE);
+    const string outputFolder = assetPath(assetRoot, OUTPUT_FOLDER);
+    if (sequences.empty()) {
+        for (const auto& s : DEFAULT_SEQUENCES) {
+            const string path = assetPath(assetRoot, s);
+            if (fs::is_directory(path)) sequences.push_back(path);
+        }
+    }
+    if (sequences.empty()) {
+        cerr << "❌ No sequences to sweep" << endl;
+        return 2;
+    }
+
+    GroundTruth truth;
+    if (!truthPath.empty() && !loadGroundTruth(truthPath, truth)) return 2;
+
+    vector<const RegisteredDetector*> detectors;
+    for (const auto& det : registeredDetectors()) {
+        if (onlyDetectors.empty() ||
+            find(onlyDetectors.begin(), onlyDetectors.end(), det.name) != onlyDetectors.end()) {
+            detectors.push_back(&det);
+        }
+    }
+    if (detectors.empty()) {
+        cerr << "❌ No detector matched" << endl;
+        return 2;
+    }
+
+    const vector<Tunables> configs = expandGrid(base.tunables, grid);
+
+    // 每个检测器先按第一组参数试加载一次（各组的名字相同），得到它认哪些名字：
+    // 没有任何检测器认的名字直接报错；某检测器不认的维度对它只是默认值，只差在这些维度上的组合只跑第一组
+    vector<vector<bool>> runs(detectors.size(), vector<bool>(configs.size(), false));
+    set<string> consumed;
+    size_t runCount = 0;
+    for (size_t d = 0; d < detectors.size(); ++d) {
+        const Tunables probe = configs[0];
+        string error;
+        if (!detectors[d]->load(assetRoot, probe, error)) {
+            cerr << "❌ " << detectors[d]->name << " [" << probe.describe() << "]: " << error << endl;
+            continue;
+        }
+        const vector<string> ignored = probe.unread();
+        for (const auto& [name, value] : probe.values()) {
+            if (find(ignored.begin(), ignored.end(), name) == ignored.end()) consumed.insert(name);
+        }
+        set<string> seen;
+        for (size_t c = 0; c < configs.size(); ++c) {
+            Tunables effective;
+            for (const auto& [name, value] : configs[c].values()) {
+                if (find(ignored.begin(), ignored.end(), name) == ignored.end()) effective.set(name, value);
+            }
+            if (seen.insert(effective.describe()).second) {
+                runs[d][c] = true;
+                ++runCount;
+            }
+        }
+    }
+    vector<string> unknown;
+    for (const auto& [name, value] : configs[0].values()) {
+        if (!consumed.count(name)) unknown.push_back(name);
+    }
+    if (runCount > 0 && !unknown.empty()) {
+        cerr << "❌ Unknown tunable: " << joinNames(unknown) << endl;
+        return 2;
+    }
+
+    vector<SweepResult> results(detectors.size() * configs.size());
+    cout << "🔍 " << detectors.size() << " detectors × " << configs.size() << " configs over "
+         << sequences.size() << " sequences (" << runCount << " distinct runs)" << endl;
+
+    // 每个检测器 × 每组参数一个顶层任务，任务内各序列依次跑，解码 / 编码作为细粒度任务交给同一个池
+    auto start = chrono::steady_clock::now();
+    {
+        WorkStealingPool pool(jobs);
+        for (size_t d = 0; d < detectors.size(); ++d) {
+            for (size_t c = 0; c < configs.size(); ++c) {
+                if (!runs[d][c]) continue;
+                pool.submitRoot([&, d, c] {
+                    const RegisteredDetector& det = *detectors[d];
+                    // 每组参数一个模型：级联尺寸、阈值等在加载时读入。各检测器的任务并发加载，
+                    // 各自拷贝一份参数（加载时要记录读过的名字）
+                    const Tunables config = configs[c];
+                    string error;
+                    unique_ptr<DetectorModel> model = det.load(assetRoot, config, error);
+                    if (!model) {
+                        cerr << "❌ " << det.name << " [" << config.describe() << "]: " << error << endl;
+                        return;
+                    }
+                    ScoringSink scorer(minIou);
+                    PipelineOptions options = base;
+                    options.pool = &pool;
+                    options.tunables = configs[c];
+                    options.observer = &scorer;
+
+                    auto t0 = chrono::steady_clock::now();
+                    for (const auto& seq : sequences) {
+                        const string name = sequenceName(seq);
+                        auto it = truth.find(name);
+                        scorer.begin(it == truth.end() ? nullptr : &it->second);
+                        runSequence(*model, det, seq, outputFolder + "/" + det.name + "/" + to_string(c) + "/" + name,
+                                    options, false);
+                    }
+                    const double seconds = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+                    SweepResult r = scorer.result();
+                    r.detector = det.name;
+                    r.config = config.readOnly();  // 报告里只列本检测器认的参数
+                    r.fps = seconds > 0 ? r.frames / seconds : 0.0;
+                    results[d * configs.size() + c] = r;
+                });
+            }
+        }
+        pool.wait();
+    }
+    const double wallSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    // 模型加载失败的组合没有结果
+    results.erase(remove_if(results.begin(), results.end(), [](const SweepResult& r) { return r.detector.empty(); }),
+                  results.end());
+
+    markParetoFront(results);
+    vector<SweepResult> sorted = results;
+    stable_sort(sorted.begin(), sorted.end(),
+                [](const SweepResult& a, const SweepResult& b) { return a.latency.p95 < b.latency.p95; });
+
+    cout << fixed << setprecision(2);
+    cout << "📊 Sweep | " << results.size() << " runs | Wall: " << wallSeconds << " s"
+         << (truth.empty() ? " | no ground truth, accuracy = detection rate" : "") << endl;
+    for (const SweepResult& r : sorted) printResult(r);
+
+    cout << "✅ Pareto front (p95 latency vs " << (truth.empty() ? "detection rate" : "F1") << "):" << endl;
+    for (const SweepResult& r : sorted) {
+        if (r.pareto) printResult(r);
+    }
+
+    writeResults(resultPath, results);
+    cout << "✅ Results written to " << resultPath << endl;
+    return 0;
+}
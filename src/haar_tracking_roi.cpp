@@ -1,99 +1,194 @@
 #include <opencv2/opencv.hpp>
-#include <filesystem>
 #include <iostream>
 #include <iomanip>
 
-namespace fs = std::filesystem;
+#include "detector_registry.h"
+#include "haar_model.h"
+#include "latency_stats.h"
+#include "motion_gate.h"
+#include "reduced_detection.h"
+#include "trace.h"
+#include "track_manager.h"
+#include "work_stealing_pool.h"
+
 using namespace cv;
 using namespace std;
 
-// === 配置参数 ===
-const string CASCADE_PATH = "../haarcascade_drone4.xml";
-const string IMAGE_FOLDER  = "../img/video_01";
-const string OUTPUT_FOLDER = "../output_haar_roi120*120";
-const int SEARCH_RADIUS = 60;  // 帧间局部搜索半径
-
-vector<string> getSortedImagePaths(const string& folder_path) {
-    vector<string> files;
-    for (const auto& entry : fs::directory_iterator(folder_path)) {
-        files.push_back(entry.path().string());
-    }
-    sort(files.begin(), files.end());
-    return files;
-}
-
-int main() {
-    CascadeClassifier droneCascade;
-    if (!droneCascade.load(CASCADE_PATH)) {
-        cerr << "❌ Failed to load Haar classifier: " << CASCADE_PATH << endl;
-        return -1;
+namespace haar {
+
+namespace {
+
+// === 配置参数 ===（路径相对 assetRoot）
+const string CASCADE_PATH = "haarcascade_drone4.xml";
+const string IMAGE_FOLDER  = "img/video_01";
+const string OUTPUT_FOLDER = "output_haar_roi120*120";
+const Size MIN_OBJECT(40, 40);
+const size_t MAX_TRACKS = 4;        // 同时跟踪的目标数上限
+const int FULL_SCAN_INTERVAL = 30;  // 新目标平时只在帧间变化区域里找，每隔几帧整帧扫描一次兜底
+const double SCALE_FACTOR = 1.1;
+const int MIN_NEIGHBORS = 3;
+const bool TILED_FULL_SCAN = true;  // 整帧扫描分块并行（见 HaarDetector::detectMultiScaleTiled），结果不变
+// 运行时可覆盖（见 tunables.h）：min_width / min_height、full_scan_interval、scale_factor、min_neighbors、
+// tiled_full_scan（0 / 1）
+
+struct HaarRoiSettings {
+    HaarScanSettings scan;
+    int fullScanInterval;
+    bool tiledFullScan;
+};
+
+// 一路视频：检测器的缓冲区和跟踪状态只属于这个会话
+class HaarRoiSession : public DetectorSession {
+public:
+    HaarRoiSession(const SessionContext& context, const HaarDetector& cascade, const HaarRoiSettings& settings)
+        : context_(context), cascade_(cascade), settings_(settings), tracker_(trackOptions()),
+          motion_(motionOptions(settings)) {
+        // 每个检测窗口一个检测器（编译好的级联是共享的），各窗口可以并行检测；窗口数变多时再补。
+        // 找新目标的扫描窗口在目标足够大时缩小检测、原分辨率精修，缩小图由解码线程生成
+        addDetector();
     }
 
-    fs::create_directories(OUTPUT_FOLDER);
-    vector<string> image_paths = getSortedImagePaths(IMAGE_FOLDER);
+    int reduceBy() const override { return detectors_[0].reduceBy(); }
 
-    Point lastCenter(-1, -1);
-
-    for (size_t i = 0; i < image_paths.size(); ++i) {
-        string img_path = image_paths[i];
-        Mat frame = imread(img_path, IMREAD_GRAYSCALE);
-        if (frame.empty()) continue;
+    FrameResult process(const Frame& f) override {
+        const Mat& frame = f.image;
+        size_t i = f.index;
+        const Size minObject = settings_.scan.minObject;
 
         int64 start = getTickCount();
 
-        vector<Rect> detections;
-        Mat display;
-        cvtColor(frame, display, COLOR_GRAY2BGR);
-
-        bool localSearchUsed = false;
-        if (lastCenter.x >= 0 && lastCenter.y >= 0) {
-            int x = max(lastCenter.x - SEARCH_RADIUS, 0);
-            int y = max(lastCenter.y - SEARCH_RADIUS, 0);
-            int w = min(2 * SEARCH_RADIUS, frame.cols - x);
-            int h = min(2 * SEARCH_RADIUS, frame.rows - y);
-            Rect roi(x, y, w, h);
-            Mat roiImg = frame(roi);
-
-            droneCascade.detectMultiScale(roiImg, detections, 1.1, 3, 0, Size(40, 40));
-
-            // 坐标修正到全图坐标系
-            for (auto& d : detections) {
-                d.x += roi.x;
-                d.y += roi.y;
+        FrameResult result;
+
+        StageTimer stages(context_.latency, STAGE_PREPROCESS);
+        const vector<Rect>& moving = motion_.update(frame);
+
+        stages.next(STAGE_ROI);
+        const vector<DetectionWindow>& windows = tracker_.plan(frame.size(), moving, motion_.fullScan());
+        while (detectors_.size() < windows.size()) addDetector();
+        HAAR_TRACE_ARG("windows", windows.size());
+        HAAR_TRACE_ARG("full_frame", tracker_.fullScan() ? 1 : 0);
+
+        stages.next(STAGE_DETECT);
+        parallelFor(context_.pool, windows.size(), [&](size_t w) {
+            const SearchWindow& window = windows[w].window;
+            vector<Rect>& found = tracker_.detections(w);
+            if (windows[w].track < 0) {
+                // 整帧扫描只有这一个窗口，跟丢后的重新捕获改在池上分块并行
+                const bool tiled = settings_.tiledFullScan && tracker_.fullScan();
+                detectors_[w].detectMultiScale(frame, f.reduced, window.roi, found, settings_.scan.scaleFactor,
+                                               settings_.scan.minNeighbors, minObject, Size(), tiled, context_.pool);
+                return;
             }
-
-            localSearchUsed = true;
-        }
-
-        if (detections.empty()) {
-            droneCascade.detectMultiScale(frame, detections, 1.1, 3, 0, Size(40, 40));
-            localSearchUsed = false;
+            Size minSize = minObject, maxSize;
+            window.narrow(minSize, maxSize);
+            detectors_[w].detector().detectMultiScale(frame(window.roi), found, settings_.scan.scaleFactor,
+                                                      settings_.scan.minNeighbors, 0, minSize, maxSize);
+            // 坐标修正到全图坐标系
+            for (auto& d : found) d += window.roi.tl();
+        });
+        if (!tracker_.fullScan()) {
+            for (const auto& w : windows) result.searchRegion |= w.window.roi;
         }
 
+        stages.next(STAGE_TRACK);
+        tracker_.update();
         int64 end = getTickCount();
         double elapsed_ms = 1000.0 * (end - start) / getTickFrequency();
 
-        if (!detections.empty()) {
-            for (const auto& box : detections) {
-                rectangle(display, box, Scalar(0, 255, 0), 2);
+        // 只有确认的航迹算检出，与 haar_sweep 评分（忽略 "candidate"）一致
+        size_t found = 0;
+        for (const Track& t : tracker_.tracks()) {
+            if (!t.updated) continue;
+            if (t.confirmed) {
+                result.boxes.push_back({t.box, Scalar(0, 255, 0), 2, 0, "drone"});
+                ++found;
+            } else {
+                result.boxes.push_back({t.box, Scalar(0, 255, 255), 1, 0, "candidate"});
             }
-            lastCenter = Point(
-                detections[0].x + detections[0].width / 2,
-                detections[0].y + detections[0].height / 2
-            );
-            cout << "✅ Frame " << i << " | Detections: " << detections.size()
-                 << (localSearchUsed ? " | ROI ✅" : " | Full Img")
-                 << " | Time: " << fixed << setprecision(2) << elapsed_ms << " ms" << endl;
-        } else {
-            lastCenter = Point(-1, -1);
+        }
+
+        if (found > 0) {
+            ++detected_;
+            if (context_.logFrames) {
+                cout << "✅ Frame " << i << " | Targets: " << found << "/" << tracker_.tracks().size()
+                     << (tracker_.fullScan() ? " | Full Img" : " | ROI ✅")
+                     << " | Time: " << fixed << setprecision(2) << elapsed_ms << " ms" << endl;
+            }
+        } else if (context_.logFrames) {
             cout << "❌ Frame " << i << " | No detection | Time: " << fixed << setprecision(2) << elapsed_ms << " ms" << endl;
         }
 
-        string out_path = OUTPUT_FOLDER + "/" + fs::path(img_path).stem().string() + "_haar_roi.jpg";
-        imwrite(out_path, display);
-        imshow("Haar Drone Detection with ROI", display);
-        waitKey(1);
+        return result;
     }
 
-    return 0;
+private:
+    static TrackManagerOptions trackOptions() {
+        TrackManagerOptions options;
+        options.maxTracks = MAX_TRACKS;
+        return options;
+    }
+    static MotionGateOptions motionOptions(const HaarRoiSettings& settings) {
+        MotionGateOptions options;
+        options.fullScanInterval = settings.fullScanInterval;
+        return options;
+    }
+
+    void addDetector() {
+        detectors_.emplace_back();
+        detectors_.back().load(cascade_);
+        detectors_.back().configure(settings_.scan.minObject);
+    }
+
+    SessionContext context_;
+    const HaarDetector& cascade_;  // 模型里的级联，只用来补检测器
+    HaarRoiSettings settings_;
+    vector<ReducedResolutionDetector> detectors_;
+
+    // 每个目标一条轨迹，搜索窗口按各自的预测定大小，未命中时逐帧放大；
+    // 新目标只在帧差给出的变化区域里找，整帧扫描按固定节奏兜底
+    TrackManager tracker_;
+    MotionGate motion_;
+};
+
+class HaarRoiModel : public DetectorModel {
+public:
+    explicit HaarRoiModel(const HaarRoiSettings& settings) : settings_(settings) {}
+
+    bool load(const string& assetRoot, string& error) {
+        return loadCascade(assetRoot, CASCADE_PATH, cascade_, error);
+    }
+
+    unique_ptr<DetectorSession> createSession(const SessionContext& context) const override {
+        return make_unique<HaarRoiSession>(context, cascade_, settings_);
+    }
+
+private:
+    HaarDetector cascade_;
+    HaarRoiSettings settings_;
+};
+
+unique_ptr<DetectorModel> loadHaarRoiModel(const string& assetRoot, const Tunables& tune, string& error) {
+    HaarRoiSettings settings;
+    settings.scan = {MIN_OBJECT, SCALE_FACTOR, MIN_NEIGHBORS};
+    int tiledFullScan = 0;
+    if (!readHaarScanSettings(tune, settings.scan, error) ||
+        !tune.getInt("full_scan_interval", FULL_SCAN_INTERVAL, settings.fullScanInterval, error) ||
+        !tune.getInt("tiled_full_scan", TILED_FULL_SCAN, tiledFullScan, error) ||
+        !checkMin("full_scan_interval", settings.fullScanInterval, 1, error)) {
+        return nullptr;
+    }
+    settings.tiledFullScan = tiledFullScan != 0;
+
+    auto model = make_unique<HaarRoiModel>(settings);
+    if (!model->load(assetRoot, error)) return nullptr;
+    return model;
 }
+
+}  // namespace
+
+RegisteredDetector haarRoiDetector() {
+    return {"detect_haar_roi", loadHaarRoiModel, "_haar_roi.jpg", IMAGE_FOLDER, OUTPUT_FOLDER,
+            "Haar Drone Detection with ROI"};
+}
+
+}  // namespace haar
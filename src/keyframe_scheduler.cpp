@@ -0,0 +1,95 @@
+#include "keyframe_scheduler.h"
+#include "trace.h"
+
+#include <algorithm>
+
+using namespace cv;
+using namespace std;
+
+namespace haar {
+
+KeyframeScheduler::KeyframeScheduler(KeyframeSchedulerOptions options)
+    : options_(std::move(options)), planner_(options_.window) {
+    options_.keyframeInterval = max(options_.keyframeInterval, 1);
+    options_.maxKeyframeInterval = max(options_.maxKeyframeInterval, options_.keyframeInterval);
+    interval_ = options_.keyframeInterval;
+}
+
+FramePath KeyframeScheduler::path(Size frameSize) {
+    window_ = planner_.begin(frameSize);
+
+    // 没有模板、Haar 上一帧没找到时必须检测；外观漂移引起的刷新在超预算时推迟到定期关键帧
+    const bool overBudget = options_.budgetMs > 0 && averageMs_ > options_.budgetMs;
+    const bool due = !hasTemplate_ || !planner_.tracking() || planner_.misses() > 0 || (refresh_ && !overBudget) ||
+                     ++sinceKeyframe_ >= interval_;
+    HAAR_TRACE_ARG("keyframe", due ? 1 : 0);
+    HAAR_TRACE_ARG("keyframe_interval", interval_);
+    if (!due) return FramePath::Track;
+
+    sinceKeyframe_ = 0;
+    ++keyframes_;
+    return FramePath::Detect;
+}
+
+bool KeyframeScheduler::track(const Mat& frame, Rect& box, double& score) {
+    HAAR_TRACE_SCOPE("keyframe.track");
+    const Rect predicted = planner_.predicted();
+    const Size templSize = matcher_->size();
+    const Point center(predicted.x + predicted.width / 2, predicted.y + predicted.height / 2);
+    const int m = options_.searchMargin;
+    trackWindow_ = Rect(center.x - templSize.width / 2 - m, center.y - templSize.height / 2 - m,
+                        templSize.width + 2 * m, templSize.height + 2 * m) &
+                   Rect(0, 0, frame.cols, frame.rows);
+
+    const TemplateMatch match = matcher_->matchExact(frame, trackWindow_);
+    score = match.score;
+    HAAR_TRACE_ARG("score", score);
+    if (score < options_.trackScore) {
+        // 跟丢：本帧改跑 Haar，不算一次未命中
+        sinceKeyframe_ = 0;
+        ++keyframes_;
+        ++escalations_;
+        return false;
+    }
+
+    box = Rect(match.location, templSize);
+    planner_.update(box);
+    refresh_ = score < options_.refreshScore;
+    return true;
+}
+
+void KeyframeScheduler::detected(const Mat& frame, const Rect& box) {
+    planner_.update(box);
+    refresh_ = false;
+
+    // 模板从本帧的检测框重切，框贴边时只取帧内部分。切不出时旧模板属于之前的目标，不能拿来在新位置跟踪
+    const Rect cut = box & Rect(0, 0, frame.cols, frame.rows);
+    hasTemplate_ = min(cut.width, cut.height) >= options_.minTemplateSide;
+    if (!hasTemplate_) return;
+    if (matcher_) {
+        matcher_->reset(frame(cut));
+    } else {
+        TemplateMatcherOptions matcherOptions;
+        matcherOptions.maxLevels = 0;  // 只在小窗口里搜，用不到金字塔
+        matcher_ = make_unique<TemplateMatcher>(frame(cut), matcherOptions);
+    }
+}
+
+void KeyframeScheduler::missed() {
+    planner_.miss();
+}
+
+void KeyframeScheduler::finish(double elapsedMs) {
+    averageMs_ = frames_++ == 0 ? elapsedMs
+                                : averageMs_ + options_.costSmoothing * (elapsedMs - averageMs_);
+    if (options_.budgetMs <= 0) return;
+
+    // 超预算时拉长关键帧间隔；低于预算 80% 时逐步回到设定值
+    if (averageMs_ > options_.budgetMs) {
+        interval_ = min(interval_ + 1, options_.maxKeyframeInterval);
+    } else if (averageMs_ < 0.8 * options_.budgetMs) {
+        interval_ = max(interval_ - 1, options_.keyframeInterval);
+    }
+}
+
+}  // namespace haar
@@ -0,0 +1,48 @@
+#include "latency_stats.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace haar {
+
+const char* stageName(Stage stage) {
+    static const char* const names[STAGE_COUNT] = {
+        "decode", "preprocess", "roi", "detect", "track", "encode", "capture_to_result"};
+    return stage >= 0 && stage < STAGE_COUNT ? names[stage] : "unknown";
+}
+
+void LatencyRecorder::record(Stage stage, double ms) {
+    lock_guard<mutex> lock(mutex_);
+    samples_[stage].push_back(ms);
+}
+
+LatencySummary LatencyRecorder::summary(Stage stage) const {
+    vector<double> v;
+    {
+        lock_guard<mutex> lock(mutex_);
+        v = samples_[stage];
+    }
+    LatencySummary s;
+    s.count = v.size();
+    if (v.empty()) return s;
+
+    sort(v.begin(), v.end());
+    auto rank = [&](double p) {
+        size_t k = static_cast<size_t>(ceil(p * v.size()));
+        return v[min(max<size_t>(k, 1), v.size()) - 1];
+    };
+    s.p50 = rank(0.50);
+    s.p95 = rank(0.95);
+    s.p99 = rank(0.99);
+    s.max = v.back();
+    return s;
+}
+
+void LatencyRecorder::clear() {
+    lock_guard<mutex> lock(mutex_);
+    for (auto& v : samples_) v.clear();
+}
+
+}  // namespace haar
@@ -0,0 +1,100 @@
+#include "live_source.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+
+namespace fs = std::filesystem;
+using namespace cv;
+using namespace std;
+
+namespace haar {
+
+namespace {
+
+// 全是数字且放得进 int 的 URI 当设备号；超出范围的长数字串按路径打开，不让 stoi 抛 out_of_range
+bool parseDeviceIndex(const string& uri, int& index) {
+    if (uri.empty() || !all_of(uri.begin(), uri.end(), [](char c) { return c >= '0' && c <= '9'; })) return false;
+    errno = 0;
+    const long value = strtol(uri.c_str(), nullptr, 10);
+    if (errno == ERANGE || value > INT_MAX) return false;
+    index = static_cast<int>(value);
+    return true;
+}
+
+}  // namespace
+
+LiveSource::LiveSource(const string& uri, LiveSourceOptions options, int reduceBy)
+    : uri_(uri), options_(options), reduceBy_(reduceBy), frames_(options.bufferFrames) {
+    int device = 0;
+    opened_ = parseDeviceIndex(uri_, device) ? capture_.open(device) : capture_.open(uri_);
+    if (!opened_) {
+        cerr << "❌ Failed to open live input: " << uri_ << endl;
+        frames_.close();
+        return;
+    }
+
+    // 普通文件读起来比实时快得多，按帧率定速才像相机；设备和管道的 read() 本身就按输入节奏阻塞
+    if (fs::is_regular_file(uri_)) {
+        fps_ = options_.replayFps > 0 ? options_.replayFps : capture_.get(CAP_PROP_FPS);
+        if (!(fps_ > 0)) fps_ = 25.0;
+    }
+    thread_ = thread([this] { captureLoop(); });
+}
+
+LiveSource::~LiveSource() {
+    stopping_ = true;
+    frames_.close();
+    if (thread_.joinable()) thread_.join();
+}
+
+bool LiveSource::next(Frame& frame) const {
+    return frames_.pop(frame);
+}
+
+void LiveSource::captureLoop() {
+    trace::setThreadName("capture");
+    const auto start = chrono::steady_clock::now();
+    const chrono::duration<double> period(fps_ > 0 ? 1.0 / fps_ : 0.0);
+    Mat raw;
+    char name[32];
+
+    for (size_t n = 0; !stopping_ && (options_.maxFrames == 0 || n < options_.maxFrames); ++n) {
+        if (fps_ > 0) {
+            this_thread::sleep_until(start + chrono::duration_cast<chrono::steady_clock::duration>(period * n));
+        }
+        const auto t0 = chrono::steady_clock::now();
+        if (!capture_.read(raw) || raw.empty()) break;
+
+        Frame frame;
+        frame.captured = chrono::steady_clock::now();
+        frame.index = n;
+        snprintf(name, sizeof(name), "frame_%06zu.jpg", n);
+        frame.path = name;
+        // read() 可能复用 raw 的缓冲，交出去的帧须有自己的一份
+        if (raw.channels() == 3) {
+            cvtColor(raw, frame.image, COLOR_BGR2GRAY);
+        } else if (raw.channels() == 4) {
+            cvtColor(raw, frame.image, COLOR_BGRA2GRAY);
+        } else {
+            frame.image = raw.clone();
+        }
+        if (reduceBy_ > 1) {
+            const double f = 1.0 / reduceBy_;
+            resize(frame.image, frame.reduced, Size(), f, f, INTER_AREA);
+        }
+        frame.decodeMs = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+
+        ++captured_;
+        if (!frames_.push(std::move(frame))) break;
+    }
+    frames_.close();
+}
+
+}  // namespace haar
@@ -0,0 +1,138 @@
+#include "motion_gate.h"
+#include "trace.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define HAAR_MOTION_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define HAAR_MOTION_NEON
+#endif
+
+using namespace cv;
+using namespace std;
+
+namespace haar {
+
+namespace {
+
+BlobExtractorOptions blobOptions(const MotionGateOptions& options) {
+    BlobExtractorOptions b;
+    b.threshold = options.threshold;
+    b.closeSize = options.closeSize;
+    b.maxBlobs = options.maxCandidates;
+    return b;
+}
+
+}  // namespace
+
+MotionGate::MotionGate(MotionGateOptions options)
+    : options_(options), blobs_(blobOptions(options)) {
+    options_.learningShift = min(max(options_.learningShift, 0), 8);
+    options_.fullScanInterval = max(options_.fullScanInterval, 1);
+}
+
+// diff = |frame - background|，同时 background += round((frame - background) / 2^shift)。
+// 与 BlobExtractor 一样只用基线指令集：x86-64 用 SSE2、AArch64 用 NEON，不需要运行时分派
+void MotionGate::differenceRow(const uchar* frame, uchar* background, uchar* diff, int width) const {
+    const int s = options_.learningShift;
+    const int round = s > 0 ? 1 << (s - 1) : 0;
+    int x = 0;
+#if defined(HAAR_MOTION_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bias = _mm_set1_epi16(static_cast<short>(round));
+    const __m128i shift = _mm_cvtsi32_si128(s);
+    for (; x + 16 <= width; x += 16) {
+        const __m128i f = _mm_loadu_si128(reinterpret_cast<const __m128i*>(frame + x));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(background + x));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(diff + x), _mm_or_si128(_mm_subs_epu8(f, b), _mm_subs_epu8(b, f)));
+
+        __m128i lo = _mm_unpacklo_epi8(b, zero), hi = _mm_unpackhi_epi8(b, zero);
+        const __m128i dlo = _mm_sub_epi16(_mm_unpacklo_epi8(f, zero), lo);
+        const __m128i dhi = _mm_sub_epi16(_mm_unpackhi_epi8(f, zero), hi);
+        lo = _mm_add_epi16(lo, _mm_sra_epi16(_mm_add_epi16(dlo, bias), shift));
+        hi = _mm_add_epi16(hi, _mm_sra_epi16(_mm_add_epi16(dhi, bias), shift));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(background + x), _mm_packus_epi16(lo, hi));
+    }
+#elif defined(HAAR_MOTION_NEON)
+    const int16x8_t shift = vdupq_n_s16(static_cast<int16_t>(-s));  // 负数为带舍入的右移
+    for (; x + 16 <= width; x += 16) {
+        const uint8x16_t f = vld1q_u8(frame + x);
+        const uint8x16_t b = vld1q_u8(background + x);
+        vst1q_u8(diff + x, vabdq_u8(f, b));
+
+        int16x8_t lo = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(b)));
+        int16x8_t hi = vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(b)));
+        const int16x8_t dlo = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(f))), lo);
+        const int16x8_t dhi = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(f))), hi);
+        lo = vaddq_s16(lo, vrshlq_s16(dlo, shift));
+        hi = vaddq_s16(hi, vrshlq_s16(dhi, shift));
+        vst1q_u8(background + x, vcombine_u8(vqmovun_s16(lo), vqmovun_s16(hi)));
+    }
+#endif
+    for (; x < width; ++x) {
+        const int d = frame[x] - background[x];
+        diff[x] = static_cast<uchar>(d < 0 ? -d : d);
+        background[x] = static_cast<uchar>(background[x] + ((d + round) >> s));
+    }
+}
+
+const vector<Rect>& MotionGate::update(const Mat& gray) {
+    HAAR_TRACE_SCOPE("motion.update");
+    CV_Assert(gray.type() == CV_8UC1);
+    candidates_.clear();
+
+    // 第一帧（或尺寸变了）只建立背景
+    if (background_.size() != gray.size()) {
+        gray.copyTo(background_);
+        fullScan_ = true;
+        sinceFullScan_ = 0;
+        return candidates_;
+    }
+
+    diff_.create(gray.size(), CV_8UC1);
+    for (int y = 0; y < gray.rows; ++y) {
+        differenceRow(gray.ptr<uchar>(y), background_.ptr<uchar>(y), diff_.ptr<uchar>(y), gray.cols);
+    }
+
+    fullScan_ = ++sinceFullScan_ >= options_.fullScanInterval;
+    if (!fullScan_) {
+        const Rect frame(0, 0, gray.cols, gray.rows);
+        const int p = options_.padding;
+        for (const Rect& blob : blobs_.extract(diff_)) {
+            Rect c(blob.x - p, blob.y - p, blob.width + 2 * p, blob.height + 2 * p);
+            const int w = max(c.width, options_.minCandidate.width), h = max(c.height, options_.minCandidate.height);
+            c = Rect(c.x - (w - c.width) / 2, c.y - (h - c.height) / 2, w, h) & frame;
+            if (!c.empty()) candidates_.push_back(c);
+        }
+
+        // 外扩后相交的候选框合并，免得重叠部分查两遍
+        for (size_t i = 0; i < candidates_.size(); ++i) {
+            for (size_t j = i + 1; j < candidates_.size();) {
+                if ((candidates_[i] & candidates_[j]).empty()) {
+                    ++j;
+                    continue;
+                }
+                candidates_[i] |= candidates_[j];
+                candidates_.erase(candidates_.begin() + j);
+                j = i + 1;
+            }
+        }
+
+        double area = 0;
+        for (const Rect& c : candidates_) area += c.area();
+        HAAR_TRACE_ARG("changed_fraction", area / frame.area());
+        fullScan_ = area > options_.maxChangedFraction * frame.area();
+    }
+    if (fullScan_) {
+        sinceFullScan_ = 0;
+        candidates_.clear();
+    }
+    HAAR_TRACE_ARG("candidates", candidates_.size());
+    HAAR_TRACE_ARG("full_scan", fullScan_ ? 1 : 0);
+    return candidates_;
+}
+
+}  // namespace haar
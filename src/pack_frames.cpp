@@ -0,0 +1,47 @@
+// 把图片目录转成打包帧文件（见 frame_store.h），之后各检测器可以直接把 .frames 文件当序列用
+// 用法：pack_frames <图片目录> <输出.frames>
+#include <opencv2/opencv.hpp>
+#include <filesystem>
+#include <iostream>
+
+#include "frame_pipeline.h"
+#include "frame_store.h"
+
+namespace fs = std::filesystem;
+using namespace cv;
+using namespace std;
+using namespace haar;
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        cerr << "usage: pack_frames <image folder> <output.frames>" << endl;
+        return 1;
+    }
+
+    vector<string> paths = getSortedImagePaths(argv[1]);
+    FrameStoreWriter writer(argv[2], paths.size());
+    if (!writer.isOpen()) {
+        cerr << "❌ Cannot create " << argv[2] << endl;
+        return 1;
+    }
+
+    size_t failed = 0;
+    for (const auto& path : paths) {
+        Mat gray = imread(path, IMREAD_GRAYSCALE);
+        if (gray.empty()) {
+            cerr << "⚠️ Cannot read " << path << ", stored as an empty frame" << endl;
+            ++failed;
+        }
+        if (!writer.add(fs::path(path).filename().string(), gray)) {
+            cerr << "❌ Write failed at " << path << endl;
+            return 1;
+        }
+    }
+    if (!writer.finish()) {
+        cerr << "❌ Cannot finalize " << argv[2] << endl;
+        return 1;
+    }
+
+    cout << "✅ Packed " << paths.size() << " frames (" << failed << " unreadable) into " << argv[2] << endl;
+    return 0;
+}
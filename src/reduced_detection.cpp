@@ -0,0 +1,117 @@
+#include "reduced_detection.h"
+#include "trace.h"
+
+#include <algorithm>
+
+using namespace cv;
+using namespace std;
+
+namespace haar {
+
+namespace {
+
+double iou(const Rect& a, const Rect& b) {
+    const double inter = (a & b).area();
+    return inter / (a.area() + b.area() - inter);
+}
+
+Size scaleSize(Size s, double k) {
+    return Size(cvRound(s.width * k), cvRound(s.height * k));
+}
+
+}  // namespace
+
+int chooseReduction(Size windowSize, Size minTarget, const vector<int>& factors) {
+    const int w = max(minTarget.width, windowSize.width), h = max(minTarget.height, windowSize.height);
+    int best = 1;
+    for (int f : factors) {
+        if (f > best && f * windowSize.width <= w && f * windowSize.height <= h) best = f;
+    }
+    return best;
+}
+
+ReducedResolutionDetector::ReducedResolutionDetector(ReducedDetectionOptions options) : options_(std::move(options)) {}
+
+int ReducedResolutionDetector::configure(Size minTarget) {
+    reduceBy_ = detector_.empty() ? 1 : chooseReduction(detector_.windowSize(), minTarget, options_.factors);
+    return reduceBy_;
+}
+
+void ReducedResolutionDetector::detectMultiScale(const Mat& image, const Mat& reduced, Rect roi, vector<Rect>& objects,
+                                                 double scaleFactor, int minNeighbors, Size minSize, Size maxSize,
+                                                 bool tiled, WorkStealingPool* pool) {
+    roi &= Rect(0, 0, image.cols, image.rows);
+    if (reduceBy_ <= 1) {
+        if (tiled) {
+            detector_.detectMultiScaleTiled(image(roi), objects, pool, scaleFactor, minNeighbors, minSize, maxSize);
+        } else {
+            detector_.detectMultiScale(image(roi), objects, scaleFactor, minNeighbors, 0, minSize, maxSize);
+        }
+        for (auto& d : objects) d += roi.tl();
+        return;
+    }
+
+    HAAR_TRACE_SCOPE("reduced.detect");
+    HAAR_TRACE_ARG("reduce_by", reduceBy_);
+    const int f = reduceBy_;
+    // 缩小图须与 image 对应（PipelineOptions::reduceBy 与本对象的倍数不一致时自己缩小）
+    const Mat* small = &reduced;
+    if (reduced.size() != Size(cvRound(image.cols / double(f)), cvRound(image.rows / double(f)))) {
+        resize(image, reducedBuffer_, Size(), 1.0 / f, 1.0 / f, INTER_AREA);
+        small = &reducedBuffer_;
+    }
+
+    // 粗检：roi 按倍数缩小（向外取整），尺寸限制同样缩小
+    const Rect smallRoi = Rect(roi.x / f, roi.y / f, (roi.x + roi.width + f - 1) / f - roi.x / f,
+                               (roi.y + roi.height + f - 1) / f - roi.y / f) &
+                          Rect(0, 0, small->cols, small->rows);
+    const Size smallMax = maxSize.empty() ? Size() : scaleSize(maxSize, 1.0 / f);
+    if (tiled) {
+        detector_.detectMultiScaleTiled((*small)(smallRoi), coarse_, pool, scaleFactor, minNeighbors,
+                                        scaleSize(minSize, 1.0 / f), smallMax);
+    } else {
+        detector_.detectMultiScale((*small)(smallRoi), coarse_, scaleFactor, minNeighbors, 0,
+                                   scaleSize(minSize, 1.0 / f), smallMax);
+    }
+    HAAR_TRACE_ARG("coarse", coarse_.size());
+
+    // 精修：每个粗检框放大回原分辨率，在它周围的小窗口里按相近尺寸重新检测，取中心最近的一个
+    objects.clear();
+    for (Rect c : coarse_) {
+        c = Rect((c.x + smallRoi.x) * f, (c.y + smallRoi.y) * f, c.width * f, c.height * f);
+        const int padX = max(cvRound(c.width * options_.refinePadding), options_.minRefinePadding);
+        const int padY = max(cvRound(c.height * options_.refinePadding), options_.minRefinePadding);
+        const Rect window = Rect(c.x - padX, c.y - padY, c.width + 2 * padX, c.height + 2 * padY) & roi;
+
+        Size lo = scaleSize(c.size(), 1.0 / options_.refineSizeSlack);
+        Size hi = scaleSize(c.size(), options_.refineSizeSlack);
+        lo = Size(max(lo.width, minSize.width), max(lo.height, minSize.height));
+        if (!maxSize.empty()) hi = Size(min(hi.width, maxSize.width), min(hi.height, maxSize.height));
+        hi = Size(max(hi.width, lo.width), max(hi.height, lo.height));
+        detector_.detectMultiScale(image(window), found_, scaleFactor, minNeighbors, 0, lo, hi);
+
+        const Point2f center(c.x + c.width / 2.f, c.y + c.height / 2.f);
+        double bestDist = -1;
+        Rect best;
+        for (Rect d : found_) {
+            d += window.tl();
+            const double dx = d.x + d.width / 2.f - center.x, dy = d.y + d.height / 2.f - center.y;
+            const double dist = dx * dx + dy * dy;
+            if (bestDist < 0 || dist < bestDist) {
+                bestDist = dist;
+                best = d;
+            }
+        }
+        if (bestDist < 0) {
+            if (!options_.keepUnrefined) continue;
+            best = c & roi;
+        }
+
+        bool duplicate = false;
+        for (const Rect& o : objects) duplicate = duplicate || iou(o, best) >= options_.nmsIou;
+        if (!duplicate) objects.push_back(best);
+    }
+    HAAR_TRACE_ARG("detections", objects.size());
+}
+
+}  // namespace haar
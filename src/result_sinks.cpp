@@ -0,0 +1,303 @@
+#include "result_sinks.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace fs = std::filesystem;
+using namespace cv;
+using namespace std;
+
+namespace haar {
+
+namespace {
+
+const char* const CSV_HEADER =
+    "frame,file,label,x,y,width,height,score,roi,search_x,search_y,search_width,search_height,"
+    "decode_ms,detect_ms";
+
+// 实际搜索区域；没有标注或覆盖整帧时视为整帧检测
+Rect searchRegion(const Frame& frame, const FrameResult& result, bool& roi) {
+    Rect full(0, 0, frame.image.cols, frame.image.rows);
+    Rect region = result.searchRegion & full;
+    roi = !region.empty() && region != full;
+    return roi ? region : full;
+}
+
+string csvField(const string& s) {
+    if (s.find_first_of(",\"\n") == string::npos) return s;
+    string quoted = "\"";
+    for (char c : s) {
+        if (c == '"') quoted += '"';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+string jsonString(const string& s) {
+    string out = "\"";
+    for (char c : s) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    return out + "\"";
+}
+
+string formatCsv(const Frame& frame, const FrameResult& result) {
+    bool roi = false;
+    Rect search = searchRegion(frame, result, roi);
+    const string file = csvField(fs::path(frame.path).filename().string());
+
+    ostringstream tail;
+    tail << fixed << setprecision(3) << (roi ? 1 : 0) << ',' << search.x << ',' << search.y << ','
+         << search.width << ',' << search.height << ',' << frame.decodeMs << ',' << result.detectMs;
+
+    ostringstream out;
+    if (result.boxes.empty()) {
+        out << frame.index << ',' << file << ",,,,,,," << tail.str() << '\n';
+    }
+    for (const auto& a : result.boxes) {
+        out << frame.index << ',' << file << ',' << csvField(a.label ? a.label : "") << ','
+            << a.box.x << ',' << a.box.y << ',' << a.box.width << ',' << a.box.height << ','
+            << a.score << ',' << tail.str() << '\n';
+    }
+    return out.str();
+}
+
+string formatJson(const Frame& frame, const FrameResult& result) {
+    bool roi = false;
+    Rect search = searchRegion(frame, result, roi);
+
+    ostringstream out;
+    out << "{\"frame\":" << frame.index << ",\"file\":" << jsonString(fs::path(frame.path).filename().string())
+        << ",\"roi\":" << (roi ? "true" : "false") << ",\"search\":[" << search.x << ',' << search.y << ','
+        << search.width << ',' << search.height << "],\"boxes\":[";
+    for (size_t b = 0; b < result.boxes.size(); ++b) {
+        const BoxAnnotation& a = result.boxes[b];
+        out << (b ? "," : "") << "{\"label\":" << jsonString(a.label ? a.label : "") << ",\"x\":" << a.box.x
+            << ",\"y\":" << a.box.y << ",\"width\":" << a.box.width << ",\"height\":" << a.box.height
+            << ",\"score\":" << a.score << '}';
+    }
+    out << fixed << setprecision(3) << "],\"decode_ms\":" << frame.decodeMs
+        << ",\"detect_ms\":" << result.detectMs << "}\n";
+    return out.str();
+}
+
+// 把结果转交给不归 TeeSink 所有的 sink
+class ObserverSink : public FrameSink {
+public:
+    explicit ObserverSink(FrameSink& target) : target_(target) {}
+    void consume(const Frame& frame, const FrameResult& result) override { target_.consume(frame, result); }
+
+private:
+    FrameSink& target_;
+};
+
+// 命令行数值参数：整个 value 都是 [low, INT_MAX] 内的整数 / 不小于 low 的有限数才接受，否则打印用法错误并 exit(2)
+int parseIntFlag(const string& flag, const string& value, int low) {
+    char* end = nullptr;
+    errno = 0;
+    const long v = strtol(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0' || errno == ERANGE || v < low || v > INT_MAX) {
+        cerr << "❌ Invalid " << flag << ": " << value << " (expected an integer >= " << low << ")" << endl;
+        exit(2);
+    }
+    return static_cast<int>(v);
+}
+
+double parseNumberFlag(const string& flag, const string& value, double low, bool inclusive) {
+    char* end = nullptr;
+    errno = 0;
+    const double v = strtod(value.c_str(), &end);
+    if (value.empty() || *end != '\0' || errno == ERANGE || !isfinite(v) || v < low || (!inclusive && v == low)) {
+        cerr << "❌ Invalid " << flag << ": " << value << " (expected a number " << (inclusive ? ">= " : "> ") << low
+             << ")" << endl;
+        exit(2);
+    }
+    return v;
+}
+
+}  // namespace
+
+AnnotationWriterSink::AnnotationWriterSink(const string& path, AnnotationFormat format, size_t window)
+    : out_(path), format_(format), lines_(window) {
+    if (!out_.is_open()) {
+        cerr << "❌ Failed to open annotation file: " << path << endl;
+    } else if (format_ == AnnotationFormat::Csv) {
+        out_ << CSV_HEADER << '\n';
+    }
+    writer_ = thread([this] { writeLoop(); });
+}
+
+AnnotationWriterSink::~AnnotationWriterSink() {
+    lines_.close();
+    writer_.join();
+}
+
+void AnnotationWriterSink::consume(const Frame& frame, const FrameResult& result) {
+    lines_.push(result.sequence, format_ == AnnotationFormat::Csv ? formatCsv(frame, result)
+                                                                 : formatJson(frame, result));
+}
+
+void AnnotationWriterSink::writeLoop() {
+    string line;
+    while (lines_.pop(line)) {
+        if (out_.is_open()) out_ << line;
+    }
+    out_.flush();
+}
+
+VideoWriterSink::VideoWriterSink(const string& path, double fps, size_t window)
+    : path_(path), fps_(fps), frames_(window) {
+    writer_ = thread([this] { writeLoop(); });
+}
+
+VideoWriterSink::~VideoWriterSink() {
+    frames_.close();
+    writer_.join();
+}
+
+void VideoWriterSink::consume(const Frame& frame, const FrameResult& result) {
+    Mat display;  // 交给后台线程，不能复用
+    renderAnnotations(frame, result, display);
+    frames_.push(result.sequence, std::move(display));
+}
+
+void VideoWriterSink::writeLoop() {
+    VideoWriter video;
+    bool failed = false;
+    Size size;
+    Mat frame, resized;
+    while (frames_.pop(frame)) {
+        if (failed) continue;
+        if (!video.isOpened()) {
+            size = frame.size();
+            if (!video.open(path_, VideoWriter::fourcc('M', 'J', 'P', 'G'), fps_, size, frame.channels() == 3)) {
+                cerr << "❌ Failed to open video writer: " << path_ << endl;
+                failed = true;
+                continue;
+            }
+        }
+        if (frame.size() != size) {
+            resize(frame, resized, size);
+            video.write(resized);
+        } else {
+            video.write(frame);
+        }
+    }
+}
+
+void TeeSink::consume(const Frame& frame, const FrameResult& result) {
+    for (auto& sink : sinks_) sink->consume(frame, result);
+}
+
+unique_ptr<FrameSink> makeSink(const PipelineOptions& options, const string& outputFolder,
+                               const string& imageSuffix) {
+    const OutputOptions& out = options.output;
+    if (out.video || out.csv || out.jsonLines) fs::create_directories(outputFolder);
+
+    // 乱序到达的帧最多领先 window 个序号，给编码并发留足余量
+    const size_t window = 2 * max<size_t>(options.queueDepth, 1) + max(options.encodeThreads, 1);
+
+    auto tee = make_unique<TeeSink>();
+    if (out.images) tee->add(make_unique<ImageWriterSink>(outputFolder, imageSuffix));
+    if (out.video) tee->add(make_unique<VideoWriterSink>(outputFolder + "/annotated.avi", out.videoFps, window));
+    if (out.csv) {
+        tee->add(make_unique<AnnotationWriterSink>(outputFolder + "/annotations.csv", AnnotationFormat::Csv, window));
+    }
+    if (out.jsonLines) {
+        tee->add(make_unique<AnnotationWriterSink>(outputFolder + "/annotations.jsonl", AnnotationFormat::JsonLines,
+                                                   window));
+    }
+    if (options.observer) tee->add(make_unique<ObserverSink>(*options.observer));
+    return tee;
+}
+
+bool parseOutputFlag(int argc, char** argv, int& i, PipelineOptions& options) {
+    string arg = argv[i];
+    if (arg == "--live") {
+        options.live.enabled = true;
+        return true;
+    }
+    if (arg != "--sink" && arg != "--preview-every" && arg != "--video-fps" && arg != "--trace" && arg != "--set" &&
+        arg != "--config" && arg != "--live-fps" && arg != "--live-buffer" && arg != "--live-frames") {
+        return false;
+    }
+    if (i + 1 >= argc) {
+        cerr << "❌ Missing value for " << arg << endl;
+        exit(2);
+    }
+    string value = argv[++i];
+
+    if (arg == "--sink") {
+        OutputOptions out;
+        out.images = false;
+        out.videoFps = options.output.videoFps;
+        stringstream list(value);
+        string name;
+        while (getline(list, name, ',')) {
+            if (name == "images") out.images = true;
+            else if (name == "video") out.video = true;
+            else if (name == "csv") out.csv = true;
+            else if (name == "jsonl") out.jsonLines = true;
+            else if (name != "none") {
+                cerr << "❌ Unknown sink: " << name << " (expected images, video, csv, jsonl or none)" << endl;
+                exit(2);
+            }
+        }
+        options.output = out;
+    } else if (arg == "--trace") {
+        trace::start(value);
+    } else if (arg == "--set") {
+        if (!options.tunables.parse(value)) {
+            cerr << "❌ Invalid --set: " << value << " (expected name=number)" << endl;
+            exit(2);
+        }
+    } else if (arg == "--config") {
+        string error;
+        if (!options.tunables.load(value, error)) {
+            cerr << "❌ Invalid --config: " << error << endl;
+            exit(2);
+        }
+    } else if (arg == "--live-fps") {
+        options.live.replayFps = parseNumberFlag(arg, value, 0, true);
+    } else if (arg == "--live-buffer") {
+        options.live.bufferFrames = parseIntFlag(arg, value, 1);
+    } else if (arg == "--live-frames") {
+        options.live.maxFrames = parseIntFlag(arg, value, 0);
+    } else if (arg == "--preview-every") {
+        options.previewEvery = parseIntFlag(arg, value, 0);
+    } else {
+        options.output.videoFps = parseNumberFlag(arg, value, 0, false);
+    }
+    return true;
+}
+
+vector<string> parseDetectorArgs(int argc, char** argv, PipelineOptions& options) {
+    vector<string> folders;
+    for (int i = 1; i < argc; ++i) {
+        if (!parseOutputFlag(argc, argv, i, options)) folders.emplace_back(argv[i]);
+    }
+    return folders;
+}
+
+}  // namespace haar
@@ -0,0 +1,95 @@
+#include "search_window.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace cv;
+using namespace std;
+
+namespace haar {
+
+void SearchWindow::narrow(Size& minSize, Size& maxSize) const {
+    if (fullFrame || minObject.empty()) return;
+    minSize = Size(max(minSize.width, minObject.width), max(minSize.height, minObject.height));
+    maxSize = maxSize.empty() ? maxObject
+                              : Size(min(maxSize.width, maxObject.width), min(maxSize.height, maxObject.height));
+    maxSize = Size(max(maxSize.width, minSize.width), max(maxSize.height, minSize.height));
+}
+
+namespace {
+
+Point2f center(const Rect& box) {
+    return Point2f(box.x + box.width / 2.f, box.y + box.height / 2.f);
+}
+
+}  // namespace
+
+SearchWindowPlanner::SearchWindowPlanner(SearchWindowOptions options)
+    : options_(std::move(options)), filter_(options_.accelerationStd, options_.measurementStd) {
+    if (options_.stages.empty()) options_.stages = {1};
+}
+
+SearchWindow SearchWindowPlanner::begin(Size frameSize) {
+    const Rect frame(Point(0, 0), frameSize);
+    SearchWindow window;
+    window.roi = frame;
+    if (!tracking_) return window;
+
+    filter_.predict();
+    const int stage = min(misses_, static_cast<int>(options_.stages.size()) - 1);
+    const double factor = options_.stages[stage];
+    const Point2f c = filter_.position(), sigma = filter_.positionStd();
+    const double cx = c.x, cy = c.y;
+    const double halfW = factor * (lastSize_.width / 2.0 + max<double>(options_.minMargin, options_.sigmas * sigma.x));
+    const double halfH = factor * (lastSize_.height / 2.0 + max<double>(options_.minMargin, options_.sigmas * sigma.y));
+
+    const Rect roi = Rect(cvRound(cx - halfW), cvRound(cy - halfH), cvRound(2 * halfW), cvRound(2 * halfH)) & frame;
+    if (roi.empty()) {
+        // 预测已出画面，按丢失处理
+        tracking_ = false;
+        misses_ = 0;
+        return window;
+    }
+
+    window.roi = roi;
+    window.fullFrame = false;
+    window.stage = stage;
+    window.minObject = Size(cvFloor(lastSize_.width / options_.sizeSlack),
+                            cvFloor(lastSize_.height / options_.sizeSlack));
+    window.maxObject = Size(cvCeil(lastSize_.width * options_.sizeSlack),
+                            cvCeil(lastSize_.height * options_.sizeSlack));
+    return window;
+}
+
+void SearchWindowPlanner::update(const Rect& box) {
+    if (!tracking_) {
+        // 首次检测：位置取测量值，速度未知
+        filter_.reset(center(box), options_.initialVelocityStd);
+        tracking_ = true;
+    } else {
+        filter_.correct(center(box));
+    }
+    lastSize_ = box.size();
+    misses_ = 0;
+}
+
+void SearchWindowPlanner::miss() {
+    if (!tracking_) return;
+    if (++misses_ >= static_cast<int>(options_.stages.size())) {
+        tracking_ = false;
+        misses_ = 0;
+    }
+}
+
+Rect SearchWindowPlanner::predicted() const {
+    if (!tracking_) return Rect();
+    const Point2f c = filter_.position();
+    return Rect(cvRound(c.x - lastSize_.width / 2.f), cvRound(c.y - lastSize_.height / 2.f), lastSize_.width,
+                lastSize_.height);
+}
+
+double SearchWindowPlanner::distance(const Rect& box) const {
+    return tracking_ ? filter_.distance(center(box)) : HUGE_VAL;
+}
+
+}  // namespace haar
@@ -0,0 +1,175 @@
+#include "square_detector.h"
+#include "trace.h"
+
+#include <algorithm>
+
+using namespace cv;
+using namespace std;
+
+namespace haar {
+
+namespace {
+
+// GaussianBlur(5x5, σ=1.5) 在 CV_8U 上走 OpenCV 的逐位精确定点实现：系数为 8 位小数，
+// 两趟都不舍入，最后 (v + 2^15) >> 16。这组系数与之逐像素核对过
+const int K0 = 31, K1 = 60, K2 = 74;
+const int KERNEL_RADIUS = 2;
+
+// 返回 buffer 左上角 size 大小的视图；buffer 不够大或类型不符时才重新分配（按两者的较大尺寸）。
+// 尺寸随 ROI 变化的输出写进这里，OpenCV 的 create() 见到尺寸类型一致的视图就不会再分配
+Mat view(Mat& buffer, Size size, int type) {
+    if (buffer.type() != type || buffer.cols < size.width || buffer.rows < size.height) {
+        buffer.create(max(buffer.rows, size.height), max(buffer.cols, size.width), type);
+    }
+    return buffer(Rect(0, 0, size.width, size.height));
+}
+
+// 一行源像素（已含左右各 2 列的边）→ 水平模糊，8 位小数定点，最大 255 * 256 放得进 uint16
+void blurRowH(const uchar* src, uint16_t* dst, int width) {
+    for (int c = 0; c < width; ++c) {
+        dst[c] = static_cast<uint16_t>(K0 * (src[c] + src[c + 4]) + K1 * (src[c + 1] + src[c + 3]) +
+                                       K2 * src[c + 2]);
+    }
+}
+
+// 5 行水平结果 → 一行模糊像素，写到 dst[1..width]，两端复制 1 像素供 Sobel 使用
+void blurRowV(const uint16_t* const* rows, uchar* dst, int width) {
+    for (int c = 0; c < width; ++c) {
+        uint32_t v = uint32_t(K0) * (rows[0][c] + rows[4][c]) + uint32_t(K1) * (rows[1][c] + rows[3][c]) +
+                     uint32_t(K2) * rows[2][c];
+        dst[c + 1] = static_cast<uchar>((v + (1u << 15)) >> 16);
+    }
+    dst[0] = dst[1];
+    dst[width + 1] = dst[width];
+}
+
+// 3x3 Sobel，与 Canny 内部的 Sobel(CV_16S, BORDER_REPLICATE) 相同
+void sobelRow(const uchar* r0, const uchar* r1, const uchar* r2, short* dx, short* dy, int width) {
+    for (int c = 0; c < width; ++c) {
+        dx[c] = static_cast<short>((r0[c + 2] - r0[c]) + 2 * (r1[c + 2] - r1[c]) + (r2[c + 2] - r2[c]));
+        dy[c] = static_cast<short>((r2[c] + 2 * r2[c + 1] + r2[c + 2]) - (r0[c] + 2 * r0[c + 1] + r0[c + 2]));
+    }
+}
+
+}  // namespace
+
+SquareDetector::SquareDetector(SquareDetectorOptions options) : options_(options) {}
+
+// 逐行流水：每个源行只做一次水平模糊，放进 5 行环形缓冲；凑够 5 行出一行模糊结果，
+// 凑够 3 行模糊结果出一行梯度。整帧时工作集也只有几行，始终留在 L1 里
+void SquareDetector::blurSobel(const Mat& gray, Rect roi, Mat& dx, Mat& dy) {
+    const int w = roi.width, h = roi.height;
+    const int padded = w + 2 * KERNEL_RADIUS;
+
+    // ROI 离帧左右边界至少 2 列时直接读源行，否则按反射后的列号取到 gathered_ 里
+    const bool direct = roi.x >= KERNEL_RADIUS && roi.x + w + KERNEL_RADIUS <= gray.cols;
+    if (!direct) {
+        cols_.resize(padded);
+        for (int c = 0; c < padded; ++c) {
+            cols_[c] = borderInterpolate(roi.x - KERNEL_RADIUS + c, gray.cols, BORDER_REFLECT_101);
+        }
+        gathered_.resize(padded);
+    }
+
+    hrows_.resize(size_t(5) * w);
+    brows_.resize(size_t(3) * (w + 2));
+
+    // ROI 内第 j 行（-2 <= j < h + 2）的水平模糊结果放在环形槽 (j + 2) % 5
+    auto hrow = [&](int j) { return &hrows_[size_t((j + KERNEL_RADIUS) % 5) * w]; };
+    auto brow = [&](int j) { return &brows_[size_t(j % 3) * (w + 2)]; };
+    auto loadRow = [&](int j) {
+        int y = borderInterpolate(roi.y + j, gray.rows, BORDER_REFLECT_101);
+        const uchar* src = gray.ptr<uchar>(y);
+        if (direct) {
+            src += roi.x - KERNEL_RADIUS;
+        } else {
+            for (int c = 0; c < padded; ++c) gathered_[c] = src[cols_[c]];
+            src = gathered_.data();
+        }
+        blurRowH(src, hrow(j), w);
+    };
+
+    for (int j = -KERNEL_RADIUS; j < KERNEL_RADIUS; ++j) loadRow(j);
+
+    const uint16_t* rows[5];
+    for (int k = 0; k < h; ++k) {
+        loadRow(k + KERNEL_RADIUS);
+        for (int d = 0; d < 5; ++d) rows[d] = hrow(k - KERNEL_RADIUS + d);
+        blurRowV(rows, brow(k), w);
+
+        // Canny 把 ROI 当独立图像，上下边界按 BORDER_REPLICATE 取
+        if (k >= 1) {
+            int r = k - 1;
+            sobelRow(brow(max(r - 1, 0)), brow(r), brow(k), dx.ptr<short>(r), dy.ptr<short>(r), w);
+        }
+    }
+    sobelRow(brow(max(h - 2, 0)), brow(h - 1), brow(h - 1), dx.ptr<short>(h - 1), dy.ptr<short>(h - 1), w);
+}
+
+// approxPolyDP 的顶点都取自轮廓本身，逼近结果的外接框不会比轮廓的大。
+// 面积 > A 且宽高比 > a ⇒ 宽² > A·a；宽高比 < b ⇒ 高² > A/b。轮廓外接框连这些都达不到就不必逼近。
+// 宽高比在原判断里是 float，留 0.1% 余量，保证不会多排除
+bool SquareDetector::mayHoldSquare(const Rect& bounds, size_t points) const {
+    if (points < 4) return false;
+    const double slack = 0.999;
+    double w = bounds.width, h = bounds.height;
+    return w * h > options_.minArea && w * w > options_.minArea * options_.minAspect * slack &&
+           h * h > options_.minArea / options_.maxAspect * slack;
+}
+
+void SquareDetector::gradients(const Mat& gray, Rect roi, Mat& dx, Mat& dy) {
+    CV_Assert(gray.type() == CV_8UC1 && !roi.empty() && (roi & Rect(0, 0, gray.cols, gray.rows)) == roi);
+    dx = view(dx_, roi.size(), CV_16SC1);
+    dy = view(dy_, roi.size(), CV_16SC1);
+    blurSobel(gray, roi, dx, dy);
+}
+
+bool SquareDetector::detect(const Mat& gray, Rect roi, Rect& box, double& score) {
+    HAAR_TRACE_SCOPE("squares.detect");
+    CV_Assert(gray.type() == CV_8UC1);
+    score = 0;
+    roi &= Rect(0, 0, gray.cols, gray.rows);
+    HAAR_TRACE_ARG("roi_width", roi.width);
+    HAAR_TRACE_ARG("roi_height", roi.height);
+    if (roi.empty()) return false;
+
+    Mat edges = view(edges_, roi.size(), CV_8UC1);
+    if (options_.fused) {
+        Mat dx, dy;
+        gradients(gray, roi, dx, dy);
+        Canny(dx, dy, edges, options_.cannyLow, options_.cannyHigh);
+    } else {
+        GaussianBlur(gray, blurred_, Size(5, 5), 1.5);
+        Canny(blurred_(roi), edges, options_.cannyLow, options_.cannyHigh);
+    }
+
+    arena_.reset();
+    vector<vector<Point>>& contours = arena_.contours();
+    findContours(edges, contours, RETR_EXTERNAL, CHAIN_APPROX_SIMPLE);
+    HAAR_TRACE_ARG("contours", contours.size());
+
+    vector<Point>& approx = arena_.scratch();
+    int candidates = 0;
+    for (const auto& cnt : contours) {
+        if (options_.fused && !mayHoldSquare(boundingRect(cnt), cnt.size())) continue;
+        ++candidates;
+
+        approxPolyDP(cnt, approx, arcLength(cnt, true) * options_.approxEpsilon, true);
+        if (approx.size() != 4 || !isContourConvex(approx)) continue;
+
+        Rect candidate = boundingRect(approx);
+        candidate.x += roi.x;
+        candidate.y += roi.y;
+        float aspectRatio = (float)candidate.width / candidate.height;
+        float area = candidate.area();
+        if (aspectRatio > options_.minAspect && aspectRatio < options_.maxAspect &&
+            area > options_.minArea && area < options_.maxArea && area > score) {
+            score = area;
+            box = candidate;
+        }
+    }
+    HAAR_TRACE_ARG("candidates", candidates);
+    return score > 0;
+}
+
+}  // namespace haar
@@ -0,0 +1,139 @@
+#include "template_bank.h"
+#include "trace.h"
+#include "work_stealing_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+using namespace cv;
+using namespace std;
+
+namespace haar {
+
+namespace {
+
+// 模板库的默认参数（见 readTemplateBankOptions）：变体数直接乘在每帧的匹配次数上，默认只取三档缩放
+const double BANK_MAX_SCALE = 1.2;
+const int BANK_SCALE_STEPS = 1;
+const double BANK_MAX_ANGLE = 10;
+const int BANK_ANGLE_STEPS = 0;
+const double EARLY_ACCEPT = 0.9;
+
+}  // namespace
+
+vector<double> geometricScales(double maxScale, int stepsPerSide) {
+    if (stepsPerSide <= 0 || !(maxScale > 1)) return {1.0};
+    vector<double> scales;
+    for (int i = -stepsPerSide; i <= stepsPerSide; ++i) scales.push_back(pow(maxScale, double(i) / stepsPerSide));
+    return scales;
+}
+
+vector<double> symmetricAngles(double maxAngle, int stepsPerSide) {
+    if (stepsPerSide <= 0 || !(maxAngle > 0)) return {0.0};
+    vector<double> angles;
+    for (int i = -stepsPerSide; i <= stepsPerSide; ++i) angles.push_back(maxAngle * i / stepsPerSide);
+    return angles;
+}
+
+bool readTemplateBankOptions(const Tunables& tune, TemplateBankOptions& options, string& error) {
+    const double maxScale = tune.get("bank_max_scale", BANK_MAX_SCALE);
+    const double maxAngle = tune.get("bank_max_angle", BANK_MAX_ANGLE);
+    options.earlyAccept = tune.get("early_accept", EARLY_ACCEPT);
+    int scaleSteps = 0, angleSteps = 0;
+    if (!tune.getInt("bank_scale_steps", BANK_SCALE_STEPS, scaleSteps, error) ||
+        !tune.getInt("bank_angle_steps", BANK_ANGLE_STEPS, angleSteps, error) || !checkMin("bank_max_scale", maxScale, 1, error) || !checkMin("bank_scale_steps", scaleSteps, 0, error) ||
+        !checkMin("bank_max_angle", maxAngle, 0, error) || !checkMin("bank_angle_steps", angleSteps, 0, error)) {
+        return false;
+    }
+    options.scales = geometricScales(maxScale, scaleSteps);
+    options.angles = symmetricAngles(maxAngle, angleSteps);
+    return true;
+}
+
+TemplateBank::TemplateBank(const Mat& templ, TemplateBankOptions options) : options_(std::move(options)) {
+    CV_Assert(!templ.empty() && templ.type() == CV_8UC1);
+    if (options_.scales.empty()) options_.scales = {1.0};
+    if (options_.angles.empty()) options_.angles = {0.0};
+
+    // 离原模板越近越先匹配：提前结束时跟踪中最常见的变体不会被跳过
+    struct Pose {
+        double scale, angle;
+    };
+    vector<Pose> poses;
+    for (double s : options_.scales) {
+        for (double a : options_.angles) poses.push_back({s, a});
+    }
+    stable_sort(poses.begin(), poses.end(), [](const Pose& a, const Pose& b) {
+        return fabs(log(a.scale)) + fabs(a.angle) / 90.0 < fabs(log(b.scale)) + fabs(b.angle) / 90.0;
+    });
+
+    for (const Pose& p : poses) {
+        const Size size(cvRound(templ.cols * p.scale), cvRound(templ.rows * p.scale));
+        if (size.width < 1 || size.height < 1) continue;
+        Mat variant;
+        if (size == templ.size()) {
+            variant = templ;
+        } else {
+            resize(templ, variant, size, 0, 0, p.scale < 1 ? INTER_AREA : INTER_LINEAR);
+        }
+        if (p.angle != 0) {
+            const Mat rotation = getRotationMatrix2D(Point2f((size.width - 1) * 0.5f, (size.height - 1) * 0.5f),
+                                                     p.angle, 1.0);
+            Mat rotated;
+            warpAffine(variant, rotated, rotation, size, INTER_LINEAR, BORDER_REPLICATE);
+            variant = rotated;
+        }
+        variants_.push_back({p.scale, p.angle, TemplateMatcher(variant, options_.matcher)});
+        maxSize_.width = max(maxSize_.width, size.width);
+        maxSize_.height = max(maxSize_.height, size.height);
+    }
+    CV_Assert(!variants_.empty());
+}
+
+Rect TemplateBank::searchWindow(Size frameSize, Point center, int radius) const {
+    Rect searchRect(Point(0, 0), frameSize);
+    if (center.x > 0 && center.y > 0) {
+        searchRect &= Rect(center.x - maxSize_.width / 2 - radius, center.y - maxSize_.height / 2 - radius,
+                           maxSize_.width + 2 * radius, maxSize_.height + 2 * radius);
+    }
+    return searchRect;
+}
+
+BankMatch TemplateBank::match(const Mat& image, Rect searchRect, WorkStealingPool* pool) const {
+    HAAR_TRACE_SCOPE("template_bank.match");
+    searchRect &= Rect(0, 0, image.cols, image.rows);
+    HAAR_TRACE_ARG("variants", variants_.size());
+
+    // accepted 为目前已知达到 earlyAccept 的最小序号：只跳过排在它后面的变体，它前面的一定都会匹配，
+    // 最后只在 0..最小达标序号 里取，结果不取决于哪些变体先开始
+    const size_t n = variants_.size();
+    vector<TemplateMatch> results(n);
+    atomic<size_t> accepted{n};
+    parallelFor(pool, n, [&](size_t v) {
+        if (v > accepted.load(memory_order_relaxed)) return;
+        const Size size = variants_[v].matcher.size();
+        if (searchRect.width < size.width || searchRect.height < size.height) return;
+        results[v] = variants_[v].matcher.match(image, searchRect);
+        if (results[v].score < options_.earlyAccept) return;
+        size_t current = accepted.load(memory_order_relaxed);
+        while (v < current && !accepted.compare_exchange_weak(current, v, memory_order_relaxed)) {
+        }
+    });
+
+    BankMatch best;
+    const size_t k = accepted.load();
+    HAAR_TRACE_ARG("accepted_variant", k < n ? int(k) : -1);
+    for (size_t v = 0; v < min(k + 1, n); ++v) {
+        if (results[v].score <= best.score) continue;  // 未匹配的变体得分为 -1；同分保留序号小的
+        static_cast<TemplateMatch&>(best) = results[v];
+        best.variant = static_cast<int>(v);
+        best.scale = variants_[v].scale;
+        best.angle = variants_[v].angle;
+        best.size = variants_[v].matcher.size();
+    }
+    HAAR_TRACE_ARG("best_variant", best.variant);
+    return best;
+}
+
+}  // namespace haar
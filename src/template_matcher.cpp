@@ -0,0 +1,217 @@
+#include "template_matcher.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace cv;
+using namespace std;
+
+namespace haar {
+
+namespace {
+
+// 粗略的运算量模型：空域为逐窗口乘加，频域为两次正反变换加一次频谱相乘
+double spatialCost(Size image, Size templ) {
+    return double(image.width - templ.width + 1) * (image.height - templ.height + 1) * templ.area();
+}
+
+double dftCost(Size dft) {
+    const double n = double(dft.area());
+    return 3.0 * n * log2(n) + 4.0 * n;
+}
+
+Size dftSizeFor(Size image) {
+    return Size(getOptimalDFTSize(image.width), getOptimalDFTSize(image.height));
+}
+
+}  // namespace
+
+TemplateMatcher::TemplateMatcher(const Mat& templ, TemplateMatcherOptions options)
+    : options_(options), spectraMutex_(new mutex) {
+    reset(templ);
+}
+
+void TemplateMatcher::reset(const Mat& templ) {
+    CV_Assert(!templ.empty() && templ.type() == CV_8UC1);
+
+    size_t count = 0;
+    for (int l = 0; l <= options_.maxLevels; ++l) {
+        if (l > 0) {
+            // pyrDown 的输出为 ((w + 1) / 2, (h + 1) / 2)
+            const Mat& above = levels_[l - 1].templ;
+            if (min((above.cols + 1) / 2, (above.rows + 1) / 2) < options_.minCoarseSide) break;
+        }
+        if (levels_.size() <= size_t(l)) levels_.emplace_back();
+        Level& lv = levels_[l];
+        if (l == 0) {
+            templ.copyTo(lv.templ);
+        } else {
+            pyrDown(levels_[l - 1].templ, lv.templ);
+        }
+        lv.templ.convertTo(lv.zeroMean, CV_32F);
+        lv.zeroMean -= mean(lv.zeroMean)[0];
+        lv.norm = norm(lv.zeroMean, NORM_L2);
+        lv.spectra.clear();
+        ++count;
+    }
+    levels_.resize(count);
+}
+
+void TemplateMatcher::correlateSpatial(const Mat& image, const Level& lv, Mat& corr) const {
+    const Mat& t = lv.zeroMean;
+    corr.create(image.rows - t.rows + 1, image.cols - t.cols + 1, CV_32F);
+    corr.setTo(0);
+
+    // 最内层沿结果行做 acc += t * img，编译器无需 fast-math 即可向量化
+    for (int y = 0; y < corr.rows; ++y) {
+        float* acc = corr.ptr<float>(y);
+        for (int v = 0; v < t.rows; ++v) {
+            const float* trow = t.ptr<float>(v);
+            const float* irow = image.ptr<float>(y + v);
+            for (int u = 0; u < t.cols; ++u) {
+                const float w = trow[u];
+                const float* src = irow + u;
+                for (int x = 0; x < corr.cols; ++x) acc[x] += w * src[x];
+            }
+        }
+    }
+}
+
+void TemplateMatcher::correlateDft(const Mat& image, const Level& lv, Mat& corr) const {
+    const Size dsize = dftSizeFor(image.size());
+
+    Mat templSpectrum;
+    {
+        lock_guard<mutex> lock(*spectraMutex_);
+        Mat& cached = lv.spectra[{dsize.width, dsize.height}];
+        if (cached.empty()) {
+            Mat padded = Mat::zeros(dsize, CV_32F);
+            lv.zeroMean.copyTo(padded(Rect(Point(0, 0), lv.zeroMean.size())));
+            dft(padded, cached, 0, lv.zeroMean.rows);
+        }
+        templSpectrum = cached;
+    }
+
+    Mat padded = Mat::zeros(dsize, CV_32F);
+    image.copyTo(padded(Rect(Point(0, 0), image.size())));
+    Mat spectrum;
+    dft(padded, spectrum, 0, image.rows);
+
+    // 相关 = IDFT(F(I) · conj(F(T)))；DFT 尺寸不小于图像，有效区域不会发生循环混叠
+    mulSpectrums(spectrum, templSpectrum, spectrum, 0, true);
+    const Size rsize(image.cols - lv.zeroMean.cols + 1, image.rows - lv.zeroMean.rows + 1);
+    Mat full;
+    dft(spectrum, full, DFT_INVERSE | DFT_SCALE | DFT_REAL_OUTPUT, rsize.height);
+    full(Rect(Point(0, 0), rsize)).copyTo(corr);
+}
+
+void TemplateMatcher::scoreMap(const Mat& image, int level, Mat& scores) const {
+    const Level& lv = levels_[level];
+    const Size tsize = lv.templ.size();
+
+    Mat imageF;
+    image.convertTo(imageF, CV_32F);
+    // 模板已去均值，分子即为图像与去均值模板的互相关
+    if (spatialCost(image.size(), tsize) <= dftCost(dftSizeFor(image.size()))) {
+        correlateSpatial(imageF, lv, scores);
+    } else {
+        correlateDft(imageF, lv, scores);
+    }
+
+    Mat sum, sqsum;
+    integral(image, sum, sqsum, CV_64F, CV_64F);
+    const double invArea = 1.0 / tsize.area();
+
+    // 归一化与 OpenCV common::matchTemplate 的 TM_CCOEFF_NORMED 分支相同，包括近零分母的处理
+    for (int y = 0; y < scores.rows; ++y) {
+        float* row = scores.ptr<float>(y);
+        const double* s0 = sum.ptr<double>(y);
+        const double* s1 = sum.ptr<double>(y + tsize.height);
+        const double* q0 = sqsum.ptr<double>(y);
+        const double* q1 = sqsum.ptr<double>(y + tsize.height);
+        for (int x = 0; x < scores.cols; ++x) {
+            const int x1 = x + tsize.width;
+            const double wndSum = s1[x1] - s1[x] - s0[x1] + s0[x];
+            const double wndSum2 = q1[x1] - q1[x] - q0[x1] + q0[x];
+            const double t = sqrt(max(wndSum2 - wndSum * wndSum * invArea, 0.0)) * lv.norm;
+            double num = row[x];
+            if (fabs(num) < t) {
+                num /= t;
+            } else if (fabs(num) < t * 1.125) {
+                num = num > 0 ? 1 : -1;
+            } else {
+                num = 0;
+            }
+            row[x] = static_cast<float>(num);
+        }
+    }
+}
+
+TemplateMatch TemplateMatcher::matchExact(const Mat& image, Rect searchRect) const {
+    HAAR_TRACE_SCOPE("template.matchExact");
+    TemplateMatch best;
+    searchRect &= Rect(0, 0, image.cols, image.rows);
+    HAAR_TRACE_ARG("search_width", searchRect.width);
+    HAAR_TRACE_ARG("search_height", searchRect.height);
+    if (searchRect.width < size().width || searchRect.height < size().height) return best;
+
+    Mat scores;
+    scoreMap(image(searchRect), 0, scores);
+    minMaxLoc(scores, nullptr, &best.score, nullptr, &best.location);
+    best.location += searchRect.tl();
+    return best;
+}
+
+TemplateMatch TemplateMatcher::match(const Mat& image, Rect searchRect) const {
+    HAAR_TRACE_SCOPE("template.match");
+    searchRect &= Rect(0, 0, image.cols, image.rows);
+    HAAR_TRACE_ARG("search_width", searchRect.width);
+    HAAR_TRACE_ARG("search_height", searchRect.height);
+    const Size tsize = size();
+    const double resultArea =
+        double(searchRect.width - tsize.width + 1) * (searchRect.height - tsize.height + 1);
+
+    const int level = static_cast<int>(levels_.size()) - 1;
+    if (level == 0 || searchRect.width < tsize.width || searchRect.height < tsize.height ||
+        resultArea < options_.pyramidMinResultArea) {
+        return matchExact(image, searchRect);
+    }
+
+    // 粗搜：搜索区域与模板同样下采样 level 次
+    Mat coarse = image(searchRect);
+    for (int l = 0; l < level; ++l) {
+        Mat down;
+        pyrDown(coarse, down);
+        coarse = down;
+    }
+    const Size ctsize = levels_[level].templ.size();
+    if (coarse.cols < ctsize.width || coarse.rows < ctsize.height) return matchExact(image, searchRect);
+
+    Mat scores;
+    scoreMap(coarse, level, scores);
+    HAAR_TRACE_ARG("pyramid_level", level);
+
+    // 取 topK 个峰，每取一个就把其邻域（半个模板大小）压掉，避免候选挤在同一目标上
+    const int scale = 1 << level;
+    const int margin = scale + 1;  // 下采样的位置误差
+    TemplateMatch best;
+    for (int k = 0; k < options_.topK; ++k) {
+        double peak;
+        Point loc;
+        minMaxLoc(scores, nullptr, &peak, nullptr, &loc);
+        if (peak < -1.5) break;  // 已全部压掉
+        HAAR_TRACE_ARG("peaks", k + 1);
+
+        Rect refine(searchRect.x + loc.x * scale - margin, searchRect.y + loc.y * scale - margin,
+                    tsize.width + 2 * margin, tsize.height + 2 * margin);
+        TemplateMatch m = matchExact(image, refine & searchRect);
+        if (m.score > best.score) best = m;
+
+        Rect suppress(loc.x - ctsize.width / 2, loc.y - ctsize.height / 2, ctsize.width, ctsize.height);
+        scores(suppress & Rect(0, 0, scores.cols, scores.rows)).setTo(-2.0f);
+    }
+    return best;
+}
+
+}  // namespace haar
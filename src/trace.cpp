@@ -0,0 +1,351 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+using namespace std;
+
+namespace haar {
+namespace trace {
+
+namespace detail {
+atomic<bool> active{false};
+}
+
+namespace {
+
+const char TRACE_MAGIC[8] = "HAARTRC";
+const uint32_t TRACE_VERSION = 1;
+
+const chrono::steady_clock::time_point epoch = chrono::steady_clock::now();
+
+// 一个线程的环形缓冲：只有所属线程写，flush() 在各线程停止记录后读
+struct Ring {
+    uint32_t id = 0;
+    string name;
+    vector<Event> events;
+    size_t written = 0;  // 累计写入数，超过容量后覆盖最旧的
+};
+
+struct Registry;
+void flushRegistry(Registry& r);
+
+struct Registry {
+    mutex lock;
+    vector<unique_ptr<Ring>> rings;  // 线程退出后仍保留，导出时还要读
+    string pathPrefix;
+    bool started = false;
+
+    ~Registry() { flushRegistry(*this); }  // 进程正常退出时补写
+};
+
+Registry& registry() {
+    static Registry r;
+    return r;
+}
+
+thread_local Ring* tlsRing = nullptr;
+thread_local Span* tlsCurrent = nullptr;  // 本线程最内层未结束的 span
+thread_local string tlsName;
+
+Ring& threadRing() {
+    if (tlsRing) return *tlsRing;
+    Registry& r = registry();
+    lock_guard<mutex> lock(r.lock);
+    auto ring = make_unique<Ring>();
+    ring->id = static_cast<uint32_t>(r.rings.size());
+    ring->name = tlsName.empty() ? "thread " + to_string(ring->id) : tlsName;
+    ring->events.resize(kRingCapacity);
+    tlsRing = ring.get();
+    r.rings.push_back(std::move(ring));
+    return *tlsRing;
+}
+
+void record(const Event& e) {
+    Ring& ring = threadRing();
+    ring.events[ring.written % kRingCapacity] = e;
+    ++ring.written;
+}
+
+string jsonEscape(const string& s) {
+    string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        if (static_cast<unsigned char>(c) >= 0x20) out += c;
+    }
+    return out;
+}
+
+// 环形缓冲里仍保留的事件，按写入先后
+template <typename Fn>
+void forEachEvent(const Ring& ring, Fn&& fn) {
+    const size_t kept = min(ring.written, kRingCapacity);
+    for (size_t k = ring.written - kept; k < ring.written; ++k) fn(ring.events[k % kRingCapacity]);
+}
+
+// 字符串常量按内容去重编号；指针相同的先走快表
+class StringTable {
+public:
+    uint32_t id(const char* s) {
+        auto it = byPointer_.find(s);
+        if (it != byPointer_.end()) return it->second;
+        return byPointer_[s] = id(string(s));
+    }
+    uint32_t id(const string& s) {
+        auto it = byValue_.find(s);
+        if (it != byValue_.end()) return it->second;
+        strings_.push_back(s);
+        return byValue_[s] = static_cast<uint32_t>(strings_.size() - 1);
+    }
+    const vector<string>& strings() const { return strings_; }
+
+private:
+    unordered_map<const char*, uint32_t> byPointer_;
+    unordered_map<string, uint32_t> byValue_;
+    vector<string> strings_;
+};
+
+void writeChromeTrace(const string& path, const vector<unique_ptr<Ring>>& rings) {
+    ofstream out(path);
+    if (!out.is_open()) {
+        cerr << "❌ Failed to write trace: " << path << endl;
+        return;
+    }
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    for (const auto& ring : rings) {
+        out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->id
+            << ",\"args\":{\"name\":\"" << jsonEscape(ring->name) << "\"}}";
+        first = false;
+    }
+    out << fixed << setprecision(3);
+    for (const auto& ring : rings) {
+        forEachEvent(*ring, [&](const Event& e) {
+            out << ",\n{\"name\":\"" << jsonEscape(e.name) << "\",\"cat\":\"haar\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                << ring->id << ",\"ts\":" << e.startNs / 1000.0 << ",\"dur\":" << e.durationNs / 1000.0;
+            if (e.argCount > 0) {
+                out << ",\"args\":{";
+                for (int a = 0; a < e.argCount; ++a) {
+                    out << (a ? "," : "") << '"' << jsonEscape(e.args[a].key) << "\":" << e.args[a].value;
+                }
+                out << '}';
+            }
+            out << '}';
+        });
+    }
+    out << "\n]}\n";
+}
+
+void writeBinaryLog(const string& path, const vector<unique_ptr<Ring>>& rings, uint64_t eventCount) {
+    StringTable table;
+    vector<TraceFileThread> threads;
+    for (const auto& ring : rings) threads.push_back({ring->id, table.id(ring->name)});
+
+    // 先编号所有字符串，字符串表写在事件之前
+    vector<char> body;
+    body.reserve(eventCount * sizeof(TraceFileEvent));
+    auto append = [&](const void* p, size_t n) {
+        body.insert(body.end(), static_cast<const char*>(p), static_cast<const char*>(p) + n);
+    };
+    for (const auto& ring : rings) {
+        forEachEvent(*ring, [&](const Event& e) {
+            TraceFileEvent fe{e.startNs, e.durationNs, ring->id, static_cast<uint16_t>(table.id(e.name)),
+                              static_cast<uint16_t>(e.argCount)};
+            append(&fe, sizeof(fe));
+            for (int a = 0; a < e.argCount; ++a) {
+                TraceFileArg fa{e.args[a].value, table.id(e.args[a].key), 0};
+                append(&fa, sizeof(fa));
+            }
+        });
+    }
+
+    ofstream out(path, ios::binary);
+    if (!out.is_open()) {
+        cerr << "❌ Failed to write trace: " << path << endl;
+        return;
+    }
+    TraceFileHeader header{};
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.stringCount = static_cast<uint32_t>(table.strings().size());
+    header.threadCount = static_cast<uint32_t>(threads.size());
+    header.eventCount = eventCount;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const string& s : table.strings()) {
+        uint16_t len = static_cast<uint16_t>(min<size_t>(s.size(), UINT16_MAX));
+        out.write(reinterpret_cast<const char*>(&len), sizeof(len));
+        out.write(s.data(), len);
+    }
+    out.write(reinterpret_cast<const char*>(threads.data()), threads.size() * sizeof(TraceFileThread));
+    out.write(body.data(), body.size());
+}
+
+void flushRegistry(Registry& r) {
+    detail::active.store(false);
+    lock_guard<mutex> lock(r.lock);
+    if (!r.started) return;
+    r.started = false;
+
+    uint64_t kept = 0, dropped = 0;
+    for (const auto& ring : r.rings) {
+        kept += min(ring->written, kRingCapacity);
+        dropped += ring->written - min(ring->written, kRingCapacity);
+    }
+    writeChromeTrace(r.pathPrefix + ".json", r.rings);
+    writeBinaryLog(r.pathPrefix + ".trace", r.rings, kept);
+    cout << "📈 Trace: " << kept << " spans on " << r.rings.size() << " threads -> " << r.pathPrefix
+         << ".json, " << r.pathPrefix << ".trace" << endl;
+    if (dropped > 0) {
+        cout << "⚠️ " << dropped << " oldest spans were overwritten (ring capacity " << kRingCapacity
+             << " per thread)" << endl;
+    }
+    for (const auto& ring : r.rings) ring->written = 0;
+}
+
+}  // namespace
+
+uint64_t nowNs() {
+    return static_cast<uint64_t>(
+        chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - epoch).count());
+}
+
+void start(const string& pathPrefix) {
+#ifndef HAAR_TRACING
+    cerr << "⚠️ Tracing was compiled out (configure with -DHAAR_TRACING=ON); --trace ignored" << endl;
+#endif
+    Registry& r = registry();
+    lock_guard<mutex> lock(r.lock);
+    r.pathPrefix = pathPrefix;
+    r.started = true;
+    detail::active.store(true);
+}
+
+void flush() {
+    flushRegistry(registry());
+}
+
+// 记录开着时顺便建好环形缓冲，免得本线程第一条 span 把分配算进去
+void setThreadName(const string& name) {
+    tlsName = name;
+    if (tlsRing) {
+        lock_guard<mutex> lock(registry().lock);
+        tlsRing->name = name;
+    } else if (enabled()) {
+        threadRing();
+    }
+}
+
+void Span::begin(const char* name) {
+    end();
+    if (!enabled()) return;
+    active_ = true;
+    name_ = name;
+    argCount_ = 0;
+    parent_ = tlsCurrent;
+    tlsCurrent = this;
+    start_ = nowNs();
+}
+
+void Span::end() {
+    if (!active_) return;
+    const uint64_t stop = nowNs();
+    active_ = false;
+
+    // 通常是最内层；不是时（StageTimer 在内层 span 未结束时换阶段）从链上摘掉自己
+    if (tlsCurrent == this) {
+        tlsCurrent = parent_;
+    } else {
+        for (Span* s = tlsCurrent; s; s = s->parent_) {
+            if (s->parent_ == this) {
+                s->parent_ = parent_;
+                break;
+            }
+        }
+    }
+
+    if (!enabled()) return;  // flush() 之后结束的 span 不再记录
+    Event e;
+    e.name = name_;
+    e.startNs = start_;
+    e.durationNs = stop - start_;
+    e.argCount = argCount_;
+    copy(args_, args_ + argCount_, e.args);
+    record(e);
+}
+
+void annotate(const char* key, int64_t value) {
+    if (tlsCurrent) tlsCurrent->arg(key, value);
+}
+
+bool readTraceLog(const string& path, TraceLog& log) {
+    ifstream in(path, ios::binary);
+    if (!in.is_open()) {
+        cerr << "❌ Failed to open trace: " << path << endl;
+        return false;
+    }
+    TraceFileHeader header{};
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!in || memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0 || header.version != TRACE_VERSION) {
+        cerr << "❌ Not a trace log (or unsupported version): " << path << endl;
+        return false;
+    }
+
+    vector<string> strings(header.stringCount);
+    for (string& s : strings) {
+        uint16_t len = 0;
+        in.read(reinterpret_cast<char*>(&len), sizeof(len));
+        s.resize(len);
+        in.read(&s[0], len);
+    }
+    vector<TraceFileThread> threads(header.threadCount);
+    in.read(reinterpret_cast<char*>(threads.data()), threads.size() * sizeof(TraceFileThread));
+    if (!in) {
+        cerr << "❌ Truncated trace: " << path << endl;
+        return false;
+    }
+    auto lookup = [&](uint32_t id) -> const string& {
+        static const string unknown = "?";
+        return id < strings.size() ? strings[id] : unknown;
+    };
+
+    log.threads.clear();
+    for (const auto& t : threads) log.threads.emplace_back(t.id, lookup(t.nameId));
+
+    log.events.clear();
+    log.events.reserve(header.eventCount);
+    for (uint64_t i = 0; i < header.eventCount; ++i) {
+        TraceFileEvent fe{};
+        in.read(reinterpret_cast<char*>(&fe), sizeof(fe));
+        TraceRecord rec;
+        rec.name = lookup(fe.nameId);
+        rec.thread = fe.thread;
+        rec.startNs = fe.startNs;
+        rec.durationNs = fe.durationNs;
+        for (uint16_t a = 0; a < fe.argCount; ++a) {
+            TraceFileArg fa{};
+            in.read(reinterpret_cast<char*>(&fa), sizeof(fa));
+            rec.args.emplace_back(lookup(fa.keyId), fa.value);
+        }
+        if (!in) {
+            cerr << "❌ Truncated trace: " << path << endl;
+            return false;
+        }
+        log.events.push_back(std::move(rec));
+    }
+    // 同一时刻开始的，长的（外层）在前
+    stable_sort(log.events.begin(), log.events.end(), [](const TraceRecord& a, const TraceRecord& b) {
+        return a.startNs != b.startNs ? a.startNs < b.startNs : a.durationNs > b.durationNs;
+    });
+    return true;
+}
+
+}  // namespace trace
+}  // namespace haar
@@ -0,0 +1,154 @@
+// 汇总 --trace 写出的二进制追踪日志（见 trace.h）：各 span 的次数与耗时分位数、各标注的取值范围，
+// 以及最慢的几帧里每个阶段花了多少时间、当时的 ROI 大小 / 尺度数 / 候选数
+// 用法：trace_summary <追踪.trace> [--top N]
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "trace.h"
+
+using namespace std;
+using namespace haar;
+
+namespace {
+
+// 最近秩法，与 LatencyRecorder 一致；v 须已排序
+double percentile(const vector<double>& v, double p) {
+    size_t rank = static_cast<size_t>(ceil(p * v.size()));
+    return v[min(max<size_t>(rank, 1), v.size()) - 1];
+}
+
+double toMs(uint64_t ns) { return ns / 1e6; }
+
+string formatArgs(const trace::TraceRecord& e) {
+    string out;
+    for (const auto& a : e.args) out += (out.empty() ? "" : " ") + a.first + "=" + to_string(a.second);
+    return out;
+}
+
+void printSpanTable(const trace::TraceLog& log) {
+    map<string, vector<double>> durations;
+    for (const auto& e : log.events) durations[e.name].push_back(toMs(e.durationNs));
+
+    vector<pair<string, vector<double>>> rows(durations.begin(), durations.end());
+    for (auto& r : rows) sort(r.second.begin(), r.second.end());
+    auto total = [](const vector<double>& v) {
+        double s = 0;
+        for (double d : v) s += d;
+        return s;
+    };
+    sort(rows.begin(), rows.end(), [&](const auto& a, const auto& b) { return total(a.second) > total(b.second); });
+
+    cout << "\n📊 Spans (ms)\n"
+         << left << setw(26) << "name" << right << setw(9) << "count" << setw(11) << "total" << setw(9) << "mean"
+         << setw(9) << "p50" << setw(9) << "p95" << setw(9) << "p99" << setw(9) << "max" << "\n";
+    cout << fixed << setprecision(3);
+    for (const auto& r : rows) {
+        const vector<double>& v = r.second;
+        double sum = total(v);
+        cout << left << setw(26) << r.first << right << setw(9) << v.size() << setw(11) << sum << setw(9)
+             << sum / v.size() << setw(9) << percentile(v, 0.50) << setw(9) << percentile(v, 0.95) << setw(9)
+             << percentile(v, 0.99) << setw(9) << v.back() << "\n";
+    }
+}
+
+void printArgTable(const trace::TraceLog& log) {
+    struct Range {
+        size_t count = 0;
+        int64_t min = 0, max = 0;
+        double sum = 0;
+    };
+    map<pair<string, string>, Range> ranges;
+    for (const auto& e : log.events) {
+        for (const auto& a : e.args) {
+            Range& r = ranges[{e.name, a.first}];
+            r.min = r.count ? min(r.min, a.second) : a.second;
+            r.max = r.count ? max(r.max, a.second) : a.second;
+            r.sum += a.second;
+            ++r.count;
+        }
+    }
+    if (ranges.empty()) return;
+
+    cout << "\n🏷️ Annotations\n"
+         << left << setw(26) << "span" << setw(22) << "key" << right << setw(9) << "count" << setw(10) << "min"
+         << setw(12) << "mean" << setw(10) << "max" << "\n";
+    for (const auto& kv : ranges) {
+        const Range& r = kv.second;
+        cout << left << setw(26) << kv.first.first << setw(22) << kv.first.second << right << setw(9) << r.count
+             << setw(10) << r.min << setw(12) << setprecision(1) << r.sum / r.count << setw(10) << r.max << "\n";
+    }
+    cout << setprecision(3);
+}
+
+// 最慢的 top 帧，列出同一线程上落在该帧时间段内的各个 span
+void printSlowestFrames(const trace::TraceLog& log, size_t top) {
+    vector<size_t> frames;
+    for (size_t i = 0; i < log.events.size(); ++i) {
+        if (log.events[i].name == "frame") frames.push_back(i);
+    }
+    if (frames.empty()) return;
+    sort(frames.begin(), frames.end(),
+         [&](size_t a, size_t b) { return log.events[a].durationNs > log.events[b].durationNs; });
+    frames.resize(min(top, frames.size()));
+
+    cout << "\n🐢 Slowest " << frames.size() << " frames\n";
+    for (size_t f : frames) {
+        const trace::TraceRecord& frame = log.events[f];
+        const uint64_t end = frame.startNs + frame.durationNs;
+        cout << toMs(frame.durationNs) << " ms  " << formatArgs(frame) << "\n";  // 至少有帧号
+
+        // 事件按开始时刻排序：子 span 都在 frame 之后、且开始于 frame 结束之前
+        for (size_t i = f + 1; i < log.events.size() && log.events[i].startNs < end; ++i) {
+            const trace::TraceRecord& e = log.events[i];
+            if (e.thread != frame.thread || e.startNs + e.durationNs > end) continue;
+            cout << "    " << left << setw(24) << e.name << right << setw(9) << toMs(e.durationNs) << " ms";
+            if (!e.args.empty()) cout << "  " << formatArgs(e);
+            cout << "\n";
+        }
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    string path;
+    size_t top = 5;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--top" && i + 1 < argc) {
+            top = static_cast<size_t>(atoi(argv[++i]));
+        } else if (path.empty()) {
+            path = arg;
+        } else {
+            path.clear();
+            break;
+        }
+    }
+    if (path.empty()) {
+        cerr << "usage: trace_summary <trace file> [--top N]" << endl;
+        return 1;
+    }
+
+    trace::TraceLog log;
+    if (!trace::readTraceLog(path, log)) return 1;
+
+    uint64_t first = UINT64_MAX, last = 0;
+    for (const auto& e : log.events) {
+        first = min(first, e.startNs);
+        last = max(last, e.startNs + e.durationNs);
+    }
+    cout << "✅ " << log.events.size() << " spans on " << log.threads.size() << " threads";
+    if (!log.events.empty()) cout << fixed << setprecision(1) << ", " << toMs(last - first) << " ms";
+    cout << endl;
+
+    printSpanTable(log);
+    printArgTable(log);
+    printSlowestFrames(log, top);
+    return 0;
+}
@@ -0,0 +1,167 @@
+#include "track_manager.h"
+#include "trace.h"
+
+#include <algorithm>
+
+using namespace cv;
+using namespace std;
+
+namespace haar {
+
+namespace {
+
+double iou(const Rect& a, const Rect& b) {
+    const double inter = (a & b).area();
+    return inter / (a.area() + b.area() - inter);
+}
+
+}  // namespace
+
+TrackManager::TrackManager(TrackManagerOptions options) : options_(std::move(options)) {
+    options_.maxTracks = max<size_t>(options_.maxTracks, 1);
+    tracks_.reserve(options_.maxTracks);
+    windows_.reserve(options_.maxTracks);
+    detections_.resize(options_.maxTracks);
+}
+
+const vector<DetectionWindow>& TrackManager::plan(Size frameSize) {
+    HAAR_TRACE_SCOPE("track.plan");
+    predict(frameSize);
+    fullScan_ = tracks_.empty() || reacquire_ > 0 || ++sinceFullScan_ >= options_.fullScanInterval;
+    if (fullScan_) scanFullFrame(frameSize);
+    finishPlan();
+    return windows_;
+}
+
+const vector<DetectionWindow>& TrackManager::plan(Size frameSize, const vector<Rect>& scanRegions, bool fullScan) {
+    HAAR_TRACE_SCOPE("track.plan");
+    predict(frameSize);
+    fullScan_ = fullScan || reacquire_ > 0;
+    if (fullScan_) {
+        scanFullFrame(frameSize);
+    } else {
+        for (const Rect& r : scanRegions) {
+            DetectionWindow scan;
+            scan.window.roi = r;
+            scan.window.fullFrame = false;
+            windows_.push_back(scan);
+        }
+    }
+    finishPlan();
+    return windows_;
+}
+
+// 每条轨迹都要预测，扫描帧也一样；预测出画面的轨迹直接删除
+void TrackManager::predict(Size frameSize) {
+    windows_.clear();
+    size_t kept = 0;
+    for (size_t i = 0; i < tracks_.size(); ++i) {
+        Track& t = tracks_[i];
+        t.updated = false;
+        const SearchWindow window = t.planner.begin(frameSize);
+        if (!t.planner.tracking()) {
+            lost(t);
+            continue;
+        }
+        if (kept != i) tracks_[kept] = std::move(t);
+        windows_.push_back({static_cast<int>(kept), window});
+        ++kept;
+    }
+    tracks_.resize(kept);
+}
+
+void TrackManager::lost(const Track& t) {
+    if (t.confirmed) reacquire_ = max(options_.reacquireScans, 0);
+}
+
+void TrackManager::scanFullFrame(Size frameSize) {
+    sinceFullScan_ = 0;
+    reacquire_ = max(reacquire_ - 1, 0);
+    windows_.clear();
+    DetectionWindow scan;
+    scan.window.roi = Rect(Point(0, 0), frameSize);
+    windows_.push_back(scan);
+}
+
+void TrackManager::finishPlan() {
+    if (detections_.size() < windows_.size()) detections_.resize(windows_.size());
+    for (size_t w = 0; w < windows_.size(); ++w) detections_[w].clear();
+
+    HAAR_TRACE_ARG("tracks", tracks_.size());
+    HAAR_TRACE_ARG("windows", windows_.size());
+    HAAR_TRACE_ARG("full_scan", fullScan_ ? 1 : 0);
+}
+
+void TrackManager::update() {
+    HAAR_TRACE_SCOPE("track.update");
+
+    // 相邻轨迹的窗口可能重叠，同一个目标会被检出多次：合并成一份，大框优先
+    merged_.clear();
+    for (size_t w = 0; w < windows_.size(); ++w) {
+        merged_.insert(merged_.end(), detections_[w].begin(), detections_[w].end());
+    }
+    stable_sort(merged_.begin(), merged_.end(), [](const Rect& a, const Rect& b) { return a.area() > b.area(); });
+    size_t kept = 0;
+    for (size_t i = 0; i < merged_.size(); ++i) {
+        bool duplicate = false;
+        for (size_t k = 0; k < kept && !duplicate; ++k) duplicate = iou(merged_[k], merged_[i]) >= options_.nmsIou;
+        if (!duplicate) merged_[kept++] = merged_[i];
+    }
+    merged_.resize(kept);
+
+    // 门限内的 (轨迹, 检测) 按距离从近到远贪心配对
+    pairs_.clear();
+    for (size_t t = 0; t < tracks_.size(); ++t) {
+        for (size_t d = 0; d < merged_.size(); ++d) {
+            const double dist = tracks_[t].planner.distance(merged_[d]);
+            if (dist <= options_.gateSigmas) pairs_.push_back({dist, t, d});
+        }
+    }
+    sort(pairs_.begin(), pairs_.end(), [](const Pair& a, const Pair& b) { return a.distance < b.distance; });
+    taken_.assign(merged_.size(), 0);
+    for (const Pair& p : pairs_) {
+        Track& t = tracks_[p.track];
+        if (t.updated || taken_[p.detection]) continue;
+        taken_[p.detection] = 1;
+        t.updated = true;
+        t.box = merged_[p.detection];
+        t.planner.update(t.box);
+        if (++t.hits >= options_.confirmHits) t.confirmed = true;
+    }
+
+    // 未命中：未确认的轨迹直接删除，已确认的交给搜索窗口逐级放大，放大用完即删除
+    size_t alive = 0;
+    for (size_t i = 0; i < tracks_.size(); ++i) {
+        Track& t = tracks_[i];
+        if (!t.updated) {
+            t.hits = 0;
+            t.planner.miss();
+            if (!t.confirmed) continue;
+            if (!t.planner.tracking()) {
+                lost(t);
+                continue;
+            }
+        }
+        if (alive != i) tracks_[alive] = std::move(t);
+        ++alive;
+    }
+    tracks_.resize(alive);
+
+    // 没关联上的检测新建轨迹
+    for (size_t d = 0; d < merged_.size() && tracks_.size() < options_.maxTracks; ++d) {
+        if (taken_[d]) continue;
+        Track t;
+        t.planner = SearchWindowPlanner(options_.window);
+        t.id = nextId_++;
+        t.box = merged_[d];
+        t.hits = 1;
+        t.confirmed = options_.confirmHits <= 1;
+        t.updated = true;
+        t.planner.update(t.box);
+        tracks_.push_back(std::move(t));
+    }
+    HAAR_TRACE_ARG("detections", merged_.size());
+    HAAR_TRACE_ARG("tracks", tracks_.size());
+}
+
+}  // namespace haar
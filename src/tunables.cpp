@@ -0,0 +1,139 @@
+#include "tunables.h"
+
+#include <climits>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+using namespace cv;
+using namespace std;
+
+namespace haar {
+
+namespace {
+
+string trim(const string& s) {
+    const size_t begin = s.find_first_not_of(" \t\r");
+    if (begin == string::npos) return "";
+    const size_t end = s.find_last_not_of(" \t\r");
+    return s.substr(begin, end - begin + 1);
+}
+
+bool invalid(const string& name, double value, const string& expected, string& error) {
+    ostringstream out;
+    out << "Invalid tunable " << name << "=" << setprecision(15) << value << " (expected " << expected << ")";
+    error = out.str();
+    return false;
+}
+
+}  // namespace
+
+double Tunables::get(const string& name, double fallback) const {
+    read_.insert(name);
+    auto it = values_.find(name);
+    return it == values_.end() ? fallback : it->second;
+}
+
+bool Tunables::getInt(const string& name, int fallback, int& value, string& error) const {
+    read_.insert(name);
+    auto it = values_.find(name);
+    if (it == values_.end()) {
+        value = fallback;
+        return true;
+    }
+    // 先查再转换：超出 int 的 double 转 int 是未定义行为，小数悄悄取整会让扫描把不同的取值当成同一组
+    const double v = it->second;
+    if (v != floor(v) || v < INT_MIN || v > INT_MAX) return invalid(name, v, "an integer", error);
+    value = static_cast<int>(v);
+    return true;
+}
+
+bool Tunables::getSize(const string& prefix, Size fallback, Size& value, string& error) const {
+    return getInt(prefix + "_width", fallback.width, value.width, error) &&
+           getInt(prefix + "_height", fallback.height, value.height, error);
+}
+
+bool Tunables::parse(const string& assignment) {
+    const size_t eq = assignment.find('=');
+    if (eq == string::npos) return false;
+    const string name = trim(assignment.substr(0, eq));
+    const string text = trim(assignment.substr(eq + 1));
+    if (name.empty() || text.empty()) return false;
+
+    char* end = nullptr;
+    const double value = strtod(text.c_str(), &end);
+    if (*end != '\0' || !isfinite(value)) return false;
+    values_[name] = value;
+    return true;
+}
+
+bool Tunables::load(const string& path, string& error) {
+    ifstream in(path);
+    if (!in.is_open()) {
+        error = "cannot open " + path;
+        return false;
+    }
+    string line;
+    for (int number = 1; getline(in, line); ++number) {
+        const string text = trim(line.substr(0, line.find('#')));
+        if (text.empty()) continue;
+        if (!parse(text)) {
+            error = path + ":" + to_string(number) + ": " + line;
+            return false;
+        }
+    }
+    return true;
+}
+
+vector<string> Tunables::unread() const {
+    vector<string> names;
+    for (const auto& [name, value] : values_) {
+        if (!read_.count(name)) names.push_back(name);
+    }
+    return names;
+}
+
+Tunables Tunables::readOnly() const {
+    Tunables kept;
+    for (const auto& [name, value] : values_) {
+        if (read_.count(name)) kept.set(name, value);
+    }
+    return kept;
+}
+
+bool checkMin(const string& name, double value, double lo, string& error) {
+    ostringstream expected;
+    expected << ">= " << lo;
+    return value >= lo || invalid(name, value, expected.str(), error);
+}
+
+bool checkAbove(const string& name, double value, double lo, string& error) {
+    ostringstream expected;
+    expected << "> " << lo;
+    return value > lo || invalid(name, value, expected.str(), error);
+}
+
+bool checkRange(const string& name, double value, double lo, double hi, string& error) {
+    ostringstream expected;
+    expected << lo << " .. " << hi;
+    return (value >= lo && value <= hi) || invalid(name, value, expected.str(), error);
+}
+
+string joinNames(const vector<string>& names) {
+    string joined;
+    for (const string& name : names) joined += (joined.empty() ? "" : ", ") + name;
+    return joined;
+}
+
+string Tunables::describe() const {
+    if (values_.empty()) return "default";
+    ostringstream out;
+    for (const auto& [name, value] : values_) {
+        if (out.tellp() > 0) out << ',';
+        out << name << '=' << value;
+    }
+    return out.str();
+}
+
+}  // namespace haar
@@ -0,0 +1,137 @@
+// 比较 BlobExtractor 与 threshold → morphologyEx(MORPH_CLOSE) → findContours(RETR_EXTERNAL) → boundingRect
+// 按外接框面积排序（面积相同时按 findContours 的输出顺序）后的完整列表：img/video_0* 的各帧、随机噪声、
+// 随机方块与套环（洞里的连通域 RETR_EXTERNAL 不输出）。各帧上另外单线程计时，报告两者的平均耗时。
+// 不论 HAAR_FAST_KERNELS 是否打开都显式选用游程实现；全部一致（返回 0）之后才可以打开该选项
+// 用法：verify_blob_extractor [图片根目录]
+#include <opencv2/opencv.hpp>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+
+#include "blob_extractor.h"
+#include "frame_pipeline.h"
+
+namespace fs = std::filesystem;
+using namespace cv;
+using namespace std;
+using namespace haar;
+
+const int THRESHOLDS[] = {80, 128};
+const int CLOSE_SIZES[] = {5, 3, 1};
+const int SYNTHETIC_IMAGES = 200;
+
+static void referenceBlobs(const Mat& gray, const BlobExtractorOptions& o, Mat& thresh, vector<Rect>& blobs) {
+    threshold(gray, thresh, o.threshold, 255, THRESH_BINARY);
+    if (o.closeSize > 1) {
+        morphologyEx(thresh, thresh, MORPH_CLOSE, getStructuringElement(MORPH_RECT, Size(o.closeSize, o.closeSize)));
+    }
+    vector<vector<Point>> contours;
+    findContours(thresh, contours, RETR_EXTERNAL, CHAIN_APPROX_SIMPLE);
+    blobs.clear();
+    for (const auto& c : contours) blobs.push_back(boundingRect(c));
+    stable_sort(blobs.begin(), blobs.end(), [](const Rect& a, const Rect& b) { return a.area() > b.area(); });
+}
+
+// 全部阈值与闭运算尺寸下比较完整的排序列表，返回不一致的组合数
+static int compareImage(const Mat& gray, const string& where) {
+    int bad = 0;
+    Mat thresh;
+    vector<Rect> expected;
+    for (int t : THRESHOLDS) {
+        for (int k : CLOSE_SIZES) {
+            BlobExtractorOptions options;
+            options.threshold = t;
+            options.closeSize = k;
+            options.maxBlobs = SIZE_MAX;
+            options.runLength = true;
+            BlobExtractor extractor(options);
+            const vector<Rect>& actual = extractor.extract(gray);
+            referenceBlobs(gray, options, thresh, expected);
+            if (actual != expected) {
+                ++bad;
+                cerr << "❌ " << where << " threshold " << t << " close " << k << " | OpenCV " << expected.size()
+                     << " blobs vs extractor " << actual.size() << endl;
+            }
+        }
+    }
+    return bad;
+}
+
+// 随机方块，其中一部分画成带洞的环并在洞里再放一个小方块
+static Mat syntheticBlocks(RNG& rng) {
+    Mat img(rng.uniform(8, 160), rng.uniform(8, 160), CV_8UC1, Scalar(0));
+    const int blocks = rng.uniform(1, 12);
+    for (int i = 0; i < blocks; ++i) {
+        const int w = rng.uniform(1, img.cols + 1), h = rng.uniform(1, img.rows + 1);
+        const Rect r(rng.uniform(0, img.cols - w + 1), rng.uniform(0, img.rows - h + 1), w, h);
+        img(r).setTo(Scalar(255));
+        if (w > 10 && h > 10 && rng.uniform(0, 2)) {
+            img(Rect(r.x + 3, r.y + 3, w - 6, h - 6)).setTo(Scalar(0));
+            img(Rect(r.x + w / 2 - 1, r.y + h / 2 - 1, 2, 2)).setTo(Scalar(255));
+        }
+    }
+    return img;
+}
+
+int main(int argc, char** argv) {
+    string imageRoot = argc > 1 ? argv[1] : "../img";
+
+    vector<string> sequences;
+    for (const auto& entry : fs::directory_iterator(imageRoot)) {
+        if (entry.is_directory() && entry.path().filename().string().rfind("video_", 0) == 0) {
+            sequences.push_back(entry.path().string());
+        }
+    }
+    sort(sequences.begin(), sequences.end());
+
+    int mismatches = 0;
+    setNumThreads(1);  // 计时比较单线程；BlobExtractor 本身也是单线程
+    for (const auto& seq : sequences) {
+        size_t frames = 0;
+        int bad = 0;
+        double referenceMs = 0, extractorMs = 0;
+        BlobExtractorOptions timed;  // 检测器的默认设置，只把游程实现打开
+        timed.runLength = true;
+        BlobExtractor extractor(timed);
+        Mat thresh;
+        vector<Rect> expected;
+        for (const auto& path : getSortedImagePaths(seq)) {
+            Mat gray = imread(path, IMREAD_GRAYSCALE);
+            if (gray.empty()) continue;
+            ++frames;
+            bad += compareImage(gray, path);
+
+            auto t0 = chrono::steady_clock::now();
+            referenceBlobs(gray, BlobExtractorOptions(), thresh, expected);
+            auto t1 = chrono::steady_clock::now();
+            extractor.extract(gray);
+            auto t2 = chrono::steady_clock::now();
+            referenceMs += chrono::duration<double, milli>(t1 - t0).count();
+            extractorMs += chrono::duration<double, milli>(t2 - t1).count();
+        }
+        mismatches += bad;
+        cout << (bad ? "❌ " : "✅ ") << fs::path(seq).filename().string() << " | Frames: " << frames
+             << " | Mismatches: " << bad;
+        if (frames > 0) {
+            cout << fixed << setprecision(3) << " | OpenCV " << referenceMs / frames << " ms vs extractor "
+                 << extractorMs / frames << " ms (" << setprecision(2)
+                 << (extractorMs > 0 ? referenceMs / extractorMs : 0.0) << "x)";
+        }
+        cout << endl;
+    }
+
+    RNG rng(0xb10b);
+    int bad = 0;
+    for (int i = 0; i < SYNTHETIC_IMAGES; ++i) {
+        Mat noise(rng.uniform(1, 120), rng.uniform(1, 120), CV_8UC1);
+        rng.fill(noise, RNG::UNIFORM, 0, 256);
+        bad += compareImage(noise, "noise " + to_string(i));
+        bad += compareImage(syntheticBlocks(rng), "blocks " + to_string(i));
+    }
+    mismatches += bad;
+    cout << (bad ? "❌ " : "✅ ") << "synthetic | Images: " << 2 * SYNTHETIC_IMAGES << " | Mismatches: " << bad
+         << endl;
+
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,134 @@
+// 在 img/video_0* 上逐帧比较 HaarDetector（编译后的级联）与 cv::CascadeClassifier 的检测结果，
+// 以及 HaarEnsemble 中每个级联的结果与单独用 HaarDetector 检测的结果。不论 HAAR_FAST_KERNELS 是否打开都显式
+// 选用编译后的级联；全部一致（返回 0）之后才可以打开该选项，让检测器用它代替 CascadeClassifier
+// 用法：verify_compiled_cascade [图片根目录] [级联 XML...]
+#include <opencv2/opencv.hpp>
+#include <filesystem>
+#include <iostream>
+#include <tuple>
+
+#include "frame_pipeline.h"
+#include "haar_detector.h"
+#include "haar_ensemble.h"
+
+namespace fs = std::filesystem;
+using namespace cv;
+using namespace std;
+using namespace haar;
+
+struct DetectParams {
+    const char* name;
+    double scaleFactor;
+    int minNeighbors;
+    Size minSize, maxSize;
+};
+
+// 与各检测程序中的 detectMultiScale 调用保持一致
+const DetectParams PARAMS[] = {
+    {"haar_roi", 1.1, 3, Size(40, 40), Size()},
+    {"haar_threshold", 1.1, 5, Size(80, 60), Size(160, 120)},
+};
+
+static void sortRects(vector<Rect>& rects) {
+    sort(rects.begin(), rects.end(), [](const Rect& a, const Rect& b) {
+        return tie(a.y, a.x, a.width, a.height) < tie(b.y, b.x, b.width, b.height);
+    });
+}
+
+int main(int argc, char** argv) {
+    string imageRoot = argc > 1 ? argv[1] : "../img";
+    vector<string> cascades;
+    for (int i = 2; i < argc; ++i) cascades.push_back(argv[i]);
+    if (cascades.empty()) {
+        cascades = {"../haarcascade_drone.xml", "../haarcascade_drone2.xml",
+                    "../haarcascade_drone3.xml", "../haarcascade_drone4.xml"};
+    }
+
+    vector<string> sequences;
+    for (const auto& entry : fs::directory_iterator(imageRoot)) {
+        if (entry.is_directory() && entry.path().filename().string().rfind("video_", 0) == 0) {
+            sequences.push_back(entry.path().string());
+        }
+    }
+    sort(sequences.begin(), sequences.end());
+
+    int mismatches = 0;
+    for (const auto& cascadePath : cascades) {
+        CascadeClassifier reference;
+        HaarDetector compiled;
+        if (!reference.load(cascadePath) || !compiled.load(cascadePath, true)) {
+            cerr << "❌ Failed to load Haar classifier: " << cascadePath << endl;
+            return -1;
+        }
+        if (!compiled.isCompiled()) {
+            cerr << "⚠️ " << cascadePath << " is not compiled into this build, skipped" << endl;
+            continue;
+        }
+
+        for (const auto& seq : sequences) {
+            size_t frames = 0, boxes = 0, bad = 0;
+            for (const auto& path : getSortedImagePaths(seq)) {
+                Mat gray = imread(path, IMREAD_GRAYSCALE);
+                if (gray.empty()) continue;
+                ++frames;
+
+                for (const auto& p : PARAMS) {
+                    vector<Rect> expected, actual;
+                    reference.detectMultiScale(gray, expected, p.scaleFactor, p.minNeighbors, 0, p.minSize, p.maxSize);
+                    compiled.detectMultiScale(gray, actual, p.scaleFactor, p.minNeighbors, 0, p.minSize, p.maxSize);
+                    sortRects(expected);
+                    sortRects(actual);
+                    boxes += expected.size();
+                    if (expected != actual) {
+                        ++bad;
+                        cerr << "❌ " << fs::path(cascadePath).filename().string() << " " << p.name << " "
+                             << path << " | OpenCV " << expected.size() << " vs compiled " << actual.size() << endl;
+                    }
+                }
+            }
+            mismatches += static_cast<int>(bad);
+            cout << (bad ? "❌ " : "✅ ") << fs::path(cascadePath).filename().string() << " [" << compiled.backend()
+                 << "] " << fs::path(seq).filename().string() << " | Frames: " << frames
+                 << " | Boxes: " << boxes << " | Mismatches: " << bad << endl;
+        }
+    }
+
+    // 集成检测共用缩放层并合并扫描，每个级联分组后的结果应与单独检测逐一相同
+    HaarEnsemble ensemble;
+    if (!ensemble.load(cascades, true)) {
+        cerr << "❌ Failed to load Haar classifiers into the ensemble" << endl;
+        return -1;
+    }
+    vector<HaarDetector> singles(cascades.size());
+    for (size_t c = 0; c < cascades.size(); ++c) singles[c].load(cascades[c], true);
+
+    for (const auto& seq : sequences) {
+        size_t frames = 0, bad = 0;
+        for (const auto& path : getSortedImagePaths(seq)) {
+            Mat gray = imread(path, IMREAD_GRAYSCALE);
+            if (gray.empty()) continue;
+            ++frames;
+
+            for (const auto& p : PARAMS) {
+                vector<Rect> fused;
+                ensemble.detectMultiScale(gray, fused, p.scaleFactor, p.minNeighbors, p.minSize, p.maxSize);
+                for (size_t c = 0; c < cascades.size(); ++c) {
+                    vector<Rect> expected, actual = ensemble.lastDetections(c);
+                    singles[c].detectMultiScale(gray, expected, p.scaleFactor, p.minNeighbors, 0, p.minSize, p.maxSize);
+                    sortRects(expected);
+                    sortRects(actual);
+                    if (expected != actual) {
+                        ++bad;
+                        cerr << "❌ ensemble " << fs::path(cascades[c]).filename().string() << " " << p.name << " "
+                             << path << " | single " << expected.size() << " vs ensemble " << actual.size() << endl;
+                    }
+                }
+            }
+        }
+        mismatches += static_cast<int>(bad);
+        cout << (bad ? "❌ " : "✅ ") << "ensemble of " << ensemble.size() << " [" << ensemble.backend() << "] "
+             << fs::path(seq).filename().string() << " | Frames: " << frames << " | Mismatches: " << bad << endl;
+    }
+
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,149 @@
+// 在 img/video_0* 上逐帧比较 SquareDetector 与原来的“整帧 GaussianBlur → 裁 ROI → Canny → 轮廓”流程：
+// 梯度与 Sobel(模糊后的 ROI, BORDER_REPLICATE) 逐位比对，边缘图与 Canny(模糊后的 ROI) 逐位比对，
+// 最终的方框与原流程比对。每帧查整帧、贴边与随机的 ROI，另外查 1x1 ~ 7x7 的随机小图。
+// 不论 HAAR_FAST_KERNELS 是否打开都显式选用融合实现；全部一致（返回 0）之后才可以打开该选项
+// 用法：verify_square_detector [图片根目录]
+#include <opencv2/opencv.hpp>
+#include <filesystem>
+#include <iostream>
+
+#include "frame_pipeline.h"
+#include "square_detector.h"
+
+namespace fs = std::filesystem;
+using namespace cv;
+using namespace std;
+using namespace haar;
+
+const int RANDOM_ROIS = 8;  // 每帧另查几个随机 ROI
+const int TINY_SIZE = 7;    // 小图边长上限
+const int TINY_REPEATS = 4;
+
+// 改动前 detect.cpp 的做法
+static bool referenceSquare(const Mat& blurred, Rect roi, const SquareDetectorOptions& o, Rect& best) {
+    Mat edges;
+    Canny(blurred(roi), edges, o.cannyLow, o.cannyHigh);
+    vector<vector<Point>> contours;
+    findContours(edges, contours, RETR_EXTERNAL, CHAIN_APPROX_SIMPLE);
+    double score = 0;
+    vector<Point> approx;
+    for (const auto& cnt : contours) {
+        approxPolyDP(cnt, approx, arcLength(cnt, true) * o.approxEpsilon, true);
+        if (approx.size() != 4 || !isContourConvex(approx)) continue;
+        Rect box = boundingRect(approx);
+        box.x += roi.x;
+        box.y += roi.y;
+        float aspectRatio = (float)box.width / box.height;
+        float area = box.area();
+        if (aspectRatio > o.minAspect && aspectRatio < o.maxAspect && area > o.minArea && area < o.maxArea &&
+            area > score) {
+            score = area;
+            best = box;
+        }
+    }
+    return score > 0;
+}
+
+static bool same(const Mat& a, const Mat& b) {
+    return a.size() == b.size() && a.type() == b.type() && norm(a, b, NORM_INF) == 0;
+}
+
+// 一幅图的一个 ROI：梯度、边缘、方框三项，不一致的项写到 cerr
+static int compareRoi(SquareDetector& detector, const SquareDetectorOptions& options, const Mat& gray,
+                      const Mat& blurred, Rect roi, const string& where) {
+    int bad = 0;
+    Mat dx, dy, rdx, rdy;
+    detector.gradients(gray, roi, dx, dy);
+    const Mat crop = blurred(roi).clone();  // Canny 把 ROI 当独立图像求梯度
+    Sobel(crop, rdx, CV_16S, 1, 0, 3, 1, 0, BORDER_REPLICATE);
+    Sobel(crop, rdy, CV_16S, 0, 1, 3, 1, 0, BORDER_REPLICATE);
+    if (!same(dx, rdx) || !same(dy, rdy)) {
+        ++bad;
+        cerr << "❌ gradients " << where << " roi " << roi << endl;
+    }
+
+    Mat edges, expectedEdges;
+    Canny(dx, dy, edges, options.cannyLow, options.cannyHigh);
+    Canny(blurred(roi), expectedEdges, options.cannyLow, options.cannyHigh);
+    if (!same(edges, expectedEdges)) {
+        ++bad;
+        cerr << "❌ edges " << where << " roi " << roi << endl;
+    }
+
+    Rect box, expected;
+    double score = 0;
+    const bool found = detector.detect(gray, roi, box, score);
+    const bool expectedFound = referenceSquare(blurred, roi, options, expected);
+    if (found != expectedFound || (found && box != expected)) {
+        ++bad;
+        cerr << "❌ box " << where << " roi " << roi << " | OpenCV " << (expectedFound ? expected : Rect())
+             << " vs detector " << (found ? box : Rect()) << endl;
+    }
+    return bad;
+}
+
+int main(int argc, char** argv) {
+    string imageRoot = argc > 1 ? argv[1] : "../img";
+
+    vector<string> sequences;
+    for (const auto& entry : fs::directory_iterator(imageRoot)) {
+        if (entry.is_directory() && entry.path().filename().string().rfind("video_", 0) == 0) {
+            sequences.push_back(entry.path().string());
+        }
+    }
+    sort(sequences.begin(), sequences.end());
+
+    SquareDetectorOptions options;
+    options.fused = true;
+    SquareDetector detector(options);
+    RNG rng(0x5eed);
+    int mismatches = 0;
+
+    for (const auto& seq : sequences) {
+        size_t frames = 0, rois = 0;
+        int bad = 0;
+        Mat blurred;
+        for (const auto& path : getSortedImagePaths(seq)) {
+            Mat gray = imread(path, IMREAD_GRAYSCALE);
+            if (gray.empty()) continue;
+            ++frames;
+            GaussianBlur(gray, blurred, Size(5, 5), 1.5);
+
+            // 整帧、四角贴边（模糊核读到帧外要反射），再加几个随机大小与位置的
+            vector<Rect> candidates = {Rect(0, 0, gray.cols, gray.rows), Rect(0, 0, 120, 90),
+                                       Rect(gray.cols - 121, gray.rows - 91, 121, 91), Rect(1, 1, 3, 3)};
+            for (int i = 0; i < RANDOM_ROIS; ++i) {
+                const int w = rng.uniform(1, gray.cols + 1), h = rng.uniform(1, gray.rows + 1);
+                candidates.emplace_back(rng.uniform(0, gray.cols - w + 1), rng.uniform(0, gray.rows - h + 1), w, h);
+            }
+            for (Rect roi : candidates) {
+                roi &= Rect(0, 0, gray.cols, gray.rows);
+                if (roi.empty()) continue;
+                ++rois;
+                bad += compareRoi(detector, options, gray, blurred, roi, path);
+            }
+        }
+        mismatches += bad;
+        cout << (bad ? "❌ " : "✅ ") << fs::path(seq).filename().string() << " | Frames: " << frames
+             << " | ROIs: " << rois << " | Mismatches: " << bad << endl;
+    }
+
+    // 退化的小图：模糊核与 Sobel 的边界处理全部叠在一起
+    int bad = 0;
+    size_t images = 0;
+    for (int h = 1; h <= TINY_SIZE; ++h) {
+        for (int w = 1; w <= TINY_SIZE; ++w) {
+            for (int r = 0; r < TINY_REPEATS; ++r) {
+                Mat gray(h, w, CV_8UC1), blurred;
+                rng.fill(gray, RNG::UNIFORM, 0, 256);
+                GaussianBlur(gray, blurred, Size(5, 5), 1.5);
+                ++images;
+                bad += compareRoi(detector, options, gray, blurred, Rect(0, 0, w, h), "tiny");
+            }
+        }
+    }
+    mismatches += bad;
+    cout << (bad ? "❌ " : "✅ ") << "tiny images | Images: " << images << " | Mismatches: " << bad << endl;
+
+    return mismatches == 0 ? 0 : 1;
+}
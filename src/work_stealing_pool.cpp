@@ -0,0 +1,214 @@
+#include "work_stealing_pool.h"
+#include "trace.h"
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <utility>
+
+using namespace std;
+
+namespace haar {
+
+namespace {
+
+// 当前线程所属的池和队列下标；池外线程为 nullptr
+thread_local const WorkStealingPool* tlsPool = nullptr;
+thread_local size_t tlsIndex = 0;
+
+bool popBack(deque<WorkStealingPool::Task>& q, WorkStealingPool::Task& task) {
+    if (q.empty()) return false;
+    task = std::move(q.back());
+    q.pop_back();
+    return true;
+}
+
+bool popFront(deque<WorkStealingPool::Task>& q, WorkStealingPool::Task& task) {
+    if (q.empty()) return false;
+    task = std::move(q.front());
+    q.pop_front();
+    return true;
+}
+
+}  // namespace
+
+WorkStealingPool::WorkStealingPool(int threads) {
+    if (threads <= 0) threads = max(1, static_cast<int>(thread::hardware_concurrency()));
+    for (int t = 0; t <= threads; ++t) queues_.emplace_back(new TaskQueue);
+    for (int t = 0; t < threads; ++t) {
+        threads_.emplace_back([this, t] { workerLoop(static_cast<size_t>(t)); });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        lock_guard<mutex> lock(stateMutex_);
+        stopping_ = true;
+        ++generation_;
+    }
+    changed_.notify_all();
+    for (auto& t : threads_) t.join();
+}
+
+size_t WorkStealingPool::localIndex() const {
+    return tlsPool == this ? tlsIndex : queues_.size() - 1;
+}
+
+void WorkStealingPool::signal() {
+    {
+        lock_guard<mutex> lock(stateMutex_);
+        ++generation_;
+    }
+    changed_.notify_all();
+}
+
+void WorkStealingPool::submitRoot(Task task) {
+    {
+        lock_guard<mutex> lock(stateMutex_);
+        ++outstanding_;
+    }
+    {
+        lock_guard<mutex> lock(roots_.mutex);
+        roots_.tasks.push_back(std::move(task));
+    }
+    signal();
+}
+
+void WorkStealingPool::submit(Task task) {
+    {
+        lock_guard<mutex> lock(stateMutex_);
+        ++outstanding_;
+    }
+    TaskQueue& q = *queues_[localIndex()];
+    {
+        lock_guard<mutex> lock(q.mutex);
+        q.tasks.push_back(std::move(task));
+    }
+    signal();
+}
+
+bool WorkStealingPool::takeTask(Task& task) {
+    const size_t self = localIndex();
+    {
+        TaskQueue& q = *queues_[self];
+        lock_guard<mutex> lock(q.mutex);
+        if (popBack(q.tasks, task)) return true;
+    }
+    for (size_t k = 1; k < queues_.size(); ++k) {
+        TaskQueue& victim = *queues_[(self + k) % queues_.size()];
+        lock_guard<mutex> lock(victim.mutex);
+        if (popFront(victim.tasks, task)) return true;
+    }
+    return false;
+}
+
+bool WorkStealingPool::takeRoot(Task& task) {
+    lock_guard<mutex> lock(roots_.mutex);
+    return popFront(roots_.tasks, task);
+}
+
+void WorkStealingPool::execute(Task& task) {
+    try {
+        task();
+    } catch (...) {
+        lock_guard<mutex> lock(stateMutex_);
+        if (!error_) error_ = current_exception();
+    }
+    task = nullptr;
+    {
+        lock_guard<mutex> lock(stateMutex_);
+        --outstanding_;
+        ++generation_;
+    }
+    changed_.notify_all();
+}
+
+void WorkStealingPool::workerLoop(size_t index) {
+    tlsPool = this;
+    tlsIndex = index;
+    trace::setThreadName("worker " + to_string(index));
+    for (;;) {
+        size_t seen;
+        {
+            lock_guard<mutex> lock(stateMutex_);
+            if (stopping_ && outstanding_ == 0) return;
+            seen = generation_;
+        }
+        // 细粒度任务优先，让已开始的序列尽快流动，再去开新序列
+        Task task;
+        if (takeTask(task) || takeRoot(task)) {
+            execute(task);
+            continue;
+        }
+        unique_lock<mutex> lock(stateMutex_);
+        changed_.wait(lock, [&] { return generation_ != seen; });
+    }
+}
+
+void WorkStealingPool::helpUntil(const function<bool()>& done) {
+    for (;;) {
+        size_t seen;
+        {
+            lock_guard<mutex> lock(stateMutex_);
+            seen = generation_;
+        }
+        if (done()) return;
+        Task task;
+        if (takeTask(task)) {
+            execute(task);
+            continue;
+        }
+        unique_lock<mutex> lock(stateMutex_);
+        changed_.wait(lock, [&] { return generation_ != seen; });
+    }
+}
+
+void WorkStealingPool::wait() {
+    helpUntil([this] {
+        lock_guard<mutex> lock(stateMutex_);
+        return outstanding_ == 0;
+    });
+    exception_ptr error;
+    {
+        lock_guard<mutex> lock(stateMutex_);
+        std::swap(error, error_);
+    }
+    if (error) rethrow_exception(error);
+}
+
+void parallelFor(WorkStealingPool* pool, size_t n, const function<void(size_t)>& body) {
+    if (n == 0) return;
+    if (n == 1) {
+        body(0);
+        return;
+    }
+    if (!pool) {
+        cv::parallel_for_(cv::Range(0, static_cast<int>(n)), [&](const cv::Range& r) {
+            for (int i = r.start; i < r.end; ++i) body(static_cast<size_t>(i));
+        });
+        return;
+    }
+
+    // 0 号留给调用线程，其余提交到池里；异常先收住，免得推迟到 pool.wait() 才抛出
+    atomic<size_t> pending{n - 1};
+    mutex errorMutex;
+    exception_ptr error;
+    auto run = [&](size_t i) {
+        try {
+            body(i);
+        } catch (...) {
+            lock_guard<mutex> lock(errorMutex);
+            if (!error) error = current_exception();
+        }
+    };
+    for (size_t i = 1; i < n; ++i) {
+        pool->submit([&, i] {
+            run(i);
+            --pending;
+        });
+    }
+    run(0);
+    pool->helpUntil([&] { return pending.load() == 0; });
+    if (error) rethrow_exception(error);
+}
+
+}  // namespace haar